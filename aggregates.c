@@ -1,280 +1,309 @@
 #include <postgres.h>
 #include <fmgr.h>
-#include <utils/array.h>
+#include <libpq/pqformat.h>
+#if PG_VERSION_NUM >= 160000
+#include <varatt.h>
+#endif
 
 #include "uint.h"
 #include "unumeric.h"
 
-#define make_sum_func(argtype, ARGTYPE, RETTYPE) \
+/*
+ * sum raises "integer out of range" like int4pl and int8pl, also in the
+ * combine and moving-aggregate functions, so every plan agrees
+ */
+#define make_sum_func(argtype, ARGTYPE, RETTYPE, rettype) \
 PG_FUNCTION_INFO_V1(argtype##_sum); \
 Datum \
 argtype##_sum(PG_FUNCTION_ARGS) \
 { \
+	rettype		result; \
+\
 	if (PG_ARGISNULL(0) && PG_ARGISNULL(1)) \
 		PG_RETURN_NULL(); \
 \
-	PG_RETURN_##RETTYPE((PG_ARGISNULL(0) ? 0 : PG_GETARG_##RETTYPE(0)) + \
-						(PG_ARGISNULL(1) ? 0 : PG_GETARG_##ARGTYPE(1))); \
+	if (unlikely(__builtin_add_overflow(PG_ARGISNULL(0) ? 0 : PG_GETARG_##RETTYPE(0), \
+										PG_ARGISNULL(1) ? 0 : PG_GETARG_##ARGTYPE(1), \
+										&result))) \
+		uint_out_of_range_error(); \
+	PG_RETURN_##RETTYPE(result); \
 } \
 extern int no_such_variable
 
-make_sum_func(int1, INT8, INT32);
-make_sum_func(uint1, UINT8, UINT32);
-make_sum_func(uint2, UINT16, UINT64);
-make_sum_func(uint4, UINT32, UINT64);
-make_sum_func(uint8, UINT64, UINT64);
-
-
-typedef struct Int8TransTypeData
-{
-	int64		count;
-	int64		sum;
-} Int8TransTypeData;
+make_sum_func(int1, INT8, INT32, int32);
+make_sum_func(uint1, UINT8, UINT32, uint32);
+make_sum_func(uint2, UINT16, UINT64, uint64);
+make_sum_func(uint4, UINT32, UINT64, uint64);
+make_sum_func(uint8, UINT64, UINT64, uint64);
 
-#define make_avg_func(argtype, ARGTYPE) \
-PG_FUNCTION_INFO_V1(argtype##_avg_accum); \
+#define make_sum_func128(argtype, ctype, itype) \
+PG_FUNCTION_INFO_V1(argtype##_sum); \
 Datum \
-argtype##_avg_accum(PG_FUNCTION_ARGS) \
+argtype##_sum(PG_FUNCTION_ARGS) \
 { \
-	ArrayType  *transarray; \
-	Int8TransTypeData *transdata; \
-\
-	transarray = (AggCheckCallContext(fcinfo, NULL)) \
-		? PG_GETARG_ARRAYTYPE_P(0) \
-		: PG_GETARG_ARRAYTYPE_P_COPY(0); \
-\
-	if (ARR_HASNULL(transarray) || \
-		ARR_SIZE(transarray) != ARR_OVERHEAD_NONULLS(1) + sizeof(Int8TransTypeData)) \
-		elog(ERROR, "expected 2-element int8 array"); \
-\
-	transdata = (Int8TransTypeData *) ARR_DATA_PTR(transarray); \
-	transdata->count++; \
-	transdata->sum += PG_GETARG_##ARGTYPE(1); \
-\
-	PG_RETURN_ARRAYTYPE_P(transarray); \
+	if (unlikely(PG_ARGISNULL(0))) { \
+		if (unlikely(PG_ARGISNULL(1))) PG_RETURN_NULL(); \
+		PG_RETURN_POINTER(PG_GETARG_POINTER(1)); \
+	} \
+	if (unlikely(PG_ARGISNULL(1))) PG_RETURN_POINTER(PG_GETARG_POINTER(0)); \
+	{ \
+		ctype *l = (ctype *)PG_GETARG_POINTER(0); \
+		ctype *r = (ctype *)PG_GETARG_POINTER(1); \
+		itype sum; \
+		if (unlikely(__builtin_add_overflow(l->i, r->i, &sum))) \
+			uint_out_of_range_error(); \
+		if (AggCheckCallContext(fcinfo, NULL)) { \
+		  l->i = sum; \
+		  PG_RETURN_POINTER(l); \
+		} else { \
+		  ctype *v = (ctype *)palloc(sizeof(ctype)); \
+		  v->i = sum; \
+		  PG_RETURN_POINTER(v); \
+		} \
+	} \
 } \
 extern int no_such_variable
 
-make_avg_func(int1, INT8);
-make_avg_func(uint1, UINT8);
-make_avg_func(uint2, UINT16);
-make_avg_func(uint4, UINT32);
+make_sum_func128(int16, xint128, __int128_t);
+make_sum_func128(uint16, xuint128, __uint128_t);
 
-PG_FUNCTION_INFO_V1(int16_sum);
-Datum
-int16_sum(PG_FUNCTION_ARGS)
+/*
+ * avg state shared by every type: a 192-bit two's complement sum, so even
+ * 2^63 int16/uint16 values cannot overflow it, and the count
+ */
+#pragma pack(push, 8)
+typedef struct AvgState
 {
-	if (unlikely(PG_ARGISNULL(0))) {
-		if (unlikely(PG_ARGISNULL(1))) PG_RETURN_NULL();
-		PG_RETURN_POINTER(PG_GETARG_POINTER(1));
-	}
-	if (unlikely(PG_ARGISNULL(1))) PG_RETURN_POINTER(PG_GETARG_POINTER(0));
-	{
-		xint128 *l = (xint128 *)PG_GETARG_POINTER(0);
-		xint128 *r = (xint128 *)PG_GETARG_POINTER(1);
-		if (AggCheckCallContext(fcinfo, NULL)) {
-		  l->i += r->i;
-		  PG_RETURN_POINTER(l);
-		} else {
-		  xint128 *v = (xint128 *)palloc(sizeof(xint128));
-		  v->i = l->i + r->i;
-		  PG_RETURN_POINTER(v);
-		}
-	}
+	__uint128_t	sum;		/* low 128 bits */
+	int64		sum_hi;		/* high 64 bits */
+	uint64		count;
+} AvgState;
+#pragma pack(pop)
+
+static AvgState *
+avg_state_(FunctionCallInfo fcinfo)
+{
+	MemoryContext aggcontext;
+
+	if (!AggCheckCallContext(fcinfo, &aggcontext))
+		elog(ERROR, "aggregate function called in non-aggregate context");
+	if (!PG_ARGISNULL(0))
+		return (AvgState *)PG_GETARG_POINTER(0);
+	return (AvgState *)MemoryContextAllocZero(aggcontext, sizeof(AvgState));
 }
 
-PG_FUNCTION_INFO_V1(uint16_sum);
-Datum
-uint16_sum(PG_FUNCTION_ARGS)
+static inline void
+avg_add_(AvgState *state, __int128_t v)
 {
-	if (unlikely(PG_ARGISNULL(0))) {
-		if (unlikely(PG_ARGISNULL(1))) PG_RETURN_NULL();
-		PG_RETURN_POINTER(PG_GETARG_POINTER(1));
-	}
-	if (unlikely(PG_ARGISNULL(1))) PG_RETURN_POINTER(PG_GETARG_POINTER(0));
-	{
-		xuint128 *l = (xuint128 *)PG_GETARG_POINTER(0);
-		xuint128 *r = (xuint128 *)PG_GETARG_POINTER(1);
-		if (AggCheckCallContext(fcinfo, NULL)) {
-		  l->i += r->i;
-		  PG_RETURN_POINTER(l);
-		} else {
-		  xuint128 *v = (xuint128 *)palloc(sizeof(xuint128));
-		  v->i = l->i + r->i;
-		  PG_RETURN_POINTER(v);
-		}
-	}
+	__uint128_t old = state->sum;
+	state->sum += (__uint128_t)v;
+	state->sum_hi += (state->sum < old) - (v < 0);
+	++state->count;
 }
 
-/* missing */
-#ifndef PG_GETARG_UINT64
-#define PG_GETARG_UINT64(n)  DatumGetUInt64(PG_GETARG_DATUM(n))
-#endif
-
-PG_FUNCTION_INFO_V1(uint8_avg_accum);
-Datum uint8_avg_accum(PG_FUNCTION_ARGS) {
-	ArrayType *array = AggCheckCallContext(fcinfo, NULL) ?
-		PG_GETARG_ARRAYTYPE_P(0) :
-		PG_GETARG_ARRAYTYPE_P_COPY(0);
-	uint64 *state;
-	uint64 v;
-
-	if (ARR_NDIM(array) != 1 ||
-		ARR_DIMS(array)[0] != 2 ||
-		ARR_HASNULL(array) ||
-		ARR_SIZE(array) != ARR_OVERHEAD_NONULLS(1) + sizeof(uint64) * 2) {
-		elog(ERROR, "uint8_avg_accum expected 2-element uint8 array");
-		PG_RETURN_ARRAYTYPE_P(array);
-	}
-
-	if (PG_ARGISNULL(1)) PG_RETURN_ARRAYTYPE_P(array);
-
-	state = (uint64 *)ARR_DATA_PTR(array);
-	v = PG_GETARG_UINT64(1);
-
-	state[0] += v;
-	++state[1];
-
-	PG_RETURN_ARRAYTYPE_P(array);
+static inline void
+avg_add_unsigned_(AvgState *state, __uint128_t v)
+{
+	state->sum += v;
+	state->sum_hi += state->sum < v;
+	++state->count;
 }
 
-PG_FUNCTION_INFO_V1(uint8_avg);
-Datum uint8_avg(PG_FUNCTION_ARGS) {
-	ArrayType *array = AggCheckCallContext(fcinfo, NULL) ?
-		PG_GETARG_ARRAYTYPE_P(0) :
-		PG_GETARG_ARRAYTYPE_P_COPY(0);
-	const uint64 *state;
-	Numeric sum, count, result;
-
-	if (ARR_NDIM(array) != 1 ||
-		ARR_DIMS(array)[0] != 2 ||
-		ARR_HASNULL(array) ||
-		ARR_SIZE(array) != ARR_OVERHEAD_NONULLS(1) + sizeof(uint64) * 2) {
-		elog(ERROR, "uint8_avg expected 2-element uint8 array");
-		PG_RETURN_NULL();
-	}
-
-	state = (const uint64 *)ARR_DATA_PTR(array);
-
-	if (unlikely(!state[1])) PG_RETURN_NULL();
-
-	sum = uint64_to_numeric(state[0]);
-	count = uint64_to_numeric(state[1]);
-	result = numeric_div_opt_error(sum, count, NULL);
-	pfree(sum);
-	pfree(count);
-
-	PG_RETURN_DATUM(NumericGetDatum(result));
+/* inverse transitions, for moving-aggregate window frames */
+static inline void
+avg_sub_(AvgState *state, __int128_t v)
+{
+	__uint128_t old = state->sum;
+	state->sum -= (__uint128_t)v;
+	state->sum_hi -= (state->sum > old) - (v < 0);
+	--state->count;
 }
 
-PG_FUNCTION_INFO_V1(int16_avg_accum);
-Datum int16_avg_accum(PG_FUNCTION_ARGS) {
-	ArrayType *array = AggCheckCallContext(fcinfo, NULL) ?
-		PG_GETARG_ARRAYTYPE_P(0) :
-		PG_GETARG_ARRAYTYPE_P_COPY(0);
-	xint128 *state;
-	xint128 *v;
-
-	if (ARR_NDIM(array) != 1 ||
-		ARR_DIMS(array)[0] != 2 ||
-		ARR_HASNULL(array) ||
-		ARR_SIZE(array) != ARR_OVERHEAD_NONULLS(1) + sizeof(xint128) * 2) {
-		elog(ERROR, "int16_avg_accum expected 2-element int16 array");
-		PG_RETURN_ARRAYTYPE_P(array);
-	}
-
-	if (PG_ARGISNULL(1)) PG_RETURN_ARRAYTYPE_P(array);
-
-	state = (xint128 *)ARR_DATA_PTR(array);
-	v = (xint128 *)PG_GETARG_POINTER(1);
-
-	state[0].i += v->i;
-	++state[1].i;
-
-	PG_RETURN_ARRAYTYPE_P(array);
+static inline void
+avg_sub_unsigned_(AvgState *state, __uint128_t v)
+{
+	__uint128_t old = state->sum;
+	state->sum -= v;
+	state->sum_hi -= state->sum > old;
+	--state->count;
 }
 
-PG_FUNCTION_INFO_V1(int16_avg);
-Datum int16_avg(PG_FUNCTION_ARGS) {
-	ArrayType *array = AggCheckCallContext(fcinfo, NULL) ?
-		PG_GETARG_ARRAYTYPE_P(0) :
-		PG_GETARG_ARRAYTYPE_P_COPY(0);
-	const xint128 *state;
-	Numeric sum, count, result;
-
-	if (ARR_NDIM(array) != 1 ||
-		ARR_DIMS(array)[0] != 2 ||
-		ARR_HASNULL(array) ||
-		ARR_SIZE(array) != ARR_OVERHEAD_NONULLS(1) + sizeof(xint128) * 2) {
-		elog(ERROR, "int16_avg expected 2-element int16 array");
-		PG_RETURN_NULL();
-	}
+#define PG_GETARG_INT128_(n)	(((const xint128 *)PG_GETARG_POINTER(n))->i)
+#define PG_GETARG_UINT128_(n)	(((const xuint128 *)PG_GETARG_POINTER(n))->i)
+
+#define make_avg_func(argtype, GETARG, add, sub) \
+PG_FUNCTION_INFO_V1(argtype##_avg_accum); \
+Datum \
+argtype##_avg_accum(PG_FUNCTION_ARGS) \
+{ \
+	AvgState   *state = avg_state_(fcinfo); \
+\
+	if (!PG_ARGISNULL(1)) \
+		add(state, GETARG(1)); \
+	PG_RETURN_POINTER(state); \
+} \
+\
+PG_FUNCTION_INFO_V1(argtype##_avg_accum_inv); \
+Datum \
+argtype##_avg_accum_inv(PG_FUNCTION_ARGS) \
+{ \
+	AvgState   *state = avg_state_(fcinfo); \
+\
+	if (!PG_ARGISNULL(1)) \
+		sub(state, GETARG(1)); \
+	PG_RETURN_POINTER(state); \
+} \
+extern int no_such_variable
 
-	state = (const xint128 *)ARR_DATA_PTR(array);
+make_avg_func(int1, PG_GETARG_INT8, avg_add_, avg_sub_);
+make_avg_func(uint1, PG_GETARG_UINT8, avg_add_unsigned_, avg_sub_unsigned_);
+make_avg_func(uint2, PG_GETARG_UINT16, avg_add_unsigned_, avg_sub_unsigned_);
+make_avg_func(uint4, PG_GETARG_UINT32, avg_add_unsigned_, avg_sub_unsigned_);
+make_avg_func(uint8, PG_GETARG_UINT64, avg_add_unsigned_, avg_sub_unsigned_);
+make_avg_func(int16, PG_GETARG_INT128_, avg_add_, avg_sub_);
+make_avg_func(uint16, PG_GETARG_UINT128_, avg_add_unsigned_, avg_sub_unsigned_);
+
+/*
+ * sum over a moving frame shares the avg state; the 192-bit sum has to
+ * fit the result type, as in SFUNC
+ */
+#define sum_final_overflows_(state, itype, result) \
+	((state)->sum_hi != ((itype)(state)->sum < 0 ? -1 : 0) || \
+	 __builtin_add_overflow((itype)(state)->sum, 0, result))
+
+#define make_sum_final_func(argtype, RETTYPE, rettype, itype) \
+PG_FUNCTION_INFO_V1(argtype##_sum_final); \
+Datum \
+argtype##_sum_final(PG_FUNCTION_ARGS) \
+{ \
+	const AvgState *state; \
+	rettype		result; \
+\
+	if (PG_ARGISNULL(0)) PG_RETURN_NULL(); \
+	state = (const AvgState *)PG_GETARG_POINTER(0); \
+	if (unlikely(!state->count)) PG_RETURN_NULL(); \
+	if (unlikely(sum_final_overflows_(state, itype, &result))) \
+		uint_out_of_range_error(); \
+	PG_RETURN_##RETTYPE(result); \
+} \
+extern int no_such_variable
 
-	if (unlikely(!state[1].i)) PG_RETURN_NULL();
+#define make_sum_final_func128(argtype, ctype, itype) \
+PG_FUNCTION_INFO_V1(argtype##_sum_final); \
+Datum \
+argtype##_sum_final(PG_FUNCTION_ARGS) \
+{ \
+	const AvgState *state; \
+	ctype *result; \
+	itype sum; \
+\
+	if (PG_ARGISNULL(0)) PG_RETURN_NULL(); \
+	state = (const AvgState *)PG_GETARG_POINTER(0); \
+	if (unlikely(!state->count)) PG_RETURN_NULL(); \
+	if (unlikely(sum_final_overflows_(state, itype, &sum))) \
+		uint_out_of_range_error(); \
+	result = (ctype *)palloc(sizeof(ctype)); \
+	result->i = sum; \
+	PG_RETURN_POINTER(result); \
+} \
+extern int no_such_variable
 
-	sum = int128_to_numeric(state[0].i);
-	count = int128_to_numeric(state[1].i);
-	result = numeric_div_opt_error(sum, count, NULL);
-	pfree(sum);
-	pfree(count);
+make_sum_final_func(int1, INT32, int32, __int128_t);
+make_sum_final_func(uint1, UINT32, uint32, __uint128_t);
+make_sum_final_func(uint2, UINT64, uint64, __uint128_t);
+make_sum_final_func(uint4, UINT64, uint64, __uint128_t);
+make_sum_final_func(uint8, UINT64, uint64, __uint128_t);
+make_sum_final_func128(int16, xint128, __int128_t);
+make_sum_final_func128(uint16, xuint128, __uint128_t);
 
-	PG_RETURN_DATUM(NumericGetDatum(result));
-}
+PG_FUNCTION_INFO_V1(uint_avg_combine);
+Datum
+uint_avg_combine(PG_FUNCTION_ARGS)
+{
+	AvgState *state1;
+	const AvgState *state2;
+	__uint128_t old;
 
-PG_FUNCTION_INFO_V1(uint16_avg_accum);
-Datum uint16_avg_accum(PG_FUNCTION_ARGS) {
-	ArrayType *array = AggCheckCallContext(fcinfo, NULL) ?
-		PG_GETARG_ARRAYTYPE_P(0) :
-		PG_GETARG_ARRAYTYPE_P_COPY(0);
-	xuint128 *state;
-	xuint128 *v;
-
-	if (ARR_NDIM(array) != 1 ||
-		ARR_DIMS(array)[0] != 2 ||
-		ARR_HASNULL(array) ||
-		ARR_SIZE(array) != ARR_OVERHEAD_NONULLS(1) + sizeof(xuint128) * 2) {
-		elog(ERROR, "uint16_avg_accum expected 2-element uint16 array");
-		PG_RETURN_ARRAYTYPE_P(array);
+	if (PG_ARGISNULL(1)) {
+		if (PG_ARGISNULL(0)) PG_RETURN_NULL();
+		PG_RETURN_POINTER(PG_GETARG_POINTER(0));
 	}
+	state1 = avg_state_(fcinfo);
+	state2 = (const AvgState *)PG_GETARG_POINTER(1);
 
-	if (PG_ARGISNULL(1)) PG_RETURN_ARRAYTYPE_P(array);
+	old = state1->sum;
+	state1->sum += state2->sum;
+	state1->sum_hi += state2->sum_hi + (state1->sum < old);
+	state1->count += state2->count;
 
-	state = (xuint128 *)ARR_DATA_PTR(array);
-	v = (xuint128 *)PG_GETARG_POINTER(1);
+	PG_RETURN_POINTER(state1);
+}
 
-	state[0].i += v->i;
-	++state[1].i;
+PG_FUNCTION_INFO_V1(uint_avg_serialize);
+Datum
+uint_avg_serialize(PG_FUNCTION_ARGS)
+{
+	const AvgState *state;
+	StringInfoData buf;
+
+	if (!AggCheckCallContext(fcinfo, NULL))
+		elog(ERROR, "aggregate function called in non-aggregate context");
+	state = (const AvgState *)PG_GETARG_POINTER(0);
+
+	pq_begintypsend(&buf);
+	pq_sendint64(&buf, (uint64)state->sum);
+	pq_sendint64(&buf, (uint64)(state->sum >> 64));
+	pq_sendint64(&buf, state->sum_hi);
+	pq_sendint64(&buf, state->count);
+	PG_RETURN_BYTEA_P(pq_endtypsend(&buf));
+}
 
-	PG_RETURN_ARRAYTYPE_P(array);
+PG_FUNCTION_INFO_V1(uint_avg_deserialize);
+Datum
+uint_avg_deserialize(PG_FUNCTION_ARGS)
+{
+	bytea *sstate;
+	AvgState *state;
+	StringInfoData buf;
+	uint64 lo;
+
+	if (!AggCheckCallContext(fcinfo, NULL))
+		elog(ERROR, "aggregate function called in non-aggregate context");
+	sstate = PG_GETARG_BYTEA_PP(0);
+
+	initStringInfo(&buf);
+	appendBinaryStringInfo(&buf, VARDATA_ANY(sstate), VARSIZE_ANY_EXHDR(sstate));
+
+	state = (AvgState *)palloc(sizeof(AvgState));
+	lo = pq_getmsgint64(&buf);
+	state->sum = (__uint128_t)(uint64)pq_getmsgint64(&buf) << 64 | lo;
+	state->sum_hi = pq_getmsgint64(&buf);
+	state->count = pq_getmsgint64(&buf);
+	pq_getmsgend(&buf);
+	pfree(buf.data);
+
+	PG_RETURN_POINTER(state);
 }
 
-PG_FUNCTION_INFO_V1(uint16_avg);
-Datum uint16_avg(PG_FUNCTION_ARGS) {
-	ArrayType *array = AggCheckCallContext(fcinfo, NULL) ?
-		PG_GETARG_ARRAYTYPE_P(0) :
-		PG_GETARG_ARRAYTYPE_P_COPY(0);
-	const xuint128 *state;
-	Numeric sum, count, result;
-
-	if (ARR_NDIM(array) != 1 ||
-		ARR_DIMS(array)[0] != 2 ||
-		ARR_HASNULL(array) ||
-		ARR_SIZE(array) != ARR_OVERHEAD_NONULLS(1) + sizeof(xuint128) * 2) {
-		elog(ERROR, "uint16_avg expected 2-element uint16 array");
-		PG_RETURN_NULL();
+PG_FUNCTION_INFO_V1(uint_avg_final);
+Datum
+uint_avg_final(PG_FUNCTION_ARGS)
+{
+	const AvgState *state;
+	__uint128_t lo;
+	uint64 hi;
+	bool neg;
+
+	if (PG_ARGISNULL(0)) PG_RETURN_NULL();
+	state = (const AvgState *)PG_GETARG_POINTER(0);
+	if (unlikely(!state->count)) PG_RETURN_NULL();
+
+	lo = state->sum;
+	hi = state->sum_hi;
+	neg = state->sum_hi < 0;
+	if (neg) {
+		lo = ~lo + 1;
+		hi = ~hi + !lo;
 	}
-
-	state = (const xuint128 *)ARR_DATA_PTR(array);
-
-	if (unlikely(!state[1].i)) PG_RETURN_NULL();
-
-	sum = uint128_to_numeric(state[0].i);
-	count = uint128_to_numeric(state[1].i);
-	result = numeric_div_opt_error(sum, count, NULL);
-	pfree(sum);
-	pfree(count);
-
-	PG_RETURN_DATUM(NumericGetDatum(result));
+	PG_RETURN_NUMERIC(avg_to_numeric(lo, hi, neg, state->count));
 }
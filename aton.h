@@ -0,0 +1,241 @@
+/*
+ * Faster aton than strtoul()/strtoull() plus range checks
+ * - one engine shared by every input function, 64-bit and 128-bit
+ * - skip leading zeroes, then count the significant digits; the digit
+ *   count alone decides overflow except at the maximum width, where
+ *   the final multiply-add is checked exactly
+ * - convert 8 digits per step using SWAR (SIMD within a register)
+ *   on little-endian targets, accumulating 19-digit chunks in 64 bits
+ * - on x86-64 with SSE4, convert 16 digits per step; the wider levels
+ *   of cpu.h use the same kernel, as no chunk has more than 19 digits
+ *
+ * Accepted syntax matches the PostgreSQL integer input functions:
+ * optional leading whitespace, optional sign, one or more decimal
+ * digits, optional trailing whitespace.
+ */
+
+#include <ctype.h>
+#include <string.h>
+
+#include "cpu.h"
+
+/* define likely/unlikely if needed */
+#ifdef __GNUC__
+#ifndef likely
+#define likely(x) __builtin_expect(!!(x), 1)
+#endif
+#ifndef unlikely
+#define unlikely(x) __builtin_expect(!!(x), 0)
+#endif
+#endif
+
+#ifndef likely
+#define likely(x) (x)
+#endif
+#ifndef unlikely
+#define unlikely(x) (x)
+#endif
+
+/* aton status codes */
+#define ATON_OK		0	/* valid, value returned */
+#define ATON_SYNTAX	1	/* no digits, or trailing junk */
+#define ATON_RANGE	2	/* magnitude does not fit in the result */
+
+/* caller-assured pre-condition: s[0..7] are all decimal digits */
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+static inline uint32_t
+aton_8digits(const char *s)
+{
+	uint64_t v;
+	memcpy(&v, s, 8);
+	v -= 0x3030303030303030ULL;
+	v = (v * 10) + (v >> 8);	/* 4 x 2-digit lanes */
+	v = (((v & 0x000000FF000000FFULL) * 0x000F424000000064ULL) +
+		 (((v >> 16) & 0x000000FF000000FFULL) * 0x0000271000000001ULL)) >> 32;
+	return (uint32_t)v;
+}
+#else
+static inline uint32_t
+aton_8digits(const char *s)
+{
+	uint32_t v = 0;
+	unsigned int i;
+	for (i = 0; i < 8; ++i) v = v * 10 + (s[i] - '0');
+	return v;
+}
+#endif
+
+/* caller-assured pre-condition: n <= 19, s[0..n-1] are decimal digits */
+static inline uint64_t
+aton_chunk(const char *s, unsigned int n)
+{
+	uint64_t v = 0;
+	unsigned int i = n & 7;
+	while (i--) v = v * 10 + (*s++ - '0');
+	for (n >>= 3; n; --n, s += 8) v = v * 100000000ULL + aton_8digits(s);
+	return v;
+}
+
+/*
+ * scan leading whitespace, sign, leading zeroes and significant digits;
+ * returns a pointer to the first significant digit (or to the end of
+ * the digits if the value is zero), sets *n to the number of
+ * significant digits, *neg to the sign, and *end to the first
+ * character after the digits; returns NULL if there are no digits
+ */
+static inline const char *
+aton_scan(const char *s, int *neg, unsigned int *n, const char **end)
+{
+	const char *p;
+	const char *q;
+
+	while (unlikely(isspace((unsigned char)*s))) ++s;
+	*neg = 0;
+	if (*s == '-') { *neg = 1; ++s; }
+	else if (*s == '+') ++s;
+
+	q = s;
+	while (*q == '0') ++q;
+	p = q;
+	while ((unsigned char)(*q - '0') < 10) ++q;
+	if (unlikely(q == s)) return NULL;	/* no digits */
+
+	*n = q - p;
+	*end = q;
+	return p;
+}
+
+/* SQL requires trailing spaces to be ignored while erroring out on other
+ * "trailing junk" */
+static inline int
+aton_trailing(const char *s)
+{
+	while (unlikely(isspace((unsigned char)*s))) ++s;
+	return *s ? ATON_SYNTAX : ATON_OK;
+}
+
+/*
+ * the parsers, taking the chunk converter as a parameter; the generic
+ * kernels and each CPU variant below inline them with their own
+ */
+typedef uint64_t (*aton_chunk_fn)(const char *s, unsigned int n);
+
+#ifdef __GNUC__
+#define aton_always_inline inline __attribute__((always_inline))
+#else
+#define aton_always_inline inline
+#endif
+
+static aton_always_inline int
+aton_u64_with(const char *s, int *neg, uint64_t *r, aton_chunk_fn chunk)
+{
+	const char *end;
+	unsigned int n;
+	const char *p = aton_scan(s, neg, &n, &end);
+	uint64_t v;
+
+	if (unlikely(!p)) return ATON_SYNTAX;
+	if (likely(n <= 19))
+		v = chunk(p, n);
+	else if (n == 20) {
+		if (__builtin_mul_overflow((uint64_t)(p[0] - '0'),
+								   10000000000000000000ULL, &v) ||
+			__builtin_add_overflow(v, chunk(p + 1, 19), &v))
+			return ATON_RANGE;
+	} else
+		return ATON_RANGE;
+	*r = v;
+	return aton_trailing(end);
+}
+
+static aton_always_inline int
+aton_u128_with(const char *s, int *neg, __uint128_t *r, aton_chunk_fn chunk)
+{
+	const char *end;
+	unsigned int n;
+	const char *p = aton_scan(s, neg, &n, &end);
+	__uint128_t v;
+
+	if (unlikely(!p)) return ATON_SYNTAX;
+	if (likely(n <= 19))
+		v = chunk(p, n);
+	else if (likely(n <= 38)) {
+		unsigned int h = n - 19;
+		v = (__uint128_t)chunk(p, h) * 10000000000000000000ULL +
+			chunk(p + h, 19);
+	} else if (n == 39) {
+		v = (__uint128_t)chunk(p, 1) * 10000000000000000000ULL +
+			chunk(p + 1, 19);
+		if (__builtin_mul_overflow(v, (__uint128_t)10000000000000000000ULL, &v) ||
+			__builtin_add_overflow(v, (__uint128_t)chunk(p + 20, 19), &v))
+			return ATON_RANGE;
+	} else
+		return ATON_RANGE;
+	*r = v;
+	return aton_trailing(end);
+}
+
+/* the generic kernels */
+static inline int
+aton_u64(const char *s, int *neg, uint64_t *r)
+{
+	return aton_u64_with(s, neg, r, aton_chunk);
+}
+
+static inline int
+aton_u128(const char *s, int *neg, __uint128_t *r)
+{
+	return aton_u128_with(s, neg, r, aton_chunk);
+}
+
+#ifdef UINT_CPU_X86
+
+#define ATON_VARIANTS(sfx, target, chunk) \
+target static inline int \
+aton_u64_##sfx(const char *s, int *neg, uint64_t *r) \
+{ \
+	return aton_u64_with(s, neg, r, chunk); \
+} \
+target static inline int \
+aton_u128_##sfx(const char *s, int *neg, __uint128_t *r) \
+{ \
+	return aton_u128_with(s, neg, r, chunk); \
+}
+
+/*
+ * caller-assured pre-condition: s[0..15] are all decimal digits;
+ * pairs, quads and octets of digits by multiply-adds of the lanes
+ */
+UINT_TARGET_SSE4 static inline uint64_t
+aton_16digits_sse4(const char *s)
+{
+	__m128i v = _mm_sub_epi8(_mm_loadu_si128((const __m128i *)s), _mm_set1_epi8('0'));
+	uint64_t r;
+
+	v = _mm_maddubs_epi16(v, _mm_setr_epi8(10, 1, 10, 1, 10, 1, 10, 1,
+										   10, 1, 10, 1, 10, 1, 10, 1));
+	v = _mm_madd_epi16(v, _mm_setr_epi16(100, 1, 100, 1, 100, 1, 100, 1));
+	v = _mm_packus_epi32(v, v);
+	v = _mm_madd_epi16(v, _mm_setr_epi16(10000, 1, 10000, 1, 10000, 1, 10000, 1));
+	r = _mm_cvtsi128_si64(v);
+	return (r & 0xffffffff) * 100000000ULL + (r >> 32);
+}
+
+/* as aton_chunk */
+UINT_TARGET_SSE4 static inline uint64_t
+aton_chunk_sse4(const char *s, unsigned int n)
+{
+	uint64_t v = 0;
+	unsigned int i;
+
+	if (n < 16)
+		return aton_chunk(s, n);
+	for (i = n - 16; i; --i) v = v * 10 + (*s++ - '0');
+	return v * 10000000000000000ULL + aton_16digits_sse4(s);
+}
+
+ATON_VARIANTS(sse4, UINT_TARGET_SSE4, aton_chunk_sse4)
+ATON_VARIANTS(avx2, UINT_TARGET_AVX2, aton_chunk_sse4)
+ATON_VARIANTS(avx512, UINT_TARGET_AVX512, aton_chunk_sse4)
+
+#endif /* UINT_CPU_X86 */
@@ -0,0 +1,262 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <limits.h>
+#include <assert.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <time.h>
+#include <inttypes.h>
+
+typedef __int128_t int128_t;
+typedef __uint128_t uint128_t;
+
+#include "ntoa.h"
+#include "aton.h"
+
+/*
+ * aton.h test program; "aton_test bench" also times aton against the
+ * strtoull()/digit-at-a-time parsers it replaced
+ */
+
+/* previous uint1in..uint8in: strchr() for '-', then strtoull() */
+static int
+old_atou64(const char *s, uint64_t *r)
+{
+	char *badp;
+	if (!*s || strchr(s, '-')) return ATON_SYNTAX;
+	errno = 0;
+	*r = strtoull(s, &badp, 10);
+	if (errno == ERANGE) return ATON_RANGE;
+	if (s == badp) return ATON_SYNTAX;
+	while (*badp && isspace((unsigned char) *badp)) badp++;
+	return *badp ? ATON_SYNTAX : ATON_OK;
+}
+
+/* previous int16in/uint16in: one 128-bit multiply per digit, wraps */
+static unsigned int
+old_atou128(const char *s, uint128_t *r)
+{
+	int c = s[0];
+	uint128_t v;
+	unsigned int o;
+	if (unlikely(c < '0' || c > '9')) return 0;
+	v = c - '0';
+	o = 1;
+	while (likely(o < 39 && (c = s[o]) >= '0' && c <= '9')) {
+		v = v * 10 + (c - '0');
+		++o;
+	}
+	*r = v;
+	return o;
+}
+
+static uint64_t
+rand64(void)
+{
+	static uint64_t x = 0x9e3779b97f4a7c15ULL;	/* xorshift64* */
+	x ^= x >> 12; x ^= x << 25; x ^= x >> 27;
+	return x * 0x2545f4914f6cdd1dULL;
+}
+
+static void
+check64(const char *s, int status, uint64_t v, int neg)
+{
+	uint64_t r;
+	int n;
+	assert(aton_u64(s, &n, &r) == status);
+	if (status == ATON_OK) {
+		assert(r == v);
+		assert(n == neg);
+	}
+}
+
+static void
+check128(const char *s, int status, uint128_t v, int neg)
+{
+	uint128_t r;
+	int n;
+	assert(aton_u128(s, &n, &r) == status);
+	if (status == ATON_OK) {
+		assert(r == v);
+		assert(n == neg);
+	}
+}
+
+void
+testsyntax()
+{
+	check64("", ATON_SYNTAX, 0, 0);
+	check64(" ", ATON_SYNTAX, 0, 0);
+	check64("-", ATON_SYNTAX, 0, 0);
+	check64("+", ATON_SYNTAX, 0, 0);
+	check64("x", ATON_SYNTAX, 0, 0);
+	check64("55 x", ATON_SYNTAX, 0, 0);
+	check64("5 5", ATON_SYNTAX, 0, 0);
+	check64("+-5", ATON_SYNTAX, 0, 0);
+	check64("0x10", ATON_SYNTAX, 0, 0);
+	check64("0", ATON_OK, 0, 0);
+	check64("-0", ATON_OK, 0, 1);
+	check64("  +42  ", ATON_OK, 42, 0);
+	check64("\t-42\n", ATON_OK, 42, 1);
+	check64("00000000000000000000000000000000000000000001", ATON_OK, 1, 0);
+	check64("18446744073709551615", ATON_OK, UINT64_MAX, 0);
+	check64("018446744073709551615", ATON_OK, UINT64_MAX, 0);
+	check64("18446744073709551616", ATON_RANGE, 0, 0);
+	check64("20000000000000000000", ATON_RANGE, 0, 0);
+	check64("99999999999999999999", ATON_RANGE, 0, 0);
+	check64("100000000000000000000", ATON_RANGE, 0, 0);
+	check64("99999999999999999999 x", ATON_RANGE, 0, 0);
+	check64("9999999999999999999", ATON_OK, 9999999999999999999ULL, 0);
+	check64("10000000000000000000", ATON_OK, 10000000000000000000ULL, 0);
+
+	check128("", ATON_SYNTAX, 0, 0);
+	check128("55 x", ATON_SYNTAX, 0, 0);
+	check128("340282366920938463463374607431768211455", ATON_OK,
+			 ~(uint128_t)0, 0);
+	check128("-340282366920938463463374607431768211455", ATON_OK,
+			 ~(uint128_t)0, 1);
+	check128("340282366920938463463374607431768211456", ATON_RANGE, 0, 0);
+	check128("500000000000000000000000000000000000000", ATON_RANGE, 0, 0);
+	check128("999999999999999999999999999999999999999", ATON_RANGE, 0, 0);
+	check128("1000000000000000000000000000000000000000", ATON_RANGE, 0, 0);
+	check128("170141183460469231731687303715884105728", ATON_OK,
+			 ((uint128_t)1)<<127, 0);
+	check128(" 99999999999999999999999999999999999999 ", ATON_OK,
+			 ((uint128_t)9999999999999999999ULL) * 10000000000000000000ULL +
+			 9999999999999999999ULL, 0);
+	puts("syntax and boundary tests passed");
+}
+
+void
+testu64()
+{
+	uint64_t i, j;
+	unsigned int k;
+	char buf[32];
+	int neg;
+
+	for (k = 0; k < 10000000; ++k) {
+		i = rand64() >> (k % 64);
+		utoa64(buf, i);
+		assert(aton_u64(buf, &neg, &j) == ATON_OK);
+		assert(i == j && !neg);
+		assert(strtoull(buf, 0, 10) == j);
+	}
+	printf("uint64_t final value %s\n", buf);
+}
+
+void
+testu128()
+{
+	uint128_t i, j;
+	unsigned int k;
+	char buf[48];
+	int neg;
+
+	for (k = 0; k < 10000000; ++k) {
+		i = (((uint128_t)rand64())<<64 | rand64()) >> (k % 128);
+		utoa128(buf, i);
+		assert(aton_u128(buf, &neg, &j) == ATON_OK);
+		assert(i == j && !neg);
+		assert(old_atou128(buf, &j) == strlen(buf) && i == j);
+	}
+	printf("uint128_t final value %s\n", buf);
+}
+
+/*
+ * benchmark over payloads resembling COPY columns
+ */
+
+#define BENCH_N 1000000
+
+static double
+now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static char **
+payload(const char *name)
+{
+	char **v = malloc(BENCH_N * sizeof(char *));
+	unsigned int k;
+	for (k = 0; k < BENCH_N; ++k) {
+		char buf[48];
+		if (!strcmp(name, "counter"))	/* small counts, 1-3 digits */
+			utoa64(buf, rand64() % 1000);
+		else if (!strcmp(name, "serial"))	/* uint4 serial ids */
+			utoa64(buf, 10000000 + k);
+		else if (!strcmp(name, "epoch_ns"))	/* uint8 timestamps, 19 digits */
+			utoa64(buf, 1700000000000000000ULL + rand64() % 100000000000000000ULL);
+		else if (!strcmp(name, "hash64"))	/* uint8 hashes, mostly 20 digits */
+			utoa64(buf, rand64());
+		else	/* "hash128": uint16 keys, mostly 39 digits */
+			utoa128(buf, ((uint128_t)rand64())<<64 | rand64());
+		v[k] = strdup(buf);
+	}
+	return v;
+}
+
+static void
+bench(const char *name, int wide)
+{
+	char **v = payload(name);
+	uint64_t sum64 = 0;
+	uint128_t sum128 = 0;
+	double t0, t1, t2;
+	unsigned int k;
+	int neg;
+
+	t0 = now();
+	for (k = 0; k < BENCH_N; ++k) {
+		if (wide) {
+			uint128_t r = 0;
+			old_atou128(v[k], &r);
+			sum128 += r;
+		} else {
+			uint64_t r = 0;
+			old_atou64(v[k], &r);
+			sum64 += r;
+		}
+	}
+	t1 = now();
+	for (k = 0; k < BENCH_N; ++k) {
+		if (wide) {
+			uint128_t r = 0;
+			aton_u128(v[k], &neg, &r);
+			sum128 -= r;
+		} else {
+			uint64_t r = 0;
+			aton_u64(v[k], &neg, &r);
+			sum64 -= r;
+		}
+	}
+	t2 = now();
+	assert(!sum64 && !sum128);
+	printf("%-10s old %6.2f ns/value  aton %6.2f ns/value  (%.2fx)\n", name,
+		   (t1 - t0) * 1e9 / BENCH_N, (t2 - t1) * 1e9 / BENCH_N,
+		   (t1 - t0) / (t2 - t1));
+	for (k = 0; k < BENCH_N; ++k) free(v[k]);
+	free(v);
+}
+
+int
+main(int argc, char **argv)
+{
+	if (argc > 1 && !strcmp(argv[1], "bench")) {
+		bench("counter", 0);
+		bench("serial", 0);
+		bench("epoch_ns", 0);
+		bench("hash64", 0);
+		bench("hash128", 1);
+		return 0;
+	}
+	testsyntax();
+	testu64();
+	testu128();
+	puts("all tests passed");
+	return 0;
+}
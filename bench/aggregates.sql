@@ -0,0 +1,34 @@
+-- avg throughput, many rows per group and many small groups
+--
+--   psql -X -v rows=10000000 -f bench/aggregates.sql
+--
+\if :{?rows}
+\else
+\set rows 10000000
+\endif
+
+CREATE EXTENSION IF NOT EXISTS uint;
+SET max_parallel_workers_per_gather = 0;
+
+CREATE TEMP TABLE bench_agg AS
+SELECT g % 100000 AS k,
+       (g % 256)::uint1 AS u1,
+       ((g * 2654435761) % 4294967296)::uint4 AS u4,
+       ('18446744073709551615'::uint8 - g::uint8) AS u8,
+       ((g::int16 << 70) - g::int16) AS i16,
+       ((g::uint16 << 100) + g::uint16) AS u16
+FROM generate_series(1, :rows) g;
+VACUUM ANALYZE bench_agg;
+
+\timing on
+SELECT avg(u1) FROM bench_agg;
+SELECT avg(u4) FROM bench_agg;
+SELECT avg(u8) FROM bench_agg;
+SELECT avg(i16) FROM bench_agg;
+SELECT avg(u16) FROM bench_agg;
+-- 100000 groups: finalfunc cost and state size matter
+SELECT count(a) FROM (SELECT avg(u8) AS a FROM bench_agg GROUP BY k) _;
+SELECT count(a) FROM (SELECT avg(i16) AS a FROM bench_agg GROUP BY k) _;
+\timing off
+
+DROP TABLE bench_agg;
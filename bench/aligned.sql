@@ -0,0 +1,45 @@
+-- scan, compare and arithmetic throughput of the 128-bit types stored
+-- char-aligned (int16, uint16) and double-aligned (int16a, uint16a)
+--
+--   psql -X -v rows=10000000 -f bench/aligned.sql
+--
+\if :{?rows}
+\else
+\set rows 10000000
+\endif
+
+CREATE EXTENSION IF NOT EXISTS uint;
+SET max_parallel_workers_per_gather = 0;
+
+-- the int1 column in front pushes the 128-bit column off 8-byte alignment
+-- in the char-aligned layout
+CREATE UNLOGGED TABLE bench_char AS
+SELECT (g % 100)::int1 AS k,
+       ((g * 210306068529402873165736369884012333109::numeric) % 340282366920938463463374607431768211456)::uint16 AS h,
+       (g::int16 << 70) - g AS f
+FROM generate_series(1, :rows) g;
+CREATE UNLOGGED TABLE bench_double AS
+SELECT k, h::uint16a AS h, f::int16a AS f FROM bench_char;
+VACUUM ANALYZE bench_char;
+VACUUM ANALYZE bench_double;
+SELECT pg_size_pretty(pg_relation_size('bench_char')) AS char_size,
+       pg_size_pretty(pg_relation_size('bench_double')) AS double_size;
+
+\timing on
+-- scan
+SELECT count(h) FROM bench_char;
+SELECT count(h) FROM bench_double;
+-- compare
+SELECT count(*) FROM bench_char WHERE h > '170141183460469231731687303715884105728';
+SELECT count(*) FROM bench_double WHERE h > '170141183460469231731687303715884105728';
+SELECT max(h) FROM bench_char;
+SELECT max(h) FROM bench_double;
+-- arithmetic
+SELECT sum(f + 1) FROM bench_char;
+SELECT sum(f + 1) FROM bench_double;
+SELECT bit_or(h >> 64) FROM bench_char;
+SELECT bit_or(h >> 64) FROM bench_double;
+\timing off
+
+DROP TABLE bench_char;
+DROP TABLE bench_double;
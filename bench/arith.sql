@@ -0,0 +1,34 @@
+-- Arithmetic operator throughput
+--
+--   psql -X -v rows=10000000 -f bench/arith.sql
+--
+\if :{?rows}
+\else
+\set rows 10000000
+\endif
+
+CREATE EXTENSION IF NOT EXISTS uint;
+SET max_parallel_workers_per_gather = 0;
+
+-- operands small enough that nothing overflows, and f >= h
+CREATE UNLOGGED TABLE bench_arith AS
+SELECT (g * 2654435761 % 4294967296)::uint8 AS a,
+       (g * 40503 % 4294967296)::uint8 AS b,
+       (g * 2654435761 % 2147483648)::int8 AS c,
+       (g::int16 * 2654435761) AS d,
+       (g::int16 * 40503 << 16) AS e,
+       (g::uint16 * 2654435761) AS f,
+       (g::uint16 * 40503 << 16) AS h
+FROM generate_series(1, :rows) g;
+VACUUM ANALYZE bench_arith;
+
+\timing on
+SELECT count(*) FROM bench_arith;
+SELECT max(a + b), max(a * b) FROM bench_arith;
+SELECT max(a + c), max(a * c) FROM bench_arith;
+SELECT max(d + e), max(d - e), max(d * e) FROM bench_arith;
+SELECT max(f + h), max(f - h), max(f * h) FROM bench_arith;
+SELECT max(f * c) FROM bench_arith;
+\timing off
+
+DROP TABLE bench_arith;
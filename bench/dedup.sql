@@ -0,0 +1,43 @@
+-- B-tree deduplication on low-cardinality columns, PostgreSQL 13 and later
+--
+--   psql -X -v rows=100000000 -f bench/dedup.sql
+--
+\if :{?rows}
+\else
+\set rows 100000000
+\endif
+
+CREATE EXTENSION IF NOT EXISTS uint;
+SET max_parallel_maintenance_workers = 0;
+SET maintenance_work_mem = '4GB';
+
+-- skewed: a handful of statuses, a few big tenants and a long tail,
+-- and 16-byte keys where most rows share one of 1000 values
+CREATE UNLOGGED TABLE bench_dedup AS
+SELECT (CASE WHEN g % 100 < 90 THEN 0 WHEN g % 100 < 98 THEN 1 ELSE g % 7 END)::uint1 AS status,
+       floor(65535 * power(random(), 8))::int::uint2 AS tenant,
+       floor(1000000 * power(random(), 4))::int::uint4 AS account,
+       ((g % 1000)::uint16 << 64) AS bucket
+FROM generate_series(1, :rows) g;
+VACUUM ANALYZE bench_dedup;
+
+\timing on
+CREATE INDEX bench_dedup_status ON bench_dedup (status);
+CREATE INDEX bench_dedup_status_off ON bench_dedup (status) WITH (deduplicate_items = off);
+CREATE INDEX bench_dedup_tenant ON bench_dedup (tenant);
+CREATE INDEX bench_dedup_tenant_off ON bench_dedup (tenant) WITH (deduplicate_items = off);
+CREATE INDEX bench_dedup_account ON bench_dedup (account);
+CREATE INDEX bench_dedup_account_off ON bench_dedup (account) WITH (deduplicate_items = off);
+CREATE INDEX bench_dedup_bucket ON bench_dedup (bucket);
+CREATE INDEX bench_dedup_bucket_off ON bench_dedup (bucket) WITH (deduplicate_items = off);
+\timing off
+
+SELECT replace(c.relname, 'bench_dedup_', '') AS index,
+       pg_size_pretty(pg_relation_size(c.oid)) AS deduplicated,
+       pg_size_pretty(pg_relation_size((c.relname || '_off')::regclass)) AS plain,
+       round(pg_relation_size((c.relname || '_off')::regclass)::numeric / pg_relation_size(c.oid), 1) AS ratio
+FROM pg_class c
+WHERE c.relname IN ('bench_dedup_status', 'bench_dedup_tenant', 'bench_dedup_account', 'bench_dedup_bucket')
+ORDER BY 1;
+
+DROP TABLE bench_dedup;
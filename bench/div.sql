@@ -0,0 +1,37 @@
+-- Division and modulo by constant and varying divisors
+--
+--   psql -X -v rows=10000000 -f bench/div.sql
+--
+\if :{?rows}
+\else
+\set rows 10000000
+\endif
+
+CREATE EXTENSION IF NOT EXISTS uint;
+SET max_parallel_workers_per_gather = 0;
+
+-- nanosecond timestamps, sums of cents and 128-bit keys in uint16
+-- columns, a signed int16 balance, and a per-row divisor
+CREATE UNLOGGED TABLE bench_div AS
+SELECT ('1700000000000000000'::uint16 + (g::uint16 * 2654435761 % '100000000000000000'::uint16)) AS ts,
+       (g::uint16 * 40503 % 1000000000) * (g % 1000 + 1) AS cents,
+       ((g::uint16 * 2654435761) << 64) + g::uint8 * 40503 AS id,
+       (g::int16 * 2654435761 % 1000000000000) - 500000000000 AS balance,
+       (g % 1000 + 1)::uint8 AS n
+FROM generate_series(1, :rows) g;
+VACUUM ANALYZE bench_div;
+
+\timing on
+SELECT count(*) FROM bench_div;
+-- constant divisors
+SELECT max(ts / 1000000000) FROM bench_div;
+SELECT max(ts % 86400000000000) FROM bench_div;
+SELECT max(cents / 100), max(cents % 100) FROM bench_div;
+SELECT max(balance / 100), max(balance % 100) FROM bench_div;
+SELECT count(*) FROM bench_div WHERE id % 1024 = 0;
+-- varying divisors
+SELECT max(cents / n), max(cents % n) FROM bench_div;
+SELECT max(id % n) FROM bench_div;
+\timing off
+
+DROP TABLE bench_div;
@@ -0,0 +1,52 @@
+-- hash distribution for int16/uint16 keys
+--
+--   psql -X -v rows=1000000 -f bench/hash.sql
+--
+-- Reports how many of 2^16 buckets each key set occupies and the longest
+-- chain, once with hashuint16 and once with the previous 32-bit fold
+-- (the four 32-bit words XORed together, then hashed as a uint4).
+\if :{?rows}
+\else
+\set rows 1000000
+\endif
+
+CREATE EXTENSION IF NOT EXISTS uint;
+SET max_parallel_workers_per_gather = 0;
+SET work_mem = '1GB';
+
+CREATE UNLOGGED TABLE bench_hash AS
+SELECT 'repeated halves' AS keys, ((g::uint16 << 64) | g::uint16) AS k FROM generate_series(1, :rows) g
+UNION ALL
+SELECT 'shared /64 prefix', (('42540766411282592856903984951653826560'::uint16) | (g::uint16 << 32) | g::uint16) FROM generate_series(1, :rows) g
+UNION ALL
+SELECT 'sequential interface ids', ('42540766411282592856903984951653826560'::uint16 + g) FROM generate_series(1, :rows) g
+UNION ALL
+SELECT 'random', ((g * 210306068529402873165736369884012333109::numeric) % 340282366920938463463374607431768211456)::uint16 FROM generate_series(1, :rows) g;
+
+CREATE FUNCTION pg_temp.old_hashuint16(x uint16) RETURNS int4 LANGUAGE sql IMMUTABLE AS $$
+    SELECT hashuint4(((x & '4294967295'::uint16) # ((x >> 32) & '4294967295'::uint16)
+                      # ((x >> 64) & '4294967295'::uint16) # (x >> 96))::uint4)
+$$;
+
+\timing on
+SELECT keys, 'hashuint16' AS hash, count(*) AS n, count(DISTINCT h) AS distinct_hashes,
+       count(DISTINCT h & 65535) AS buckets_used, max(chain) AS max_chain,
+       round(avg(chain), 2) AS avg_chain
+FROM (SELECT keys, h, count(*) OVER (PARTITION BY keys, h & 65535) AS chain
+      FROM (SELECT keys, hashuint16(k) AS h FROM bench_hash) _) _
+GROUP BY keys
+UNION ALL
+SELECT keys, 'old fold', count(*), count(DISTINCT h),
+       count(DISTINCT h & 65535), max(chain), round(avg(chain), 2)
+FROM (SELECT keys, h, count(*) OVER (PARTITION BY keys, h & 65535) AS chain
+      FROM (SELECT keys, pg_temp.old_hashuint16(k) AS h FROM bench_hash) _) _
+GROUP BY keys
+ORDER BY keys, hash;
+
+-- hash join and hash aggregate throughput
+SET enable_sort = off;
+SELECT keys, count(*) FROM (SELECT keys, k FROM bench_hash GROUP BY keys, k) _ GROUP BY keys;
+SELECT count(*) FROM bench_hash a JOIN bench_hash b USING (keys, k);
+\timing off
+
+DROP TABLE bench_hash;
@@ -0,0 +1,96 @@
+-- Operators in JIT-compiled expressions, with and without inlining
+--
+--   psql -X -v rows=10000000 -f bench/jit.sql
+--
+-- Needs a server built --with-llvm and the extension's bitcode
+-- installed (make install does that for such a server).  The EXPLAIN
+-- output at the end of each JIT section shows whether the functions
+-- were inlined and how long the JIT took.
+--
+\if :{?rows}
+\else
+\set rows 10000000
+\endif
+
+CREATE EXTENSION IF NOT EXISTS uint;
+SET max_parallel_workers_per_gather = 0;
+
+-- a wide table, with int8 columns holding the same values as the
+-- core-type baseline
+CREATE UNLOGGED TABLE bench_jit AS
+SELECT (g % 256)::uint1 AS a1,
+       (g % 65536)::uint2 AS a2,
+       (g * 2654435761 % 4294967296)::uint4 AS a4,
+       (g * 40503 % 4294967296)::uint4 AS b4,
+       (g * 2654435761 % 4294967296)::uint8 AS a8,
+       (g * 40503 % 4294967296)::uint8 AS b8,
+       (g::uint16 * 2654435761) AS a16,
+       (g::uint16 * 40503 << 16) AS b16,
+       (g::int16 * 40503 - 1000000) AS c16,
+       (g * 2654435761 % 4294967296) AS i8,
+       (g * 40503 % 4294967296) AS j8,
+       repeat('x', 32) AS pad
+FROM generate_series(1, :rows) g;
+VACUUM ANALYZE bench_jit;
+
+\set filter_int8 'SELECT count(*) FROM bench_jit WHERE i8 > 1000 AND j8 < 4000000000 AND i8 <> j8 AND i8 % 7 <> 0'
+\set filter_uint 'SELECT count(*) FROM bench_jit WHERE a8 > 1000 AND b8 < 4000000000 AND a8 <> b8 AND a8 % 7 <> 0'
+\set filter_narrow 'SELECT count(*) FROM bench_jit WHERE a1 > 10 AND a2 < 60000 AND a4 > b4 AND a4 >= 5'
+\set filter_wide 'SELECT count(*) FROM bench_jit WHERE a16 > b16 AND c16 < 0 AND a16 <> 12345'
+\set project_int8 'SELECT max(i8 + j8), max(i8 * 3 + j8), max(i8 / 10) FROM bench_jit'
+\set project_uint 'SELECT max(a8 + b8), max(a8 * 3 + b8), max(a8 / 10) FROM bench_jit'
+\set project_wide 'SELECT max(a16 + b16), max(a16 * 3 - b16), max(c16 * 2 + 1) FROM bench_jit'
+
+SET jit_above_cost = 0;
+SET jit_optimize_above_cost = 0;
+
+\echo interpreted
+SET jit = off;
+\timing on
+:filter_int8;
+:filter_uint;
+:filter_narrow;
+:filter_wide;
+:project_int8;
+:project_uint;
+:project_wide;
+\timing off
+
+\echo JIT without inlining
+SET jit = on;
+SET jit_inline_above_cost = -1;
+\timing on
+:filter_int8;
+:filter_uint;
+:filter_narrow;
+:filter_wide;
+:project_int8;
+:project_uint;
+:project_wide;
+\timing off
+
+-- "Inlining false" in the JIT section
+EXPLAIN (ANALYZE, COSTS OFF) :project_wide;
+
+\echo JIT with inlining
+SET jit_inline_above_cost = 0;
+\timing on
+:filter_int8;
+:filter_uint;
+:filter_narrow;
+:filter_wide;
+:project_int8;
+:project_uint;
+:project_wide;
+\timing off
+
+-- "Inlining true" in the JIT section; the int16 products in
+-- project_wide are the ones overflow.h keeps free of libcalls
+EXPLAIN (ANALYZE, COSTS OFF) :filter_uint;
+EXPLAIN (ANALYZE, COSTS OFF) :project_wide;
+
+RESET jit;
+RESET jit_above_cost;
+RESET jit_optimize_above_cost;
+RESET jit_inline_above_cost;
+DROP TABLE bench_jit;
@@ -0,0 +1,42 @@
+-- Comparisons against numeric and float8 operands
+--
+--   psql -X -v rows=10000000 -f bench/numcmp.sql
+--
+\if :{?rows}
+\else
+\set rows 10000000
+\endif
+
+CREATE EXTENSION IF NOT EXISTS uint;
+SET max_parallel_workers_per_gather = 0;
+
+CREATE UNLOGGED TABLE bench_numcmp AS
+SELECT (g * 2654435761 % 4294967296)::uint4 AS a,
+       (g::uint8 * 1844674407370) AS b,
+       (g::uint16 << 80) AS c
+FROM generate_series(1, :rows) g;
+CREATE INDEX bench_numcmp_b ON bench_numcmp (b);
+VACUUM ANALYZE bench_numcmp;
+
+\timing on
+-- full scans: a constant folded into an integer bound, a run-time operand
+-- through the cross-type operator, and converting every row
+SELECT count(*) FROM bench_numcmp WHERE a > 2147483647.5;
+SELECT count(*) FROM bench_numcmp WHERE a > (SELECT 2147483647.5);
+SELECT count(*) FROM bench_numcmp WHERE a::numeric > 2147483647.5;
+SELECT count(*) FROM bench_numcmp WHERE c < 1e30;
+SELECT count(*) FROM bench_numcmp WHERE c < (SELECT 1e30);
+SELECT count(*) FROM bench_numcmp WHERE c::numeric < 1e30;
+SELECT count(*) FROM bench_numcmp WHERE a < 1e9::float8;
+SELECT count(*) FROM bench_numcmp WHERE a < (SELECT 1e9::float8);
+SELECT count(*) FROM bench_numcmp WHERE a::float8 < 1e9::float8;
+
+-- a narrow range: the folded bounds use the index, the cast cannot
+SELECT count(*) FROM bench_numcmp WHERE b BETWEEN 1844674407370.5 AND 18446744073700.5;
+SELECT count(*) FROM bench_numcmp WHERE b::numeric BETWEEN 1844674407370.5 AND 18446744073700.5;
+\timing off
+
+EXPLAIN (COSTS OFF)
+SELECT count(*) FROM bench_numcmp WHERE b BETWEEN 1844674407370.5 AND 18446744073700.5;
+
+DROP TABLE bench_numcmp;
@@ -0,0 +1,36 @@
+-- uint <-> numeric conversion throughput
+--
+--   psql -X -v rows=10000000 -f bench/numeric.sql
+--
+\if :{?rows}
+\else
+\set rows 10000000
+\endif
+
+CREATE EXTENSION IF NOT EXISTS uint;
+SET max_parallel_workers_per_gather = 0;
+
+CREATE TEMP TABLE bench_numeric AS
+SELECT (g * 2654435761)::uint8 AS small8,
+       ('18446744073709551615'::uint8 - g::uint8) AS big8,
+       ((g::uint16 << 70) + g::uint16) AS big16,
+       ((g::uint16 << 70) + g::uint16)::numeric AS num16
+FROM generate_series(1, :rows) g;
+VACUUM ANALYZE bench_numeric;
+
+\timing on
+-- uint8 below 2^63
+SELECT count(small8::numeric) FROM bench_numeric;
+-- uint8 at or above 2^63
+SELECT count(big8::numeric) FROM bench_numeric;
+-- uint16 at or above 2^64
+SELECT count(big16::numeric) FROM bench_numeric;
+-- implicit casts in a filter
+SELECT count(*) FROM bench_numeric WHERE big16 > 1.5;
+-- numeric staging column to uint8, uint16 and int16
+SELECT count(big8::numeric::uint8) FROM bench_numeric;
+SELECT count(num16::uint16) FROM bench_numeric;
+SELECT count(num16::int16) FROM bench_numeric;
+\timing off
+
+DROP TABLE bench_numeric;
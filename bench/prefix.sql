@@ -0,0 +1,49 @@
+-- SP-GiST prefix lookups against the B-tree range-scan equivalent
+--
+--   psql -X -v rows=1000000 -f bench/prefix.sql
+--
+\if :{?rows}
+\else
+\set rows 1000000
+\endif
+
+CREATE EXTENSION IF NOT EXISTS uint;
+SET max_parallel_workers_per_gather = 0;
+SET enable_bitmapscan = off;
+
+-- a routing table: prefix lengths 8 to 32, weighted towards /24
+CREATE UNLOGGED TABLE bench_prefix AS
+SELECT uint4prefix(((g * 2654435761) % 4294967296)::uint4,
+                   (ARRAY[8, 12, 16, 20, 22, 24, 24, 24, 28, 32])[g % 10 + 1]) AS prefix
+FROM generate_series(1, :rows) g;
+CREATE INDEX bench_prefix_spgist ON bench_prefix USING spgist (prefix);
+CREATE INDEX bench_prefix_btree ON bench_prefix (lower(prefix), upper(prefix));
+VACUUM ANALYZE bench_prefix;
+
+CREATE TEMP TABLE bench_addr AS
+SELECT ((g * 2246822519) % 4294967296)::uint4 AS a FROM generate_series(1, 1000) g;
+
+SELECT pg_size_pretty(pg_relation_size('bench_prefix_spgist')) AS spgist,
+       pg_size_pretty(pg_relation_size('bench_prefix_btree')) AS btree;
+
+\timing on
+-- longest prefix match for 1000 addresses
+SELECT count(p) FROM bench_addr,
+LATERAL (SELECT prefix AS p FROM bench_prefix WHERE prefix >>= a
+         ORDER BY masklen(prefix) DESC LIMIT 1) _;
+-- the B-tree can only bound the lower end, so it walks every prefix
+-- starting below the address
+SELECT count(p) FROM bench_addr,
+LATERAL (SELECT prefix AS p FROM bench_prefix WHERE lower(prefix) <= a AND upper(prefix) >= a
+         ORDER BY masklen(prefix) DESC LIMIT 1) _;
+
+-- everything inside a /16: both indexes do a narrow scan
+SELECT count(*) FROM bench_addr,
+LATERAL (SELECT 1 FROM bench_prefix WHERE prefix <<= uint4prefix(a, 16)) _;
+SELECT count(*) FROM bench_addr,
+LATERAL (SELECT 1 FROM bench_prefix
+         WHERE lower(prefix) BETWEEN lower(uint4prefix(a, 16)) AND upper(uint4prefix(a, 16))
+           AND upper(prefix) <= upper(uint4prefix(a, 16))) _;
+\timing off
+
+DROP TABLE bench_prefix, bench_addr;
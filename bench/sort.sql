@@ -0,0 +1,44 @@
+-- sort and B-tree build throughput
+--
+--   psql -X -v rows=100000000 -f bench/sort.sql
+--
+\if :{?rows}
+\else
+\set rows 100000000
+\endif
+
+CREATE EXTENSION IF NOT EXISTS uint;
+SET max_parallel_workers_per_gather = 0;
+SET max_parallel_maintenance_workers = 0;
+SET work_mem = '1GB';
+SET maintenance_work_mem = '4GB';
+
+-- random high halves (IPv6 addresses, hash keys), and values below 2^64
+-- where the high halves are all equal and abbreviation is aborted
+CREATE UNLOGGED TABLE bench_sort AS
+SELECT ((g * 210306068529402873165736369884012333109::numeric) % 340282366920938463463374607431768211456)::uint16 AS addr,
+       ((g * 210306068529402873165736369884012333109::numeric) % 340282366920938463463374607431768211456
+        - 170141183460469231731687303715884105728)::int16 AS signed,
+       ((g * 2654435761) % 4294967296)::uint16 AS small,
+       ((g * 2654435761) % 4294967296)::uint4 AS u4,
+       ((g * 11400714819323198485::numeric) % 18446744073709551616)::uint8 AS u8,
+       (g % 256 - 128)::int1 AS i1
+FROM generate_series(1, :rows) g;
+VACUUM ANALYZE bench_sort;
+
+\timing on
+SELECT count(*) FROM (SELECT addr FROM bench_sort ORDER BY addr OFFSET 0) _;
+SELECT count(*) FROM (SELECT signed FROM bench_sort ORDER BY signed OFFSET 0) _;
+SELECT count(*) FROM (SELECT small FROM bench_sort ORDER BY small OFFSET 0) _;
+-- pass-by-value types: on PostgreSQL 15+ these use the core comparators
+SELECT count(*) FROM (SELECT u4 FROM bench_sort ORDER BY u4 OFFSET 0) _;
+SELECT count(*) FROM (SELECT u8 FROM bench_sort ORDER BY u8 OFFSET 0) _;
+SELECT count(*) FROM (SELECT i1 FROM bench_sort ORDER BY i1 OFFSET 0) _;
+CREATE INDEX bench_sort_addr ON bench_sort (addr);
+CREATE INDEX bench_sort_signed ON bench_sort (signed);
+CREATE INDEX bench_sort_small ON bench_sort (small);
+CREATE INDEX bench_sort_u4 ON bench_sort (u4);
+CREATE INDEX bench_sort_u8 ON bench_sort (u8);
+\timing off
+
+DROP TABLE bench_sort;
@@ -0,0 +1,69 @@
+/*
+ * CPU levels for the conversion kernels in ntoa.h, aton.h and hex.h
+ * - the extension is built for baseline x86-64; the faster variants
+ *   are compiled per function with the target attribute, and
+ *   kernels.h picks one set when the library is loaded
+ * - sse4: SSSE3 and SSE4.1 (every x86-64 server of the last decade)
+ * - avx2: AVX2 and BMI2 (Haswell, Zen)
+ * - avx512: AVX-512 BW, VL, VBMI and IFMA (Ice Lake, Zen 4); Skylake-SP
+ *   has AVX-512 but not VBMI or IFMA and gets avx2
+ * - BMI2 gives the compiler mulx and shrx for the 128-bit arithmetic
+ *   around the kernels; they don't use pdep/pext, which are microcoded
+ *   and slow before Zen 3
+ * - other architectures and compilers only have the generic kernels
+ */
+
+#ifndef UINT_CPU_H
+#define UINT_CPU_H
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define UINT_CPU_X86 1
+#include <immintrin.h>
+#endif
+
+typedef enum
+{
+	UINT_CPU_GENERIC,
+	UINT_CPU_SSE4,
+	UINT_CPU_AVX2,
+	UINT_CPU_AVX512
+} uint_cpu_level;
+
+#define UINT_CPU_LEVELS 4
+
+static inline const char *
+uint_cpu_level_name(uint_cpu_level level)
+{
+	static const char *const names[UINT_CPU_LEVELS] = {
+		"generic", "sse4", "avx2", "avx512"
+	};
+	return names[level];
+}
+
+#ifdef UINT_CPU_X86
+#define UINT_TARGET_SSE4 __attribute__((target("ssse3,sse4.1")))
+#define UINT_TARGET_AVX2 __attribute__((target("avx2,bmi2")))
+#define UINT_TARGET_AVX512 \
+	__attribute__((target("avx2,bmi2,avx512f,avx512bw,avx512vl,avx512vbmi,avx512ifma")))
+#endif
+
+/* the highest level this CPU supports */
+static inline uint_cpu_level
+uint_cpu_detect(void)
+{
+#ifdef UINT_CPU_X86
+	__builtin_cpu_init();
+	if (!__builtin_cpu_supports("ssse3") || !__builtin_cpu_supports("sse4.1"))
+		return UINT_CPU_GENERIC;
+	if (!__builtin_cpu_supports("avx2") || !__builtin_cpu_supports("bmi2"))
+		return UINT_CPU_SSE4;
+	if (!__builtin_cpu_supports("avx512bw") || !__builtin_cpu_supports("avx512vl") ||
+		!__builtin_cpu_supports("avx512vbmi") || !__builtin_cpu_supports("avx512ifma"))
+		return UINT_CPU_AVX2;
+	return UINT_CPU_AVX512;
+#else
+	return UINT_CPU_GENERIC;
+#endif
+}
+
+#endif /* UINT_CPU_H */
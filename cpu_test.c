@@ -0,0 +1,220 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <assert.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+
+typedef __int128_t int128_t;
+typedef __uint128_t uint128_t;
+
+#include "kernels.h"
+
+const uint_kernels *uint_kernel;
+
+/*
+ * kernels.h test program: every CPU level this machine supports against
+ * the generic kernels; "cpu_test bench" also times the levels
+ */
+
+static uint64_t
+rand64(void)
+{
+	static uint64_t x = 0x9e3779b97f4a7c15ULL;	/* xorshift64* */
+	x ^= x >> 12; x ^= x << 25; x ^= x >> 27;
+	return x * 0x2545f4914f6cdd1dULL;
+}
+
+/* values around 2^k and 10^k and random values of every width */
+static uint128_t
+interesting(unsigned int i)
+{
+	unsigned int k = i % 129;
+	uint128_t p = k == 128 ? 0 : (uint128_t) 1 << k;
+	uint128_t t = 1;
+	unsigned int j;
+
+	for (j = 0; j < k % 39; ++j)
+		t *= 10;
+	switch (i / 129 % 7) {
+		case 0: return p - 1;
+		case 1: return p;
+		case 2: return p + 1;
+		case 3: return t - 1;
+		case 4: return t;
+		case 5: return t + 1;
+		default: return (((uint128_t) rand64() << 64) | rand64()) >> (128 - (k ? k : 1));
+	}
+}
+
+#define BUFSZ 48
+
+static void
+check(const uint_kernels *kv, const uint_kernels *g, uint128_t v)
+{
+	char a[BUFSZ], b[BUFSZ];
+	int na, nb;
+	uint64_t ra, rb;
+	uint128_t rwa, rwb;
+	unsigned int la, lb;
+
+	g->utoa32(a, (uint32_t) v);
+	kv->utoa32(b, (uint32_t) v);
+	assert(!strcmp(a, b));
+	g->utoa64(a, (uint64_t) v);
+	kv->utoa64(b, (uint64_t) v);
+	assert(!strcmp(a, b));
+	assert(kv->aton_u64(a, &nb, &rb) == ATON_OK && !nb && rb == (uint64_t) v);
+	g->utoa128(a, v);
+	kv->utoa128(b, v);
+	assert(!strcmp(a, b));
+	assert(kv->aton_u128(a, &nb, &rwb) == ATON_OK && !nb && rwb == v);
+	assert(kv->aton_u64(a, &na, &ra) == g->aton_u64(a, &nb, &rb));
+	g->itoa128(a, (int128_t) v);
+	kv->itoa128(b, (int128_t) v);
+	assert(!strcmp(a, b));
+	assert(kv->aton_u128(a, &na, &rwa) == g->aton_u128(a, &nb, &rwb) &&
+		   na == nb && rwa == rwb);
+
+	la = g->hex64(a, (uint64_t) v);
+	lb = kv->hex64(b, (uint64_t) v);
+	assert(la == lb && la == strlen(a) && !strcmp(a, b));
+	la = g->hex128(a, v);
+	lb = kv->hex128(b, v);
+	assert(la == lb && la == strlen(a) && !strcmp(a, b));
+}
+
+/* leading zeroes and whitespace, signs, junk and overlong inputs */
+static void
+check_parse(const uint_kernels *kv, const uint_kernels *g, const char *s)
+{
+	int na, nb;
+	uint64_t ra = 0, rb = 0;
+	uint128_t rwa = 0, rwb = 0;
+	int sa, sb;
+
+	sa = kv->aton_u64(s, &na, &ra);
+	sb = g->aton_u64(s, &nb, &rb);
+	assert(sa == sb && (sa != ATON_OK || (na == nb && ra == rb)));
+	sa = kv->aton_u128(s, &na, &rwa);
+	sb = g->aton_u128(s, &nb, &rwb);
+	assert(sa == sb && (sa != ATON_OK || (na == nb && rwa == rwb)));
+}
+
+static void
+testlevel(uint_cpu_level level)
+{
+	const uint_kernels *kv = uint_kernels_for(level);
+	const uint_kernels *g = uint_kernels_for(UINT_CPU_GENERIC);
+	static const char *const prefix[] = {"", "0", "000000000000000000000", " -", "+0"};
+	static const char *const suffix[] = {"", " ", "x", "0", "00000000000000000000"};
+	char s[BUFSZ + 64];
+	unsigned int i, j;
+	uint64_t count = 0;
+
+	for (i = 0; i < 129 * 7 * 2; ++i, ++count)
+		check(kv, g, interesting(i));
+	for (i = 0; i < 2000000; ++i, ++count)
+		check(kv, g, (((uint128_t) rand64() << 64) | rand64()) >> (rand64() % 128));
+	for (i = 0; i < 129 * 7; ++i)
+		for (j = 0; j < 25; ++j, ++count) {
+			char digits[BUFSZ];
+			g->utoa128(digits, interesting(i));
+			snprintf(s, sizeof(s), "%s%s%s", prefix[j / 5], digits, suffix[j % 5]);
+			check_parse(kv, g, s);
+		}
+	printf("%-8s %llu values checked\n", uint_cpu_level_name(level),
+		   (unsigned long long) count);
+}
+
+/*
+ * benchmark over values of every width
+ */
+
+#define BENCH_N 4096
+#define BENCH_ROUNDS 200
+
+static double
+now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* best of five runs of the loop, in ns per value */
+#define TIME(result, body) \
+	do { \
+		unsigned int rep_; \
+		result = 1e9; \
+		for (rep_ = 0; rep_ < 5; ++rep_) { \
+			double t_ = now(); \
+			body; \
+			t_ = (now() - t_) * 1e9 / BENCH_N / BENCH_ROUNDS; \
+			if (t_ < result) result = t_; \
+		} \
+	} while (0)
+
+static void
+bench(uint_cpu_level level, const uint128_t *v, char (*text)[BUFSZ])
+{
+	const uint_kernels *kv = uint_kernels_for(level);
+	char buf[BUFSZ];
+	double t1, t2, t3, t4, t5;
+	uint64_t sum = 0;
+	unsigned int k;
+
+	TIME(t1, for (k = 0; k < BENCH_N * BENCH_ROUNDS; ++k) {
+		kv->utoa64(buf, (uint64_t) v[k % BENCH_N]);
+		sum += buf[0];
+	});
+	TIME(t2, for (k = 0; k < BENCH_N * BENCH_ROUNDS; ++k) {
+		kv->utoa128(buf, v[k % BENCH_N]);
+		sum += buf[0];
+	});
+	TIME(t3, for (k = 0; k < BENCH_N * BENCH_ROUNDS; ++k) {
+		int neg;
+		uint128_t r;
+		kv->aton_u128(text[k % BENCH_N], &neg, &r);
+		sum += (uint64_t) r;
+	});
+	TIME(t4, for (k = 0; k < BENCH_N * BENCH_ROUNDS; ++k)
+		sum += kv->hex64(buf, (uint64_t) v[k % BENCH_N]));
+	TIME(t5, for (k = 0; k < BENCH_N * BENCH_ROUNDS; ++k)
+		sum += kv->hex128(buf, v[k % BENCH_N]));
+	__asm__ volatile("" : : "r" (sum));
+	printf("%-8s utoa64 %6.2f ns  utoa128 %6.2f ns  aton128 %6.2f ns  hex64 %6.2f ns  hex128 %6.2f ns\n",
+		   uint_cpu_level_name(level), t1, t2, t3, t4, t5);
+}
+
+int
+main(int argc, char **argv)
+{
+	uint_cpu_level max = uint_cpu_detect();
+	uint_cpu_level level;
+
+	if (argc > 1 && !strcmp(argv[1], "bench")) {
+		uint128_t *v = malloc(BENCH_N * sizeof(uint128_t));
+		char (*text)[BUFSZ] = malloc(BENCH_N * BUFSZ);
+		unsigned int k;
+
+		for (k = 0; k < BENCH_N; ++k) {
+			v[k] = (((uint128_t) rand64() << 64) | rand64()) >> (rand64() % 128);
+			utoa128(text[k], v[k]);
+		}
+		for (level = UINT_CPU_GENERIC; level <= max; ++level)
+			bench(level, v, text);
+		free(text);
+		free(v);
+		return 0;
+	}
+	for (level = UINT_CPU_GENERIC + 1; level < UINT_CPU_LEVELS; ++level) {
+		if (level > max) {
+			printf("%-8s not supported by this CPU, skipped\n", uint_cpu_level_name(level));
+			continue;
+		}
+		testlevel(level);
+	}
+	puts("all tests passed");
+	return 0;
+}
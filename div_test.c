@@ -0,0 +1,188 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <assert.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+
+typedef __uint128_t uint128_t;
+
+#include "divide.h"
+
+/*
+ * divide.h test program; "div_test bench" also times it against the
+ * plain 128-bit / and % it replaced
+ */
+
+static uint64_t
+rand64(void)
+{
+	static uint64_t x = 0x9e3779b97f4a7c15ULL;	/* xorshift64* */
+	x ^= x >> 12; x ^= x << 25; x ^= x >> 27;
+	return x * 0x2545f4914f6cdd1dULL;
+}
+
+/* values around 2^k and random values of every width */
+static uint128_t
+interesting(unsigned int i)
+{
+	unsigned int k = i % 129;
+	uint128_t p = k == 128 ? 0 : (uint128_t) 1 << k;
+	switch (i / 129 % 4) {
+		case 0: return p - 1;
+		case 1: return p;
+		case 2: return p + 1;
+		default: return (((uint128_t) rand64() << 64) | rand64()) >> (128 - (k ? k : 1));
+	}
+}
+
+static void
+check(uint128_t n, uint64_t d)
+{
+	udiv_divisor dv;
+	uint64_t r;
+	uint128_t q;
+
+	udiv_init(&dv, d);
+	q = udiv_qr(n, &dv, &r);
+	assert(q == n / d && r == n % d);
+	assert(udiv_u128(n, d) == n / d && umod_u128(n, d) == n % d);
+}
+
+static void
+testdiv(void)
+{
+	unsigned int i, j;
+	uint64_t count = 0;
+
+	for (i = 0; i < 129 * 4 * 2; ++i) {
+		uint128_t d = interesting(i);
+		if (!d || d >> 64)
+			continue;
+		for (j = 0; j < 129 * 4 * 2; ++j) {
+			check(interesting(j), (uint64_t) d);
+			++count;
+		}
+	}
+	for (i = 0; i < 10000000; ++i) {
+		uint64_t d = rand64() >> (rand64() % 64);
+		uint128_t n = (((uint128_t) rand64() << 64) | rand64()) >> (rand64() % 128);
+		if (d) {
+			check(n, d);
+			++count;
+		}
+	}
+	/* wide divisors take the plain path */
+	for (i = 0; i < 1000000; ++i) {
+		uint128_t d = (((uint128_t) rand64() << 64) | rand64()) >> (rand64() % 64);
+		uint128_t n = (((uint128_t) rand64() << 64) | rand64()) >> (rand64() % 64);
+		assert(udiv_u128(n, d) == n / d && umod_u128(n, d) == n % d);
+	}
+	printf("%llu divisions checked\n", (unsigned long long) count);
+}
+
+/*
+ * benchmark over operands resembling table columns
+ */
+
+#define BENCH_N 8192			/* fits in L1/L2 with the divisors */
+#define BENCH_ROUNDS 200
+
+static double
+now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint128_t *
+payload(const char *name)
+{
+	uint128_t *v = malloc(BENCH_N * sizeof(uint128_t));
+	unsigned int k;
+	for (k = 0; k < BENCH_N; ++k) {
+		if (!strcmp(name, "counter"))	/* small counts */
+			v[k] = rand64() % 1000;
+		else if (!strcmp(name, "epoch_ns"))	/* timestamps in a uint16 column */
+			v[k] = 1700000000000000000ULL + rand64() % 100000000000000000ULL;
+		else if (!strcmp(name, "money"))	/* sums of cents, mostly 64-bit */
+			v[k] = (uint128_t) (rand64() >> (rand64() % 32)) * (rand64() % 1000 + 1);
+		else	/* "hash128": uint16 keys */
+			v[k] = ((uint128_t) rand64() << 64) | rand64();
+	}
+	return v;
+}
+
+/* best of five runs of the loop, in ns per operand */
+#define TIME(result, body) \
+	do { \
+		unsigned int rep_; \
+		result = 1e9; \
+		for (rep_ = 0; rep_ < 5; ++rep_) { \
+			double t_ = now(); \
+			body; \
+			t_ = (now() - t_) * 1e9 / BENCH_N / BENCH_ROUNDS; \
+			if (t_ < result) result = t_; \
+		} \
+	} while (0)
+
+static void
+bench(const char *name, uint64_t divisor, int varying)
+{
+	uint128_t *v = payload(name);
+	uint128_t *dvs = malloc(BENCH_N * sizeof(uint128_t));
+	uint128_t sum1 = 0, sum2 = 0, sum3 = 0;
+	double t1, t2, t3 = 0;
+	udiv_divisor dv;
+	unsigned int k;
+
+	for (k = 0; k < BENCH_N; ++k)
+		dvs[k] = varying ? rand64() % divisor + 1 : divisor;
+	udiv_init(&dv, divisor);
+
+	TIME(t1, for (k = 0; k < BENCH_N * BENCH_ROUNDS; ++k) {
+		sum1 += v[k % BENCH_N] / dvs[k % BENCH_N] + v[k % BENCH_N] % dvs[k % BENCH_N];
+		__asm__ volatile("" : "+r" (sum1));
+	});
+	TIME(t2, for (k = 0; k < BENCH_N * BENCH_ROUNDS; ++k) {
+		sum2 += udiv_u128(v[k % BENCH_N], dvs[k % BENCH_N]) + umod_u128(v[k % BENCH_N], dvs[k % BENCH_N]);
+		__asm__ volatile("" : "+r" (sum2));
+	});
+	if (!varying)
+		TIME(t3, for (k = 0; k < BENCH_N * BENCH_ROUNDS; ++k) {
+			uint64_t r;
+			sum3 += udiv_qr(v[k % BENCH_N], &dv, &r) + r;
+			__asm__ volatile("" : "+r" (sum3));
+		});
+	assert(sum1 == sum2 && (varying || sum1 == sum3));
+	if (varying)
+		printf("%-9s / column < %-20llu 128-bit %6.2f ns  64-bit path %6.2f ns\n",
+			   name, (unsigned long long) divisor, t1, t2);
+	else
+		printf("%-9s / %-29llu 128-bit %6.2f ns  64-bit path %6.2f ns  constant %6.2f ns\n",
+			   name, (unsigned long long) divisor, t1, t2, t3);
+	free(dvs);
+	free(v);
+}
+
+int
+main(int argc, char **argv)
+{
+	if (argc > 1 && !strcmp(argv[1], "bench")) {
+		bench("counter", 10, 0);
+		bench("counter", 7, 1);
+		bench("epoch_ns", 1000000000, 0);
+		bench("epoch_ns", 86400000000000ULL, 0);
+		bench("epoch_ns", 1000000, 1);
+		bench("money", 100, 0);
+		bench("money", 1000, 1);
+		bench("hash128", 1024, 0);
+		bench("hash128", 4093, 0);
+		bench("hash128", 18446744073709551557ULL, 0);
+		return 0;
+	}
+	testdiv();
+	puts("all tests passed");
+	return 0;
+}
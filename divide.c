@@ -0,0 +1,87 @@
+#include <postgres.h>
+#include <fmgr.h>
+
+#include "uint.h"
+#include "divide.h"
+
+/*
+ * / and % with 64-bit and 128-bit results, called by the generated
+ * operators.  They divide magnitudes with the divide.h kernels; a
+ * divisor of at most 64 bits that the planner passes as a constant (or
+ * an external parameter) is prepared once per expression and kept in
+ * fn_extra.
+ *
+ * These stay out of line: the division costs more than the call, and
+ * the operators stay small enough for the JIT to inline.
+ */
+
+typedef struct
+{
+	bool		constant;
+	udiv_divisor div;
+} uint_div_cache;
+
+static inline const udiv_divisor *
+uint_div_const(FunctionCallInfo fcinfo, __uint128_t d)
+{
+	FmgrInfo   *flinfo = fcinfo->flinfo;
+	uint_div_cache *cache;
+
+	if (unlikely(flinfo == NULL))
+		return NULL;
+	cache = (uint_div_cache *) flinfo->fn_extra;
+	if (unlikely(cache == NULL))
+	{
+		cache = (uint_div_cache *) MemoryContextAlloc(flinfo->fn_mcxt,
+													  sizeof(uint_div_cache));
+		cache->constant = !(d >> 64) && get_fn_expr_arg_stable(flinfo, 1);
+		if (cache->constant)
+			udiv_init(&cache->div, (uint64) d);
+		flinfo->fn_extra = cache;
+	}
+	return cache->constant && cache->div.d == d ? &cache->div : NULL;
+}
+
+__uint128_t
+uint128_div(FunctionCallInfo fcinfo, __uint128_t n, __uint128_t d)
+{
+	const udiv_divisor *dv = uint_div_const(fcinfo, d);
+	uint64		r;
+
+	if (dv)
+		return udiv_qr(n, dv, &r);
+	return udiv_u128(n, d);
+}
+
+__uint128_t
+uint128_mod(FunctionCallInfo fcinfo, __uint128_t n, __uint128_t d)
+{
+	const udiv_divisor *dv = uint_div_const(fcinfo, d);
+	uint64		r;
+
+	if (dv)
+	{
+		udiv_qr(n, dv, &r);
+		return r;
+	}
+	return umod_u128(n, d);
+}
+
+/* truncating toward zero like C, for a divisor other than -1 */
+__int128_t
+int128_div(FunctionCallInfo fcinfo, __int128_t n, __int128_t d)
+{
+	__uint128_t q = uint128_div(fcinfo, n < 0 ? -(__uint128_t) n : (__uint128_t) n,
+								d < 0 ? -(__uint128_t) d : (__uint128_t) d);
+
+	return (n < 0) != (d < 0) ? -(__int128_t) q : (__int128_t) q;
+}
+
+__int128_t
+int128_mod(FunctionCallInfo fcinfo, __int128_t n, __int128_t d)
+{
+	__uint128_t r = uint128_mod(fcinfo, n < 0 ? -(__uint128_t) n : (__uint128_t) n,
+								d < 0 ? -(__uint128_t) d : (__uint128_t) d);
+
+	return n < 0 ? -(__int128_t) r : (__int128_t) r;
+}
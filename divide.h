@@ -0,0 +1,160 @@
+/*
+ * Division for the / and % operators with 64-bit and 128-bit results
+ * - operands that both fit in 64 bits use the native 64-bit divide
+ *   instead of __udivti3/__umodti3
+ * - a divisor that stays the same from call to call, such as a
+ *   constant in the query, is prepared once with udiv_init() and then
+ *   divides by multiplying with its reciprocal ("Improved division by
+ *   invariant integers", Möller and Granlund, 2011), one step for a
+ *   64-bit dividend and two for a 128-bit one
+ */
+
+#include <stdint.h>
+
+/* define likely/unlikely if needed */
+#ifdef __GNUC__
+#ifndef likely
+#define likely(x) __builtin_expect(!!(x), 1)
+#endif
+#ifndef unlikely
+#define unlikely(x) __builtin_expect(!!(x), 0)
+#endif
+#endif
+
+#ifndef likely
+#define likely(x) (x)
+#endif
+#ifndef unlikely
+#define unlikely(x) (x)
+#endif
+
+static inline __uint128_t
+udiv_u128(__uint128_t n, __uint128_t d)
+{
+	if (likely(!((n | d) >> 64)))
+		return (uint64_t) n / (uint64_t) d;
+	return n / d;
+}
+
+static inline __uint128_t
+umod_u128(__uint128_t n, __uint128_t d)
+{
+	if (likely(!((n | d) >> 64)))
+		return (uint64_t) n % (uint64_t) d;
+	return n % d;
+}
+
+/* a nonzero divisor of at most 64 bits, prepared by udiv_init() */
+typedef struct
+{
+	uint64_t	d;
+	uint64_t	m;				/* multiplier for 64-bit dividends */
+	int			more;			/* post-shift, plus UDIV_ADD_MARKER */
+	int			shift;			/* leading zeroes of d */
+	uint64_t	dnorm;			/* d << shift */
+	uint64_t	v;				/* floor((2^128 - 1) / dnorm) - 2^64 */
+} udiv_divisor;
+
+#define UDIV_ADD_MARKER 0x40
+#define UDIV_POW2_MARKER 0x80
+
+static inline void
+udiv_init(udiv_divisor *dv, uint64_t d)
+{
+	int			l = 63 - __builtin_clzll(d);
+
+	dv->d = d;
+	dv->shift = 63 - l;
+	dv->dnorm = d << dv->shift;
+	dv->v = (uint64_t) (~(__uint128_t) 0 / dv->dnorm);
+
+	/* the round-up method, as in libdivide's branchful u64 divider */
+	if ((d & (d - 1)) == 0)
+	{
+		dv->m = 0;
+		dv->more = l | UDIV_POW2_MARKER;
+	}
+	else
+	{
+		__uint128_t p = (__uint128_t) 1 << (64 + l);
+		uint64_t	m = (uint64_t) (p / d),
+					rem = (uint64_t) (p % d);
+
+		if (d - rem < ((uint64_t) 1 << l))
+			dv->more = l;
+		else
+		{
+			/* 2^(64+l) / d needs 65 bits: double it and add back n */
+			uint64_t	twice_rem = rem + rem;
+
+			m += m;
+			if (twice_rem >= d || twice_rem < rem)
+				m += 1;
+			dv->more = l | UDIV_ADD_MARKER;
+		}
+		dv->m = m + 1;
+	}
+}
+
+/* n / d for a 64-bit n */
+static inline uint64_t
+udiv_q64(uint64_t n, const udiv_divisor *dv)
+{
+	uint64_t	q;
+
+	if (dv->more & UDIV_POW2_MARKER)
+		return n >> (dv->more & 0x3f);
+	q = (uint64_t) (((__uint128_t) dv->m * n) >> 64);
+	if (dv->more & UDIV_ADD_MARKER)
+		q += (n - q) >> 1;
+	return q >> (dv->more & 0x3f);
+}
+
+/* (u1 * 2^64 + u0) / dnorm for u1 < dnorm, the remainder in *r */
+static inline uint64_t
+udiv_qr_preinv(uint64_t u1, uint64_t u0, const udiv_divisor *dv, uint64_t *r)
+{
+	__uint128_t q = (__uint128_t) dv->v * u1 + ((__uint128_t) u1 << 64 | u0);
+	uint64_t	q1 = (uint64_t) (q >> 64) + 1;
+	uint64_t	rem = u0 - q1 * dv->dnorm;
+	uint64_t	mask = -(uint64_t) (rem > (uint64_t) q);	/* unpredictable */
+
+	q1 += mask;
+	rem += mask & dv->dnorm;
+	if (unlikely(rem >= dv->dnorm))
+	{
+		q1++;
+		rem -= dv->dnorm;
+	}
+	*r = rem;
+	return q1;
+}
+
+/* n / d, the remainder in *r */
+static inline __uint128_t
+udiv_qr(__uint128_t n, const udiv_divisor *dv, uint64_t *r)
+{
+	uint64_t	hi = (uint64_t) (n >> 64),
+				lo = (uint64_t) n,
+				q1,
+				q0;
+	int			s = dv->shift;
+
+	if (likely(hi == 0))
+	{
+		q0 = udiv_q64(lo, dv);
+		*r = lo - q0 * dv->d;
+		return q0;
+	}
+	/* high half, then (its remainder * 2^64 + low half) normalized */
+	q1 = udiv_q64(hi, dv);
+	hi -= q1 * dv->d;
+	if (s)
+	{
+		hi = hi << s | lo >> (64 - s);
+		lo <<= s;
+	}
+	q0 = udiv_qr_preinv(hi, lo, dv, r);
+	*r >>= s;
+	return (__uint128_t) q1 << 64 | q0;
+}
@@ -4,6 +4,11 @@ import sys
 
 new_types = ['int1', 'uint1', 'uint2', 'uint4', 'uint8', 'int16', 'uint16']
 old_types = ['int2', 'int4', 'int8']
+aligned_types = {'int16a': 'int16', 'uint16a': 'uint16'}
+range_subtypes = ['uint4', 'uint8', 'int16', 'uint16']
+prefix_addr_types = ['uint4', 'uint16']
+# compared against the integer types without converting the integer
+cmp_float_types = {'numeric': 'numeric_ops', 'float8': 'float_ops'}
 
 comparison_ops = ['<', '<=', '=', '<>', '>=', '>']
 arithmetic_ops = ['+', '-', '*', '/', '%']
@@ -22,6 +27,7 @@ commutators = {
     '&': '&',
     '|': '|',
     '#': '#',
+    '<->': '<->',
 }
 
 negators = {
@@ -42,6 +48,15 @@ restriction_estimators = {
     '>=': 'scalargtsel',
 }
 
+# on PostgreSQL 11 and later, estimators that interpolate within the
+# histogram bins of our types (selectivity.c)
+uint_restriction_estimators = {
+    '<': 'uint_scalarltsel',
+    '<=': 'uint_scalarlesel',
+    '>': 'uint_scalargtsel',
+    '>=': 'uint_scalargesel',
+}
+
 join_estimators = {
     '=': 'eqjoinsel',
     '<>': 'neqjoinsel',
@@ -55,10 +70,31 @@ op_words = {
     '<': 'lt', '<=': 'le', '=': 'eq', '<>': 'ne', '>=': 'ge', '>': 'gt',
     '+': 'pl', '-': 'mi', '*': 'mul', '/': 'div', '%': 'mod',
     '&': 'and', '|': 'or', '#': 'xor', '~': 'not', '<<': 'shl', '>>': 'shr',
+    '<->': 'dist',
+}
+
+native_types = {
+    'int16': '__int128_t',
+    'uint16': '__uint128_t'
 }
 
+overflow_builtins = {
+    '+': '__builtin_add_overflow',
+    '-': '__builtin_sub_overflow',
+    '*': '__builtin_mul_overflow',
+}
+
+
+def overflow_builtin(op, rettype):
+    # signed 128-bit products go through overflow.h, see there
+    if op == '*' and rettype == 'int16':
+        return 'int128_mul_overflow'
+    return overflow_builtins[op]
+
 c_types = {
     'boolean': 'bool',
+    'float8': 'float8',
+    'numeric': 'Numeric',
     'int1': 'int8',
     'int2': 'int16',
     'int4': 'int32',
@@ -138,8 +174,6 @@ def next_bigger_type(typ):
 
 
 def write_c_function(f, funcname, argtypes, rettype, body):
-    body = body.replace("result = arg1 + arg2;\n\nif (SAMESIGN(arg1, arg2) && !SAMESIGN(result, arg1))", "if (__builtin_add_overflow(arg1, arg2, &result))");
-    body = body.replace("result = arg1 - arg2;\n\nif (!SAMESIGN(arg1, arg2) && !SAMESIGN(result, arg1))", "if (__builtin_sub_overflow(arg1, arg2, &result))");
     f.write("""
 PG_FUNCTION_INFO_V1({funcname});
 Datum
@@ -194,30 +228,28 @@ Datum
 """.format(c_types[rettype].upper()))
 
 
-def write_sql_function(f, funcname, argtypes, rettype, sql_funcname=None, strict=True):
+def write_sql_function(f, funcname, argtypes, rettype, sql_funcname=None, strict=True, support=None):
     if not sql_funcname:
         sql_funcname = funcname
     f.write("CREATE FUNCTION {sql_funcname}({argtypes}) RETURNS {rettype}"
-            " IMMUTABLE{strict} LANGUAGE C AS '$libdir/uint', '{funcname}';\n\n"
+            " IMMUTABLE{strict} PARALLEL SAFE{support} LANGUAGE C AS '$libdir/uint', '{funcname}';\n\n"
             .format(sql_funcname=sql_funcname,
                     argtypes=', '.join([x for x in argtypes if x]),
                     rettype=rettype,
                     strict=(" STRICT" if strict else ""),
+                    support=(" SUPPORT " + support if support else ""),
                     funcname=funcname))
 
 
-def write_op_c_function(f, funcname, leftarg, rightarg, op, rettype, c_check='', intermediate_type=None):
+def write_op_c_function(f, funcname, leftarg, rightarg, op, rettype, c_check=''):
     body = ""
-    if intermediate_type:
-        body += "{0} intermediate;\n\n".format(c_types[intermediate_type])
+    # the C division overflows, or traps, for the minimum value by -1
+    negate = op == '/' and type_signed(rettype) and type_signed(rightarg)
+    if negate:
+        body += "{0} value;\n\n".format(native_types.get(rettype, c_types[rettype]))
     if op in ['/', '%']:
         body += """if (arg2 == 0)
-{
-\tereport(ERROR,
-\t\t(errcode(ERRCODE_DIVISION_BY_ZERO),
-\t\t errmsg("division by zero")));
-\tPG_RETURN_NULL();
-}
+\tuint_division_by_zero_error();
 
 """
     if op == '%' and not type_unsigned(rightarg):
@@ -225,39 +257,62 @@ def write_op_c_function(f, funcname, leftarg, rightarg, op, rettype, c_check='',
 \tPG_RETURN_{0}(0);
 
 """.format(c_types[rettype].upper())
-    if intermediate_type:
-        body += "intermediate = "
+    if c_check:
+        body += """if ({0})
+\tuint_out_of_range_error();
+
+""".format(c_check)
+    if op in overflow_builtins and leftarg and rightarg:
+        # the builtins compute the exact result of any two operands
+        # and report whether it fits the result type
+        if type_128(rettype):
+            # not straight into result->i, which is only 8-byte aligned
+            body += "{0} value;\n\nif ({1}(arg1, arg2, &value))".format(
+                native_types[rettype], overflow_builtin(op, rettype))
+        else:
+            body += "if ({0}(arg1, arg2, &result))".format(overflow_builtins[op])
+        body += "\n\tuint_out_of_range_error();"
+        if type_128(rettype):
+            body += "\nresult = value;"
+    elif op in ['/', '%']:
+        if type_bits(rettype) >= 64:
+            # divide.h fast paths, see divide.c
+            expr = "{0}128_{1}(fcinfo, arg1, arg2)".format(
+                'int' if type_signed(rettype) else 'uint', op_words[op])
+        else:
+            expr = "arg1 {0} arg2".format(op)
+        if negate:
+            body += """if (arg2 == -1)
+{{
+\tif (__builtin_sub_overflow(0, arg1, &value))
+\t\tuint_out_of_range_error();
+}}
+else
+\tvalue = {0};
+result = value;""".format(expr)
+        else:
+            body += "result = {0};".format(expr)
     else:
         body += "result = "
-    if leftarg:
-        if intermediate_type:
-            body += "({0})".format(c_types[intermediate_type])
-        body += "arg1"
-    body += " " + c_operator(op) + " "
-    if rightarg:
-        if intermediate_type:
-            body += "({0})".format(c_types[intermediate_type])
-        body += "arg2"
-    body += ";"
-    if c_check:
-        body += """
-
-if ({0})
-\tereport(ERROR,
-\t\t(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
-\t\t errmsg("integer out of range")));""".format(c_check)
-    if intermediate_type:
-        body += "\nresult = intermediate;"
+        if leftarg:
+            body += "arg1"
+        body += " " + c_operator(op) + " "
+        if rightarg:
+            body += "arg2"
+        body += ";"
 
     write_c_function(f, funcname, [leftarg, rightarg], rettype, body)
 
 
-def write_sql_operator(f, funcname, leftarg, rightarg, op, rettype):
-    sql_funcname = funcname
+def write_sql_operator(f, funcname, leftarg, rightarg, op, rettype, sql_funcname=None,
+                       joinable=True, support=None):
+    if not sql_funcname:
+        sql_funcname = funcname
     if op == '%':
         # SQL standard requires a "mod" function rather than % operator
         sql_funcname = 'mod'
-    write_sql_function(f, funcname, [leftarg, rightarg], rettype, sql_funcname=sql_funcname)
+    write_sql_function(f, funcname, [leftarg, rightarg], rettype, sql_funcname=sql_funcname,
+                       support=support)
 
     f.write("CREATE OPERATOR {0} (\n".format(op))
     if leftarg:
@@ -272,7 +327,7 @@ def write_sql_operator(f, funcname, leftarg, rightarg, op, rettype):
         f.write("    RESTRICT = {0},\n".format(restriction_estimators[op]))
     if op in join_estimators:
         f.write("    JOIN = {0},\n".format(join_estimators[op]))
-    if op in ['=']:
+    if op in ['='] and joinable:
         f.write("    HASHES,\n")
         f.write("    MERGES,\n")
     f.write("    PROCEDURE = {0}\n);\n\n".format(sql_funcname))
@@ -288,6 +343,75 @@ def write_cmp_sql_function(f, leftarg, rightarg):
     write_sql_function(f, funcname, [leftarg, rightarg], 'integer')
 
 
+def write_abbrev_c_functions(f, pgversion):
+    # abbreviated keys for the 128-bit types hold the high 64 bits, biased
+    # so that they compare as unsigned Datums; the abort test follows core
+    # (uuid_abbrev_abort) and gives up when the high halves rarely differ
+    f.write("""\
+#if SIZEOF_DATUM == 8
+#include <access/hash.h>
+#include <lib/hyperloglog.h>
+
+typedef struct
+{
+\tint64\t\tinput_count;
+\tbool\t\testimating;
+\thyperLogLogState abbr_card;
+} Uint128AbbrevState;
+
+static bool
+uint128_abbrev_abort(int memtupcount, SortSupport ssup)
+{
+\tUint128AbbrevState *state = (Uint128AbbrevState *) ssup->ssup_extra;
+\tdouble\t\tabbr_card;
+
+\tif (memtupcount < 10000 || state->input_count < 10000 || !state->estimating)
+\t\treturn false;
+
+\tabbr_card = estimateHyperLogLog(&state->abbr_card);
+
+\t/* plenty of distinct high halves: stop estimating, keep abbreviating */
+\tif (abbr_card > 100000.0)
+\t{
+\t\tstate->estimating = false;
+\t\treturn false;
+\t}
+
+\treturn abbr_card < state->input_count / 2000.0 + 0.5;
+}
+
+static void
+uint128_abbrev_count(Uint128AbbrevState *state, uint64 key)
+{
+\tstate->input_count++;
+\tif (state->estimating)
+\t\taddHyperLogLog(&state->abbr_card,
+\t\t\t\t\t   DatumGetUInt32(hash_uint32((uint32) key ^ (uint32) (key >> 32))));
+}
+""")
+    if pgversion < 15:
+        f.write("""
+static int
+uint128_abbrev_cmp(Datum x, Datum y, SortSupport ssup)
+{
+\treturn (x > y) - (x < y);
+}
+""")
+    f.write("""#endif
+
+""")
+    if pgversion >= 15:
+        f.write("""\
+/* abbreviated keys of the pass-by-value types are the values themselves */
+static bool
+uint_abbrev_abort(int memtupcount, SortSupport ssup)
+{
+\treturn false;
+}
+
+""")
+
+
 def write_sortsupport_c_function(f, typ, pgversion):
     if pgversion >= 9.2:
         if type_128(typ):
@@ -300,7 +424,23 @@ bt{typ}fastcmp(Datum x, Datum y, SortSupport ssup)
 
 \treturn (a->i > b->i) - (a->i < b->i);
 }}
+""".format(typ=typ, ctype=c_types[typ], Ctype=c_types[typ]))
+            if pgversion >= 9.5:
+                f.write("""
+#if SIZEOF_DATUM == 8
+static Datum
+bt{typ}abbrevconvert(Datum original, SortSupport ssup)
+{{
+\t{ctype} *a = ({Ctype} *)DatumGetPointer(original);
+\tuint64\t\tkey = (uint64) (a->i >> 64){bias};
 
+\tuint128_abbrev_count((Uint128AbbrevState *) ssup->ssup_extra, key);
+\treturn UInt64GetDatum(key);
+}}
+#endif
+""".format(typ=typ, ctype=c_types[typ], Ctype=c_types[typ],
+           bias=(' ^ ((uint64) 1 << 63)' if not type_unsigned(typ) else '')))
+            f.write("""
 PG_FUNCTION_INFO_V1(bt{typ}sortsupport);
 Datum
 bt{typ}sortsupport(PG_FUNCTION_ARGS)
@@ -308,10 +448,45 @@ bt{typ}sortsupport(PG_FUNCTION_ARGS)
 \tSortSupport ssup = (SortSupport) PG_GETARG_POINTER(0);
 
 \tssup->comparator = bt{typ}fastcmp;
+""".format(typ=typ))
+            if pgversion >= 9.5:
+                f.write("""#if SIZEOF_DATUM == 8
+\tif (ssup->abbreviate)
+\t{{
+\t\tMemoryContext oldcontext = MemoryContextSwitchTo(ssup->ssup_cxt);
+\t\tUint128AbbrevState *state = palloc(sizeof(Uint128AbbrevState));
+
+\t\tstate->input_count = 0;
+\t\tstate->estimating = true;
+\t\tinitHyperLogLog(&state->abbr_card, 10);
+\t\tssup->ssup_extra = state;
+\t\tssup->comparator = {abbrevcmp};
+\t\tssup->abbrev_converter = bt{typ}abbrevconvert;
+\t\tssup->abbrev_abort = uint128_abbrev_abort;
+\t\tssup->abbrev_full_comparator = bt{typ}fastcmp;
+\t\tMemoryContextSwitchTo(oldcontext);
+\t}}
+#endif
+""".format(typ=typ, abbrevcmp=('ssup_datum_unsigned_cmp' if pgversion >= 15 else 'uint128_abbrev_cmp')))
+            f.write("""\tPG_RETURN_VOID();
+}
+""")
+        elif pgversion >= 15 and typ == 'uint8':
+            # the whole value is the Datum, so the core comparator and its
+            # specialized qsort apply directly
+            f.write("""
+PG_FUNCTION_INFO_V1(bt{typ}sortsupport);
+Datum
+bt{typ}sortsupport(PG_FUNCTION_ARGS)
+{{
+\tSortSupport ssup = (SortSupport) PG_GETARG_POINTER(0);
+
+\tssup->comparator = ssup_datum_unsigned_cmp;
 \tPG_RETURN_VOID();
 }}
-""".format(typ=typ, ctype=c_types[typ], Ctype=c_types[typ]))
+""".format(typ=typ))
         else:
+            Ctype = c_types[typ].replace('u', 'U').replace('i', 'I')
             f.write("""
 static int
 bt{typ}fastcmp(Datum x, Datum y, SortSupport ssup)
@@ -321,7 +496,21 @@ bt{typ}fastcmp(Datum x, Datum y, SortSupport ssup)
 
 \treturn (a > b) - (a < b);
 }}
-
+""".format(typ=typ, ctype=c_types[typ], Ctype=Ctype))
+            if pgversion >= 15:
+                # stored narrow values come back sign- or zero-extended
+                # depending on the width and the platform's char, so the
+                # abbreviated key rebuilds a canonical Datum for the core
+                # comparators
+                f.write("""
+static Datum
+bt{typ}abbrevconvert(Datum original, SortSupport ssup)
+{{
+\treturn {conv};
+}}
+""".format(typ=typ, conv=('Int32GetDatum(DatumGet{0}(original))' if not type_unsigned(typ)
+                          else '(Datum) DatumGet{0}(original)').format(Ctype)))
+            f.write("""
 PG_FUNCTION_INFO_V1(bt{typ}sortsupport);
 Datum
 bt{typ}sortsupport(PG_FUNCTION_ARGS)
@@ -329,9 +518,117 @@ bt{typ}sortsupport(PG_FUNCTION_ARGS)
 \tSortSupport ssup = (SortSupport) PG_GETARG_POINTER(0);
 
 \tssup->comparator = bt{typ}fastcmp;
+""".format(typ=typ))
+            if pgversion >= 15:
+                f.write("""\tif (ssup->abbreviate)
+\t{{
+\t\tssup->comparator = {abbrevcmp};
+\t\tssup->abbrev_converter = bt{typ}abbrevconvert;
+\t\tssup->abbrev_abort = uint_abbrev_abort;
+\t\tssup->abbrev_full_comparator = bt{typ}fastcmp;
+\t}}
+""".format(typ=typ, abbrevcmp=('ssup_datum_int32_cmp' if not type_unsigned(typ)
+                               else 'ssup_datum_unsigned_cmp')))
+            f.write("""\tPG_RETURN_VOID();
+}
+""")
+
+skip_limits = {
+    'int1': ('PG_INT8_MIN', 'PG_INT8_MAX'),
+    'uint1': ('0', 'PG_UINT8_MAX'),
+    'uint2': ('0', 'PG_UINT16_MAX'),
+    'uint4': ('0', 'PG_UINT32_MAX'),
+    'uint8': ('0', 'PG_UINT64_MAX'),
+    'int16': ('(__int128_t) ((__uint128_t) 1 << 127)', '(__int128_t) (~(__uint128_t) 0 >> 1)'),
+    'uint16': ('0', '~(__uint128_t) 0'),
+}
+
+
+def write_skipsupport_c_function(f, typ):
+    low, high = skip_limits[typ]
+    if type_128(typ):
+        for func, flag, limit, op in (('decrement', 'underflow', low, '-'),
+                                      ('increment', 'overflow', high, '+')):
+            f.write("""
+static Datum
+{typ}_{func}(Relation rel, Datum existing, bool *{flag})
+{{
+\t{ctype} *a = ({ctype} *) DatumGetPointer(existing);
+\t{ctype} *result;
+
+\tif (a->i == {limit})
+\t{{
+\t\t*{flag} = true;
+\t\treturn (Datum) 0;
+\t}}
+\t*{flag} = false;
+\tresult = ({ctype} *) palloc(sizeof({ctype}));
+\tresult->i = a->i {op} 1;
+\treturn PointerGetDatum(result);
+}}
+""".format(typ=typ, ctype=c_types[typ], func=func, flag=flag, limit=limit, op=op))
+        f.write("""
+PG_FUNCTION_INFO_V1(bt{typ}skipsupport);
+Datum
+bt{typ}skipsupport(PG_FUNCTION_ARGS)
+{{
+\tSkipSupport sksup = (SkipSupport) PG_GETARG_POINTER(0);
+\t{ctype} *low = ({ctype} *) palloc(sizeof({ctype}));
+\t{ctype} *high = ({ctype} *) palloc(sizeof({ctype}));
+
+\tlow->i = {low};
+\thigh->i = {high};
+\tsksup->decrement = {typ}_decrement;
+\tsksup->increment = {typ}_increment;
+\tsksup->low_elem = PointerGetDatum(low);
+\tsksup->high_elem = PointerGetDatum(high);
+\tPG_RETURN_VOID();
+}}
+""".format(typ=typ, ctype=c_types[typ], low=low, high=high))
+    else:
+        Ctype = c_types[typ].replace('u', 'U').replace('i', 'I')
+        f.write("""
+static Datum
+{typ}_decrement(Relation rel, Datum existing, bool *underflow)
+{{
+\t{ctype} v = DatumGet{Ctype}(existing);
+
+\tif (v == {low})
+\t{{
+\t\t*underflow = true;
+\t\treturn (Datum) 0;
+\t}}
+\t*underflow = false;
+\treturn {Ctype}GetDatum(v - 1);
+}}
+
+static Datum
+{typ}_increment(Relation rel, Datum existing, bool *overflow)
+{{
+\t{ctype} v = DatumGet{Ctype}(existing);
+
+\tif (v == {high})
+\t{{
+\t\t*overflow = true;
+\t\treturn (Datum) 0;
+\t}}
+\t*overflow = false;
+\treturn {Ctype}GetDatum(v + 1);
+}}
+
+PG_FUNCTION_INFO_V1(bt{typ}skipsupport);
+Datum
+bt{typ}skipsupport(PG_FUNCTION_ARGS)
+{{
+\tSkipSupport sksup = (SkipSupport) PG_GETARG_POINTER(0);
+
+\tsksup->decrement = {typ}_decrement;
+\tsksup->increment = {typ}_increment;
+\tsksup->low_elem = {Ctype}GetDatum({low});
+\tsksup->high_elem = {Ctype}GetDatum({high});
 \tPG_RETURN_VOID();
 }}
-""".format(typ=typ, ctype=c_types[typ], Ctype=c_types[typ].replace('u', 'U').replace('i', 'I')))
+""".format(typ=typ, ctype=c_types[typ], Ctype=Ctype, low=low, high=high))
 
 
 def write_opclasses_sql(f, typ, pgversion):
@@ -346,23 +643,351 @@ def write_opclasses_sql(f, typ, pgversion):
     if pgversion >= 9.2:
         f.write(""",
         FUNCTION        2       bt{typ}sortsupport(internal)""".format(typ=typ))
+    if pgversion >= 13:
+        # equal values are bitwise equal, so btree deduplication is safe
+        f.write(""",
+        FUNCTION        4       btequalimage(oid)""")
+    if pgversion >= 18:
+        f.write(""",
+        FUNCTION        6       bt{typ}skipsupport(internal)""".format(typ=typ))
     f.write(""";
 
 CREATE OPERATOR CLASS {typ}_ops
     DEFAULT FOR TYPE {typ} USING hash FAMILY integer_ops AS
         OPERATOR        1       =,
-        FUNCTION        1       hash{typ}({typ});
+        FUNCTION        1       hash{typ}({typ})""".format(typ=typ))
+    if pgversion >= 11:
+        f.write(""",
+        FUNCTION        2       hash{typ}extended({typ}, int8)""".format(typ=typ))
+    f.write(""";
+
+""")
+
+
+def write_brin_opclasses_sql(f, typ, pgversion):
+    # The support functions are the generic ones from core; they look up
+    # the comparison operators (and for bloom, the hash function) through
+    # the operator family.
+    f.write("""CREATE OPERATOR CLASS {typ}_minmax_ops
+    DEFAULT FOR TYPE {typ} USING brin FAMILY integer_minmax_ops AS
+        OPERATOR        1       < ,
+        OPERATOR        2       <= ,
+        OPERATOR        3       = ,
+        OPERATOR        4       >= ,
+        OPERATOR        5       > ,
+        FUNCTION        1       brin_minmax_opcinfo(internal),
+        FUNCTION        2       brin_minmax_add_value(internal, internal, internal, internal),
+        FUNCTION        3       brin_minmax_consistent(internal, internal, internal),
+        FUNCTION        4       brin_minmax_union(internal, internal, internal),
+        STORAGE         {typ};
+
+""".format(typ=typ))
+    if pgversion >= 14:
+        f.write("""CREATE OPERATOR CLASS {typ}_minmax_multi_ops
+    FOR TYPE {typ} USING brin FAMILY integer_minmax_multi_ops AS
+        OPERATOR        1       < ,
+        OPERATOR        2       <= ,
+        OPERATOR        3       = ,
+        OPERATOR        4       >= ,
+        OPERATOR        5       > ,
+        FUNCTION        1       brin_minmax_multi_opcinfo(internal),
+        FUNCTION        2       brin_minmax_multi_add_value(internal, internal, internal, internal),
+        FUNCTION        3       brin_minmax_multi_consistent(internal, internal, internal, int4),
+        FUNCTION        4       brin_minmax_multi_union(internal, internal, internal),
+        FUNCTION        5       brin_minmax_multi_options(internal),
+        FUNCTION        11      brin_minmax_multi_distance_{typ}(internal, internal),
+        STORAGE         {typ};
+
+CREATE OPERATOR CLASS {typ}_bloom_ops
+    FOR TYPE {typ} USING brin FAMILY integer_bloom_ops AS
+        OPERATOR        1       = ,
+        FUNCTION        1       brin_bloom_opcinfo(internal),
+        FUNCTION        2       brin_bloom_add_value(internal, internal, internal, internal),
+        FUNCTION        3       brin_bloom_consistent(internal, internal, internal, int4),
+        FUNCTION        4       brin_bloom_union(internal, internal, internal),
+        FUNCTION        5       brin_bloom_options(internal),
+        FUNCTION        11      hash{typ}({typ}),
+        STORAGE         {typ};
+
+""".format(typ=typ))
+
+
+def write_gin_opclass_sql(f, typ):
+    write_sql_function(f, 'gin_uint_extract_value', [typ, 'internal'], 'internal',
+                       sql_funcname='gin_extract_value_' + typ)
+    write_sql_function(f, 'gin_extract_query_' + typ, [typ, 'internal', 'int2', 'internal', 'internal'],
+                       'internal')
+    write_sql_function(f, 'gin_uint_compare_prefix', [typ, typ, 'int2', 'internal'], 'int4',
+                       sql_funcname='gin_compare_prefix_' + typ)
+    f.write("""CREATE OPERATOR CLASS {typ}_ops
+    DEFAULT FOR TYPE {typ} USING gin AS
+        OPERATOR        1       < ,
+        OPERATOR        2       <= ,
+        OPERATOR        3       = ,
+        OPERATOR        4       >= ,
+        OPERATOR        5       > ,
+        FUNCTION        1       bt{typ}{typ}cmp({typ}, {typ}),
+        FUNCTION        2       gin_extract_value_{typ}({typ}, internal),
+        FUNCTION        3       gin_extract_query_{typ}({typ}, internal, int2, internal, internal),
+        FUNCTION        4       gin_uint_consistent(internal, int2, anyelement, int4, internal, internal),
+        FUNCTION        5       gin_compare_prefix_{typ}({typ}, {typ}, int2, internal),
+        STORAGE         {typ};
+
+""".format(typ=typ))
+
+
+# alignment of the GiST key types, by size of the (lower, upper) pair
+gist_key_types = {2: 'char', 4: 'int2', 8: 'int4', 16: 'double', 32: 'char'}
+
+
+def gist_key_type(typ):
+    return 'uint_gistkey{0}'.format(type_bits(typ) // 4)
+
+
+def write_gist_key_types_sql(f):
+    for size, align in sorted(gist_key_types.items()):
+        keytype = 'uint_gistkey{0}'.format(size)
+        f.write("CREATE TYPE {keytype};\n\n".format(keytype=keytype))
+        write_sql_function(f, 'gist_uint_key_in', ['cstring'], keytype, sql_funcname=keytype + 'in')
+        write_sql_function(f, 'gist_uint_key_out', [keytype], 'cstring', sql_funcname=keytype + 'out')
+        f.write("""CREATE TYPE {keytype} (
+    INPUT = {keytype}in,
+    OUTPUT = {keytype}out,
+    INTERNALLENGTH = {size},
+    ALIGNMENT = {align}
+);
+
+""".format(keytype=keytype, size=size, align=align))
+    write_sql_function(f, 'gist_uint_decompress', ['internal'], 'internal')
+
+
+def dist_type(typ):
+    # The GiST distance is float8, so from 64 bits on <-> returns float8 too:
+    # ORDER BY <-> then sorts on the same rounded value the index returns.
+    if type_bits(typ) >= 64:
+        return 'float8'
+    return typ if type_unsigned(typ) else 'u' + typ
+
+
+def write_dist_operator(f_c, f_sql, typ):
+    # |arg1 - arg2|, computed in the unsigned type of the same width
+    rettype = dist_type(typ)
+    utype = '__uint128_t' if type_128(typ) else c_types[typ if type_unsigned(typ) else 'u' + typ]
+    write_c_function(f_c, typ + typ + op_words['<->'], [typ, typ], rettype,
+                     body="result = (arg1 > arg2) ? ({u}) arg1 - ({u}) arg2 : ({u}) arg2 - ({u}) arg1;"
+                     .format(u=utype))
+    write_sql_operator(f_sql, typ + typ + op_words['<->'], typ, typ, '<->', rettype)
+
+
+def write_gist_opclass_sql(f, typ, pgversion):
+    keytype = gist_key_type(typ)
+    write_sql_function(f, 'gist_{0}_consistent'.format(typ), ['internal', typ, 'int2', 'oid', 'internal'], 'bool')
+    write_sql_function(f, 'gist_{0}_distance'.format(typ), ['internal', typ, 'int2', 'oid', 'internal'], 'float8')
+    write_sql_function(f, 'gist_{0}_compress'.format(typ), ['internal'], 'internal')
+    write_sql_function(f, 'gist_{0}_fetch'.format(typ), ['internal'], 'internal')
+    write_sql_function(f, 'gist_{0}_union'.format(typ), ['internal', 'internal'], keytype)
+    write_sql_function(f, 'gist_{0}_penalty'.format(typ), ['internal', 'internal', 'internal'], 'internal')
+    write_sql_function(f, 'gist_{0}_picksplit'.format(typ), ['internal', 'internal'], 'internal')
+    write_sql_function(f, 'gist_{0}_same'.format(typ), [keytype, keytype, 'internal'], 'internal')
+    f.write("""CREATE OPERATOR CLASS {typ}_ops
+    DEFAULT FOR TYPE {typ} USING gist AS
+        OPERATOR        1       < ,
+        OPERATOR        2       <= ,
+        OPERATOR        3       = ,
+        OPERATOR        4       >= ,
+        OPERATOR        5       > ,
+        OPERATOR        6       <> ,
+        OPERATOR        15      <-> FOR ORDER BY {orderfamily},
+        FUNCTION        1       gist_{typ}_consistent(internal, {typ}, int2, oid, internal),
+        FUNCTION        2       gist_{typ}_union(internal, internal),
+        FUNCTION        3       gist_{typ}_compress(internal),
+        FUNCTION        4       gist_uint_decompress(internal),
+        FUNCTION        5       gist_{typ}_penalty(internal, internal, internal),
+        FUNCTION        6       gist_{typ}_picksplit(internal, internal),
+        FUNCTION        7       gist_{typ}_same({keytype}, {keytype}, internal),
+        FUNCTION        8       gist_{typ}_distance(internal, {typ}, int2, oid, internal)""".format(
+            typ=typ, keytype=keytype,
+            orderfamily='float_ops' if dist_type(typ) == 'float8' else 'integer_ops'))
+    if pgversion >= 9.5:
+        f.write(""",
+        FUNCTION        9       gist_{typ}_fetch(internal)""".format(typ=typ))
+    f.write(""",
+        STORAGE         {keytype};
+
+""".format(keytype=keytype))
+
+
+def write_aligned_types_sql(f, pgversion):
+    # The aligned variants store the same 16 bytes on double alignment.
+    # The in-memory layout is shared, so every support function is the C
+    # function of the base type; anything else goes through the implicit
+    # cast to the base type.
+    for typ, base in aligned_types.items():
+        f.write("CREATE TYPE {typ};\n\n".format(typ=typ))
+        write_sql_function(f, base + 'in', ['cstring'], typ, sql_funcname=typ + 'in')
+        write_sql_function(f, base + 'out', [typ], 'cstring', sql_funcname=typ + 'out')
+        write_sql_function(f, base + 'recv', ['internal'], typ, sql_funcname=typ + 'recv')
+        write_sql_function(f, base + 'send', [typ], 'bytea', sql_funcname=typ + 'send')
+        f.write("""CREATE TYPE {typ} (
+    INPUT = {typ}in,
+    OUTPUT = {typ}out,
+    RECEIVE = {typ}recv,
+    SEND = {typ}send,
+    INTERNALLENGTH = 16,
+    ALIGNMENT = double
+);
 
 """.format(typ=typ))
 
+        write_sql_function(f, 'uint128_realign', [typ], base, sql_funcname=base)
+        write_sql_function(f, 'uint128_realign', [base], typ, sql_funcname=typ)
+        f.write("CREATE CAST ({typ} AS {base}) WITH FUNCTION {base}({typ}) AS IMPLICIT;\n\n"
+                "CREATE CAST ({base} AS {typ}) WITH FUNCTION {typ}({base}) AS ASSIGNMENT;\n\n"
+                .format(typ=typ, base=base))
+
+        for op in comparison_ops:
+            write_sql_operator(f, base + base + op_words[op], typ, typ, op, 'boolean',
+                               sql_funcname=typ + typ + op_words[op])
+        write_sql_function(f, 'bt' + base + base + 'cmp', [typ, typ], 'integer',
+                           sql_funcname='bt' + typ + typ + 'cmp')
+        if pgversion >= 9.2:
+            write_sql_function(f, 'bt' + base + 'sortsupport', ['internal'], 'void',
+                               sql_funcname='bt' + typ + 'sortsupport')
+        if pgversion >= 18:
+            write_sql_function(f, 'bt' + base + 'skipsupport', ['internal'], 'void',
+                               sql_funcname='bt' + typ + 'skipsupport')
+        write_sql_function(f, 'hash' + base, [typ], 'integer', sql_funcname='hash' + typ)
+        if pgversion >= 11:
+            write_sql_function(f, 'hash' + base + 'extended', [typ, 'int8'], 'int8',
+                               sql_funcname='hash' + typ + 'extended')
+        write_opclasses_sql(f, typ, pgversion)
+        if pgversion >= 14:
+            write_sql_function(f, 'brin_minmax_multi_distance_' + base, ['internal', 'internal'], 'float8',
+                               sql_funcname='brin_minmax_multi_distance_' + typ)
+        if pgversion >= 9.5:
+            write_brin_opclasses_sql(f, typ, pgversion)
+
+
+def write_range_types_sql(f, pgversion):
+    # The canonical function takes the range type itself, so it is created
+    # on the shell type first, as in the CREATE TYPE documentation.
+    for typ in range_subtypes:
+        rangetype = typ + 'range'
+        f.write("CREATE TYPE {rangetype};\n\n".format(rangetype=rangetype))
+        write_sql_function(f, rangetype + '_canonical', [rangetype], rangetype)
+        write_sql_function(f, rangetype + '_subdiff', [typ, typ], 'float8')
+        f.write("""CREATE TYPE {rangetype} AS RANGE (
+    SUBTYPE = {typ},
+    SUBTYPE_OPCLASS = {typ}_ops,
+    CANONICAL = {rangetype}_canonical,
+    SUBTYPE_DIFF = {rangetype}_subdiff""".format(typ=typ, rangetype=rangetype))
+        if pgversion >= 14:
+            f.write(""",
+    MULTIRANGE_TYPE_NAME = {typ}multirange""".format(typ=typ))
+        f.write("\n);\n\n")
+
+
+def write_prefix_types_sql(f):
+    write_sql_function(f, 'spg_uint_prefix_config', ['internal', 'internal'], 'void')
+    for addr in prefix_addr_types:
+        typ = addr + 'prefix'
+        write_sql_function(f, typ + 'in', ['cstring'], typ)
+        write_sql_function(f, typ + 'out', [typ], 'cstring')
+        write_sql_function(f, typ + 'recv', ['internal'], typ)
+        write_sql_function(f, typ + 'send', [typ], 'bytea')
+        f.write("""CREATE TYPE {typ} (
+    INPUT = {typ}in,
+    OUTPUT = {typ}out,
+    RECEIVE = {typ}recv,
+    SEND = {typ}send,
+    INTERNALLENGTH = {size},
+    ALIGNMENT = char
+);
+
+""".format(typ=typ, size=int(addr[4:]) + 1))
+        write_sql_function(f, typ + '_make', [addr, 'int4'], typ, sql_funcname=typ)
+        write_sql_function(f, typ + '_masklen', [typ], 'int4', sql_funcname='masklen')
+        write_sql_function(f, typ + '_lower', [typ], addr, sql_funcname='lower')
+        write_sql_function(f, typ + '_upper', [typ], addr, sql_funcname='upper')
+
+        # (function suffix, operator, commutator, negator, restrict, join,
+        #  left and right argument types)
+        for suffix, op, com, neg, rest, join, leftarg, rightarg in (
+                ('eq', '=', '=', '<>', 'eqsel', 'eqjoinsel', typ, typ),
+                ('ne', '<>', '<>', '=', 'neqsel', 'neqjoinsel', typ, typ),
+                ('overlap', '&&', '&&', None, 'contsel', 'contjoinsel', typ, typ),
+                ('sub', '<<', '>>', None, 'contsel', 'contjoinsel', typ, typ),
+                ('subeq', '<<=', '>>=', None, 'contsel', 'contjoinsel', typ, typ),
+                ('sup', '>>', '<<', None, 'contsel', 'contjoinsel', typ, typ),
+                ('supeq', '>>=', '<<=', None, 'contsel', 'contjoinsel', typ, typ),
+                ('supeq_addr', '>>=', '<<=', None, 'contsel', 'contjoinsel', typ, addr),
+                ('addr_subeq', '<<=', '>>=', None, 'contsel', 'contjoinsel', addr, typ)):
+            funcname = typ + '_' + suffix
+            write_sql_function(f, funcname, [leftarg, rightarg], 'boolean')
+            f.write("CREATE OPERATOR {0} (\n".format(op))
+            f.write("    LEFTARG = {0},\n".format(leftarg))
+            f.write("    RIGHTARG = {0},\n".format(rightarg))
+            f.write("    COMMUTATOR = {0},\n".format(com))
+            if neg:
+                f.write("    NEGATOR = {0},\n".format(neg))
+            f.write("    RESTRICT = {0},\n".format(rest))
+            f.write("    JOIN = {0},\n".format(join))
+            f.write("    PROCEDURE = {0}\n);\n\n".format(funcname))
+
+        for func in ['choose', 'picksplit', 'inner_consistent', 'leaf_consistent']:
+            write_sql_function(f, typ + '_spg_' + func, ['internal', 'internal'],
+                               'bool' if func == 'leaf_consistent' else 'void')
+        f.write("""CREATE OPERATOR CLASS {typ}_ops
+    DEFAULT FOR TYPE {typ} USING spgist AS
+        OPERATOR        3       && ,
+        OPERATOR        18      = ,
+        OPERATOR        24      << ,
+        OPERATOR        25      <<= ,
+        OPERATOR        26      >> ,
+        OPERATOR        27      >>= ,
+        OPERATOR        28      >>= ({typ}, {addr}),
+        FUNCTION        1       spg_uint_prefix_config(internal, internal),
+        FUNCTION        2       {typ}_spg_choose(internal, internal),
+        FUNCTION        3       {typ}_spg_picksplit(internal, internal),
+        FUNCTION        4       {typ}_spg_inner_consistent(internal, internal),
+        FUNCTION        5       {typ}_spg_leaf_consistent(internal, internal);
+
+""".format(typ=typ, addr=addr))
+
+
+def write_float_cmp_ops(f_c, f_sql, typ, other, pgversion):
+    """
+    Comparisons between an integer type and numeric or float8 in both
+    directions.  They read the other value's integer part instead of
+    converting the integer, and on PostgreSQL 12 and later a support
+    function turns a constant other value into an integer bound.
+    """
+    cmp_func = '{0}_{1}_cmp'.format('int128' if type_signed(typ) else 'uint128', other)
+    for leftarg, rightarg in [(typ, other), (other, typ)]:
+        if leftarg == typ:
+            cmp_expr = '{0}(arg1, arg2)'.format(cmp_func)
+        else:
+            cmp_expr = '-{0}(arg2, arg1)'.format(cmp_func)
+        for op in comparison_ops:
+            funcname = leftarg + rightarg + op_words[op]
+            write_c_function(f_c, funcname, [leftarg, rightarg], 'boolean',
+                             "result = {0} {1} 0;".format(cmp_expr, c_operator(op)))
+            # equal values of different types don't hash alike
+            write_sql_operator(f_sql, funcname, leftarg, rightarg, op, 'boolean', joinable=False,
+                               support=('{0}_{1}_support'.format(typ, op_words[op])
+                                        if pgversion >= 12 else None))
+        funcname = 'bt' + leftarg + rightarg + 'cmp'
+        write_c_function(f_c, funcname, [leftarg, rightarg], 'int4', "result = {0};".format(cmp_expr))
+        write_sql_function(f_sql, funcname, [leftarg, rightarg], 'int4')
+
 
 def coalesce(*args):
     return next((a for a in args if a is not None), None)
 
 
-def write_code(f_c, f_sql, leftarg, rightarg, op, rettype, c_check='', intermediate_type=None):
+def write_code(f_c, f_sql, leftarg, rightarg, op, rettype, c_check=''):
     funcname = coalesce(leftarg, '') + coalesce(rightarg, '') + op_words[op]
-    write_op_c_function(f_c, funcname, leftarg, rightarg, op, rettype, c_check, intermediate_type)
+    write_op_c_function(f_c, funcname, leftarg, rightarg, op, rettype, c_check)
     write_sql_operator(f_sql, funcname, leftarg, rightarg, op, rettype)
 
 
@@ -376,29 +1001,27 @@ sum_trans_types = {
     'uint16': 'uint16'
 }
 
-avg_trans_types = {
-    'int1': '_int8',
-    'uint1': '_int8',
-    'uint2': '_int8',
-    'uint4': '_int8',
-    'uint8': 'uint8[]',
-    'int16': 'int16[]',
-    'uint16': 'uint16[]'
-}
-
-avg_final_funcs = {
-    'int1': 'int8_avg',
-    'uint1': 'int8_avg',
-    'uint2': 'int8_avg',
-    'uint4': 'int8_avg',
-    'uint8': 'uint8_avg',
-    'int16': 'int16_avg',
-    'uint16': 'uint16_avg'
+sum_combine_funcs = {
+    'int1': 'int4pl',
+    'uint1': 'uint4uint4pl',
+    'uint2': 'uint8uint8pl',
+    'uint4': 'uint8uint8pl',
+    'uint8': 'uint8_sum',
+    'int16': 'int16_sum',
+    'uint16': 'uint16_sum'
 }
 
-def write_arithmetic_op(f_c, f_sql, f_test_sql, op, leftarg, rightarg):
+def arithmetic_rettype(leftarg, rightarg):
     args = sorted([leftarg, rightarg], key=lambda x: (type_bits(x), type_unsigned(x)))
-    rettype = args[-1]
+    return args[-1]
+
+
+def legacy_overflow_check(op, leftarg, rightarg):
+    # The overflow checks generated for +, - and * before they used the
+    # builtins, kept for the differential test in arith_test.c.  Returns
+    # the check on result (or intermediate) after computing arg1 op arg2,
+    # and the type of intermediate if one is needed.
+    rettype = arithmetic_rettype(leftarg, rightarg)
     if type_unsigned(rettype):
         if op == '+':
             if type_signed(leftarg):
@@ -414,23 +1037,6 @@ def write_arithmetic_op(f_c, f_sql, f_test_sql, op, leftarg, rightarg):
                 c_check = '(arg2 < 0 && result < arg1) || (arg2 > 0 && result > arg1)'
             else:
                 c_check = 'result > arg1'
-        elif op == '/':
-            if type_signed(leftarg):
-                c_check = 'arg1 < 0'
-            elif type_signed(rightarg):
-                c_check = 'arg2 < 0'
-            else:
-                c_check = ''
-        elif op == '%':
-            if type_signed(leftarg):
-                c_check = 'arg1 < 0'
-            elif type_signed(rightarg):
-                # This computation has a positive result, so it would
-                # actually fit just fine, but the C implementation
-                # makes a mess of it, so better prohibit it.
-                c_check = 'arg2 < 0'
-            else:
-                c_check = ''
         else:
             c_check = ''
     else:
@@ -464,7 +1070,29 @@ def write_arithmetic_op(f_c, f_sql, f_test_sql, op, leftarg, rightarg):
                 c_check += ' && (arg2 != 0 && (result / arg2 != arg1))'
             else:
                 c_check += ' && (arg2 != 0 && ((arg2 == -1 && arg1 < 0 && result < 0) || result / arg2 != arg1))'
-    write_code(f_c, f_sql, leftarg, rightarg, op, rettype, c_check, intermediate_type)
+    return c_check, intermediate_type
+
+
+def write_arithmetic_op(f_c, f_sql, f_test_sql, op, leftarg, rightarg):
+    rettype = arithmetic_rettype(leftarg, rightarg)
+    # +, - and * are checked by write_op_c_function; this is
+    # what's left for an unsigned result of / and %
+    c_check = ''
+    if type_unsigned(rettype):
+        if op == '/':
+            if type_signed(leftarg):
+                c_check = 'arg1 < 0'
+            elif type_signed(rightarg):
+                c_check = 'arg2 < 0'
+        elif op == '%':
+            if type_signed(leftarg):
+                c_check = 'arg1 < 0'
+            elif type_signed(rightarg):
+                # This computation has a positive result, so it would
+                # actually fit just fine, but the C implementation
+                # makes a mess of it, so better prohibit it.
+                c_check = 'arg2 < 0'
+    write_code(f_c, f_sql, leftarg, rightarg, op, rettype, c_check)
     f_test_sql.write("""\
 SELECT pg_typeof('1'::{lefttype} {op} '1'::{righttype});
 SELECT '1'::{lefttype} {op} '1'::{righttype};
@@ -494,6 +1122,282 @@ SELECT '5'::{lefttype} {op} '-2'::{righttype};
                          .format(lefttype=leftarg, righttype=rightarg))
 
 
+def boundary_values(typ):
+    bits = type_bits(typ)
+    if type_unsigned(typ):
+        lo, hi = 0, 2 ** bits - 1
+    else:
+        lo, hi = -2 ** (bits - 1), 2 ** (bits - 1) - 1
+    values = set()
+    for v in [lo, hi, hi // 2, 0, 1, 2, 3]:
+        values.update([v - 1, v, v + 1, -v])
+    # around the square roots and the limits of the other types
+    for k in [4, 7, 8, 15, 16, 31, 32, 63, 64, 127]:
+        for v in [2 ** k - 1, 2 ** k, 2 ** k + 1]:
+            values.update([v, -v])
+    return sorted(v for v in values if lo <= v <= hi)
+
+
+def c_literal(typ, v):
+    u = v % 2 ** 128
+    if type_128(typ):
+        return '({0}) ((uint128) UINT64_C(0x{1:x}) << 64 | UINT64_C(0x{2:x}))'.format(
+            native_types[typ], u >> 64, u & (2 ** 64 - 1))
+    return '({0}) UINT64_C(0x{1:x})'.format(c_types[typ], u & (2 ** 64 - 1))
+
+
+def write_arith_test(f):
+    # arith_test.c runs the overflow checks that write_op_c_function
+    # emitted before it used the builtins against the builtins, over
+    # boundary values of every type combination; "arith_test bench"
+    # times both
+    f.write("""\
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "overflow.h"
+
+typedef int8_t int8;
+typedef int16_t int16;
+typedef int32_t int32;
+typedef int64_t int64;
+typedef uint8_t uint8;
+typedef uint16_t uint16;
+typedef uint32_t uint32;
+typedef uint64_t uint64;
+typedef __int128_t int128;
+typedef __uint128_t uint128;
+
+#define SAMESIGN(a,b)\t(((a) < 0) == ((b) < 0))
+#define lengthof(array) (sizeof(array) / sizeof((array)[0]))
+
+static int\tfailures;
+static int\tzero_products;
+
+/*
+ * The old checks rejected a product of zero and a negative number when
+ * the result type is unsigned; the builtins return 0, which is exact.
+ * Any other difference is a failure.
+ */
+#define COMPARE(name) \\
+\tif (legacy != now || (!legacy && result != value)) \\
+\t{ \\
+\t\tif (legacy && !now && value == 0 && (arg1 == 0 || arg2 == 0)) \\
+\t\t\tzero_products++; \\
+\t\telse \\
+\t\t{ \\
+\t\t\tprintf("%s: values %u and %u: legacy %s, builtin %s\\n", name, i, j, \\
+\t\t\t\t   legacy ? "error" : "ok", now ? "error" : "ok"); \\
+\t\t\tfailures++; \\
+\t\t} \\
+\t}
+
+""")
+    for typ in new_types + old_types:
+        ctype = native_types.get(typ, c_types[typ])
+        f.write("static const {0} v_{1}[] = {{\n".format(ctype, typ))
+        for v in boundary_values(typ):
+            f.write("\t{0},\n".format(c_literal(typ, v)))
+        f.write("};\n\n")
+
+    tests = []
+    for leftarg in new_types + old_types:
+        for rightarg in new_types + old_types:
+            if leftarg in old_types and rightarg in old_types:
+                continue
+            rettype = arithmetic_rettype(leftarg, rightarg)
+            for op in ['+', '-', '*']:
+                funcname = 'test_' + leftarg + rightarg + op_words[op]
+                tests.append(funcname)
+                c_check, intermediate_type = legacy_overflow_check(op, leftarg, rightarg)
+                if intermediate_type:
+                    compute = """\
+\t\t\t{0} intermediate = ({0}) arg1 {1} ({0}) arg2;
+
+\t\t\tlegacy = {2};
+\t\t\tresult = intermediate;
+""".format(c_types[intermediate_type], op, c_check)
+                else:
+                    compute = """\
+\t\t\tresult = arg1 {0} arg2;
+\t\t\tlegacy = {1};
+""".format(op, c_check)
+                generic = ""
+                if overflow_builtin(op, rettype) == 'int128_mul_overflow':
+                    # the clang variant, whichever compiler runs the test
+                    generic = """\
+\t\t\tnow = int128_mul_overflow_generic(arg1, arg2, &value);
+\t\t\tCOMPARE("{0} {1} {2} (generic)");
+""".format(leftarg, op, rightarg)
+                f.write("""\
+static void
+{funcname}(void)
+{{
+\tfor (unsigned int i = 0; i < lengthof(v_{left}); i++)
+\t\tfor (unsigned int j = 0; j < lengthof(v_{right}); j++)
+\t\t{{
+\t\t\t{lefttype} arg1 = v_{left}[i];
+\t\t\t{righttype} arg2 = v_{right}[j];
+\t\t\t{rettype} result,
+\t\t\t\t\t\tvalue;
+\t\t\tint legacy,
+\t\t\t\t\t\tnow;
+
+{compute}\t\t\tnow = {builtin}(arg1, arg2, &value);
+\t\t\tCOMPARE("{left} {op} {right}");
+{generic}\t\t}}
+}}
+
+""".format(funcname=funcname, left=leftarg, right=rightarg, op=op,
+           lefttype=native_types.get(leftarg, c_types[leftarg]),
+           righttype=native_types.get(rightarg, c_types[rightarg]),
+           rettype=native_types.get(rettype, c_types[rettype]),
+           compute=compute, builtin=overflow_builtin(op, rettype), generic=generic))
+
+    # throughput: the operands are non-negative and no wider than half
+    # the result, so products fit and the old checks take their slow path
+    bench_pairs = [('uint4', 'uint4'), ('uint8', 'uint8'), ('uint8', 'int8'),
+                   ('int16', 'int16'), ('uint16', 'uint16'), ('uint16', 'int8')]
+    f.write("""\
+#define BENCH_N 4096
+#define BENCH_ROUNDS 2000
+
+static double
+now_seconds(void)
+{
+\tstruct timespec ts;
+
+\tclock_gettime(CLOCK_MONOTONIC, &ts);
+\treturn ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64
+rand64(void)
+{
+\tstatic uint64 x = 0x9e3779b97f4a7c15ULL;\t/* xorshift64* */
+
+\tx ^= x >> 12;
+\tx ^= x << 25;
+\tx ^= x >> 27;
+\treturn x * 0x2545f4914f6cdd1dULL;
+}
+
+static void
+bench_report(const char *name, double legacy, double builtin)
+{
+\tdouble\t\tn = (double) BENCH_N * BENCH_ROUNDS;
+
+\tprintf("%-16s legacy %6.2f ns/op  builtin %6.2f ns/op  (%.2fx)\\n", name,
+\t\t   legacy * 1e9 / n, builtin * 1e9 / n, legacy / builtin);
+}
+
+""")
+    benches = []
+    for leftarg, rightarg in bench_pairs:
+        rettype = arithmetic_rettype(leftarg, rightarg)
+        half = type_bits(rettype) // 2 - 1
+        for op in ['+', '-', '*']:
+            funcname = 'bench_' + leftarg + rightarg + op_words[op]
+            benches.append(funcname)
+            c_check, intermediate_type = legacy_overflow_check(op, leftarg, rightarg)
+            if intermediate_type:
+                legacy = """\
+\t\t\t{0} intermediate = ({0}) arg1 {1} ({0}) arg2;
+
+\t\t\terrors += {2};
+\t\t\tresult = intermediate;
+""".format(c_types[intermediate_type], op, c_check)
+            else:
+                legacy = """\
+\t\t\tresult = arg1 {0} arg2;
+\t\t\terrors += {1};
+""".format(op, c_check)
+            f.write("""\
+static void
+{funcname}(void)
+{{
+\tstatic {lefttype} a[BENCH_N];
+\tstatic {righttype} b[BENCH_N];
+\t{rettype} sum1 = 0,
+\t\t\t\tsum2 = 0;
+\tint\t\t\terrors1 = 0,
+\t\t\t\terrors2 = 0;
+\tdouble\t\tt0,
+\t\t\t\tt1,
+\t\t\t\tt2;
+
+\tfor (unsigned int k = 0; k < BENCH_N; k++)
+\t{{
+\t\ta[k] = ({lefttype}) (((uint128) rand64() << 64 | rand64()) >> (128 - {half}));
+\t\tb[k] = ({righttype}) (((uint128) rand64() << 64 | rand64()) >> (128 - {half}));
+\t}}
+\tt0 = now_seconds();
+\tfor (unsigned int r = 0; r < BENCH_ROUNDS; r++)
+\t\tfor (unsigned int k = 0; k < BENCH_N; k++)
+\t\t{{
+\t\t\t{lefttype} arg1 = a[k];
+\t\t\t{righttype} arg2 = b[k];
+\t\t\t{rettype} result;
+\t\t\tint errors = 0;
+
+{legacy}\t\t\terrors1 += errors;
+\t\t\tsum1 += result;
+\t\t\t__asm__ volatile("" : "+r" (sum1));
+\t\t}}
+\tt1 = now_seconds();
+\tfor (unsigned int r = 0; r < BENCH_ROUNDS; r++)
+\t\tfor (unsigned int k = 0; k < BENCH_N; k++)
+\t\t{{
+\t\t\t{rettype} result;
+
+\t\t\terrors2 += {builtin}(a[k], b[k], &result);
+\t\t\tsum2 += result;
+\t\t\t__asm__ volatile("" : "+r" (sum2));
+\t\t}}
+\tt2 = now_seconds();
+\tif (sum1 != sum2 || errors1 != errors2)
+\t{{
+\t\tprintf("{left} {op} {right}: results differ\\n");
+\t\tfailures++;
+\t}}
+\tbench_report("{left} {op} {right}", t1 - t0, t2 - t1);
+}}
+
+""".format(funcname=funcname, left=leftarg, right=rightarg, op=op,
+           lefttype=native_types.get(leftarg, c_types[leftarg]),
+           righttype=native_types.get(rightarg, c_types[rightarg]),
+           rettype=native_types.get(rettype, c_types[rettype]),
+           half=half, legacy=legacy, builtin=overflow_builtin(op, rettype)))
+
+    f.write("""\
+int
+main(int argc, char **argv)
+{
+\tif (argc > 1 && !strcmp(argv[1], "bench"))
+\t{
+""")
+    for funcname in benches:
+        f.write("\t\t{0}();\n".format(funcname))
+    f.write("""\
+\t\treturn failures != 0;
+\t}
+""")
+    for funcname in tests:
+        f.write("\t{0}();\n".format(funcname))
+    f.write("""\
+\tif (failures)
+\t{
+\t\tprintf("%d failures\\n", failures);
+\t\treturn 1;
+\t}
+\tprintf("all tests passed (%d zero products now accepted)\\n", zero_products);
+\treturn 0;
+}
+""")
+
+
 def main(pgversion):
     f_c = open('operators.c', 'w')
     f_sql = open('operators.sql', 'w')
@@ -504,12 +1408,25 @@ def main(pgversion):
 #include <fmgr.h>
 
 #include "uint.h"
+#include "unumeric.h"
+#include "overflow.h"
 
 """)
     if pgversion >= 9.2:
         f_c.write("""#include <utils/sortsupport.h>
 
 """)
+    if pgversion >= 18:
+        f_c.write("""#include <utils/skipsupport.h>
+
+""")
+    if pgversion >= 9.5:
+        write_abbrev_c_functions(f_c, pgversion)
+
+    if pgversion >= 11:
+        for estimator in sorted(uint_restriction_estimators.values()):
+            write_sql_function(f_sql, estimator, ['internal', 'oid', 'internal', 'int4'], 'float8')
+        restriction_estimators.update(uint_restriction_estimators)
 
     for argtype in new_types:
         f_test_sql.write("""\
@@ -591,15 +1508,11 @@ SELECT bt{lefttype}{righttype}cmp('3'::{lefttype}, '4'::{righttype});
                 if type_bits(leftarg) >= type_bits(rightarg):
                     body += """
 if (({c_type}) result != arg1)
-\tereport(ERROR,
-\t\t(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
-\t\t errmsg("{typ} out of range")));""".format(c_type=c_types[leftarg], typ=rightarg)
+\tuint_cast_out_of_range_error("{typ}");""".format(c_type=c_types[leftarg], typ=rightarg)
                 if type_unsigned(leftarg) != type_unsigned(rightarg):
                     body += """
 if (!SAMESIGN(result, arg1))
-\tereport(ERROR,
-\t\t(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
-\t\t errmsg("{typ} out of range")));""".format(typ=rightarg)
+\tuint_cast_out_of_range_error("{typ}");""".format(typ=rightarg)
                 write_c_function(f_c, c_funcname, [leftarg], rightarg, body)
                 write_sql_function(f_sql, c_funcname, [leftarg], rightarg, sql_funcname=sql_funcname)
                 f_sql.write("CREATE CAST ({lefttype} AS {righttype}) WITH FUNCTION {func}({arg}) AS {context};\n\n"
@@ -608,6 +1521,10 @@ if (!SAMESIGN(result, arg1))
                                     arg=leftarg,
                                     context=("IMPLICIT" if type_bits(leftarg) <= type_bits(rightarg) else "ASSIGNMENT")))
 
+    write_sql_function(f_sql, 'gin_uint_consistent',
+                       ['internal', 'int2', 'anyelement', 'int4', 'internal', 'internal'], 'bool')
+    write_gist_key_types_sql(f_sql)
+
     for arg in new_types:
         for op in ['&', '|', '#']:
             write_code(f_c, f_sql, leftarg=arg, rightarg=arg, op=op, rettype=arg)
@@ -631,7 +1548,22 @@ SELECT '6'::{typ} {op} 3;
         write_sortsupport_c_function(f_c, arg, pgversion)
         if pgversion >= 9.2:
             write_sql_function(f_sql, 'bt' + arg + 'sortsupport', ['internal'], 'void')
+        if pgversion >= 18:
+            write_skipsupport_c_function(f_c, arg)
+            write_sql_function(f_sql, 'bt' + arg + 'skipsupport', ['internal'], 'void')
+        if pgversion >= 11:
+            write_sql_function(f_sql, 'hash' + arg + 'extended', [arg, 'int8'], 'int8')
         write_opclasses_sql(f_sql, arg, pgversion)
+        if pgversion >= 14:
+            # the values are the bounds of a range, so arg1 <= arg2
+            write_c_function(f_c, 'brin_minmax_multi_distance_' + arg, [arg, arg], 'float8',
+                             body="result = (float8) arg2 - (float8) arg1;")
+            write_sql_function(f_sql, 'brin_minmax_multi_distance_' + arg, ['internal', 'internal'], 'float8')
+        if pgversion >= 9.5:
+            write_brin_opclasses_sql(f_sql, arg, pgversion)
+        write_gin_opclass_sql(f_sql, arg)
+        write_dist_operator(f_c, f_sql, arg)
+        write_gist_opclass_sql(f_sql, arg, pgversion)
 
         for agg, funcname, op in [('min', arg + "smaller", '<'),
                                   ('max', arg + "larger", '>')]:
@@ -643,25 +1575,39 @@ SELECT {funcname}('1'::{typ}, '1'::{typ});
 SELECT {funcname}('5'::{typ}, '2'::{typ});
 SELECT {funcname}('3'::{typ}, '4'::{typ});
 """.format(funcname=funcname, typ=arg))
-            f_sql.write("CREATE AGGREGATE {agg}({typ}) (SFUNC = {sfunc}, STYPE = {stype}, SORTOP = {sortop});\n\n"
+            f_sql.write("CREATE AGGREGATE {agg}({typ}) (SFUNC = {sfunc}, STYPE = {stype}, SORTOP = {sortop},"
+                        " COMBINEFUNC = {sfunc}, PARALLEL = SAFE);\n\n"
                         .format(agg=agg, typ=arg, sfunc=funcname, stype=arg, sortop=op))
             f_test_sql.write("SELECT {agg}(val::{typ}) FROM (VALUES (3), (5), (1), (4)) AS _ (val);\n\n"
                              .format(agg=agg, typ=arg))
 
         for agg, funcname in [('bit_and', arg + arg + "and"),
                               ('bit_or', arg + arg + "or")]:
-            f_sql.write("CREATE AGGREGATE {agg}({typ}) (SFUNC = {sfunc}, STYPE = {stype});\n\n"
+            f_sql.write("CREATE AGGREGATE {agg}({typ}) (SFUNC = {sfunc}, STYPE = {stype},"
+                        " COMBINEFUNC = {sfunc}, PARALLEL = SAFE);\n\n"
                         .format(agg=agg, typ=arg, sfunc=funcname, stype=arg))
         f_test_sql.write("SELECT bit_and(val::{typ}) FROM (VALUES (3), (6), (18)) AS _ (val);\n\n"
                          .format(typ=arg))
         f_test_sql.write("SELECT bit_or(val::{typ}) FROM (VALUES (9), (1), (4)) AS _ (val);\n\n"
                          .format(typ=arg))
 
+        # sum and avg share the moving-aggregate state of avg
+        msfunc = "{argtype}_avg_accum".format(argtype=arg)
+        minvfunc = "{argtype}_avg_accum_inv".format(argtype=arg)
+        write_sql_function(f_sql, msfunc, ['internal', arg], 'internal', strict=False)
+        write_sql_function(f_sql, minvfunc, ['internal', arg], 'internal', strict=False)
+        moving = ("MSFUNC = {msfunc}, MINVFUNC = {minvfunc}, MSTYPE = internal, MSSPACE = 32"
+                  .format(msfunc=msfunc, minvfunc=minvfunc))
+
         sfunc = "{argtype}_sum".format(argtype=arg)
         stype = sum_trans_types[arg]
         write_sql_function(f_sql, sfunc, [stype, arg], stype, strict=False)
-        f_sql.write("CREATE AGGREGATE sum({arg}) (SFUNC = {sfunc}, STYPE = {stype});\n\n"
-                    .format(arg=arg, sfunc=sfunc, stype=stype))
+        write_sql_function(f_sql, arg + '_sum_final', ['internal'], stype, strict=False)
+        f_sql.write("CREATE AGGREGATE sum({arg}) (SFUNC = {sfunc}, STYPE = {stype},"
+                    " COMBINEFUNC = {combinefunc}, {moving}, MFINALFUNC = {arg}_sum_final,"
+                    " PARALLEL = SAFE);\n\n"
+                    .format(arg=arg, sfunc=sfunc, stype=stype, combinefunc=sum_combine_funcs[arg],
+                            moving=moving))
         f_test_sql.write("""
 SELECT {sfunc}(NULL::{stype}, NULL::{argtype});
 SELECT {sfunc}(NULL::{stype}, 1::{argtype});
@@ -672,12 +1618,11 @@ SELECT sum(val::{argtype}) FROM (SELECT NULL::{argtype} WHERE false) _ (val);
 SELECT sum(val::{argtype}) FROM (VALUES (1), (null), (2), (5)) _ (val);
 """.format(sfunc=sfunc, argtype=arg, stype=stype))
 
-        sfunc = "{argtype}_avg_accum".format(argtype=arg)
-        stype = avg_trans_types[arg]
-        write_sql_function(f_sql, sfunc, [stype, arg], stype)
-        f_sql.write("CREATE AGGREGATE avg({arg}) (SFUNC = {sfunc}, STYPE = {stype}, FINALFUNC = {finalfunc},"
-                    " INITCOND = '{{0,0}}');\n\n"
-                    .format(arg=arg, sfunc=sfunc, stype=stype, finalfunc=avg_final_funcs[arg]))
+        f_sql.write("CREATE AGGREGATE avg({arg}) (SFUNC = {sfunc}, STYPE = internal, SSPACE = 32,"
+                    " FINALFUNC = uint_avg_final, COMBINEFUNC = uint_avg_combine,"
+                    " SERIALFUNC = uint_avg_serialize, DESERIALFUNC = uint_avg_deserialize,"
+                    " {moving}, MFINALFUNC = uint_avg_final, PARALLEL = SAFE);\n\n"
+                    .format(arg=arg, sfunc=msfunc, moving=moving))
         f_test_sql.write("""
 SELECT avg(val::{argtype}) FROM (SELECT NULL::{argtype} WHERE false) _ (val);
 SELECT avg(val::{argtype}) FROM (VALUES (1), (null), (2), (5), (6)) _ (val);
@@ -685,6 +1630,7 @@ SELECT avg(val::{argtype}) FROM (VALUES (1), (null), (2), (5), (6)) _ (val);
 
     op_fam_btree_elements = []
     op_fam_hash_elements = []
+    op_fam_brin_elements = []
 
     for lefttype in new_types + old_types:
         f_test_sql.write("""
@@ -717,18 +1663,69 @@ SELECT * FROM test_{typ} WHERE x = 3::{typ2};
                 op_fam_hash_elements.extend([s.format(type1=lefttype, type2=righttype) for s in [
                     "OPERATOR 1 = ({type1}, {type2})",
                 ]])
+                op_fam_brin_elements.extend([s.format(type1=lefttype, type2=righttype) for s in [
+                    "OPERATOR 1 <  ({type1}, {type2})",
+                    "OPERATOR 2 <= ({type1}, {type2})",
+                    "OPERATOR 3 =  ({type1}, {type2})",
+                    "OPERATOR 4 >= ({type1}, {type2})",
+                    "OPERATOR 5 >  ({type1}, {type2})",
+                ]])
 
         f_test_sql.write("""
 RESET enable_seqscan;
 RESET enable_bitmapscan;
 """)
 
+    # The cross-type comparisons with numeric and float8 go into both
+    # btree families, so that indexes on either side can use them.
+    if pgversion >= 12:
+        for typ in new_types:
+            for op in comparison_ops:
+                write_sql_function(f_sql, '{0}_{1}_support'.format(typ, op_words[op]),
+                                   ['internal'], 'internal')
+    float_fam_btree_elements = {}
+    for other, family in sorted(cmp_float_types.items()):
+        float_fam_btree_elements[family] = []
+        for typ in new_types:
+            write_float_cmp_ops(f_c, f_sql, typ, other, pgversion)
+            for type1, type2 in [(typ, other), (other, typ)]:
+                elements = [s.format(type1=type1, type2=type2) for s in [
+                    "OPERATOR 1 <  ({type1}, {type2})",
+                    "OPERATOR 2 <= ({type1}, {type2})",
+                    "OPERATOR 3 =  ({type1}, {type2})",
+                    "OPERATOR 4 >= ({type1}, {type2})",
+                    "OPERATOR 5 >  ({type1}, {type2})",
+                    "FUNCTION 1 bt{type1}{type2}cmp({type1}, {type2})",
+                ]]
+                op_fam_btree_elements.extend(elements)
+                float_fam_btree_elements[family].extend(elements)
+
     f_sql.write("ALTER OPERATOR FAMILY integer_ops USING btree ADD\n" +
                 ",\n".join(op_fam_btree_elements) +
                 ";\n\n")
+    for family, elements in sorted(float_fam_btree_elements.items()):
+        f_sql.write("ALTER OPERATOR FAMILY {family} USING btree ADD\n".format(family=family) +
+                    ",\n".join(elements) +
+                    ";\n\n")
     f_sql.write("ALTER OPERATOR FAMILY integer_ops USING hash ADD\n" +
                 ",\n".join(op_fam_hash_elements) +
                 ";\n\n")
+    # Bloom filters hash the scan key with the column type's hash
+    # function, so they can only take keys of the column type.
+    brin_families = []
+    if pgversion >= 9.5:
+        brin_families.append('integer_minmax_ops')
+    if pgversion >= 14:
+        brin_families.append('integer_minmax_multi_ops')
+    for family in brin_families:
+        f_sql.write("ALTER OPERATOR FAMILY {family} USING brin ADD\n".format(family=family) +
+                    ",\n".join(op_fam_brin_elements) +
+                    ";\n\n")
+
+    write_aligned_types_sql(f_sql, pgversion)
+    if pgversion >= 9.2:
+        write_range_types_sql(f_sql, pgversion)
+        write_prefix_types_sql(f_sql)
 
     # Unlike the other arithmetic operators, PostgreSQL supplies the %
     # operator only with same-type argument pairs and relies on type
@@ -750,6 +1747,9 @@ RESET enable_bitmapscan;
     f_sql.close()
     f_test_sql.close()
 
+    with open('arith_test.c', 'w') as f_arith_test:
+        write_arith_test(f_arith_test)
+
 
 if __name__ == '__main__':
     main(pgversion=float(sys.argv[1]))
@@ -0,0 +1,170 @@
+#include <postgres.h>
+#include <fmgr.h>
+#include <access/gin.h>
+#include <access/skey.h>
+
+#include "uint.h"
+
+/*
+ * GIN support in the manner of btree_gin: each value is its own single
+ * key, compared with the type's bt*cmp function.  Range queries start a
+ * partial match at the query value, or at the smallest value of the type
+ * for < and <=, and gin_uint_compare_prefix tells the scan when to stop.
+ */
+
+typedef struct QueryInfo
+{
+	StrategyNumber strategy;
+	Datum		datum;
+	PGFunction	typecmp;
+} QueryInfo;
+
+PG_FUNCTION_INFO_V1(gin_uint_extract_value);
+Datum
+gin_uint_extract_value(PG_FUNCTION_ARGS)
+{
+	Datum		datum = PG_GETARG_DATUM(0);
+	int32	   *nentries = (int32 *) PG_GETARG_POINTER(1);
+	Datum	   *entries = (Datum *) palloc(sizeof(Datum));
+
+	entries[0] = datum;
+	*nentries = 1;
+
+	PG_RETURN_POINTER(entries);
+}
+
+static Datum
+gin_uint_extract_query(FunctionCallInfo fcinfo, Datum leftmost, PGFunction typecmp)
+{
+	Datum		datum = PG_GETARG_DATUM(0);
+	int32	   *nentries = (int32 *) PG_GETARG_POINTER(1);
+	StrategyNumber strategy = PG_GETARG_UINT16(2);
+	bool	  **partialmatch = (bool **) PG_GETARG_POINTER(3);
+	Pointer   **extra_data = (Pointer **) PG_GETARG_POINTER(4);
+	Datum	   *entries = (Datum *) palloc(sizeof(Datum));
+	QueryInfo  *data = (QueryInfo *) palloc(sizeof(QueryInfo));
+
+	*nentries = 1;
+	*partialmatch = (bool *) palloc(sizeof(bool));
+	**partialmatch = false;
+
+	data->strategy = strategy;
+	data->datum = datum;
+	data->typecmp = typecmp;
+	*extra_data = (Pointer *) palloc(sizeof(Pointer));
+	**extra_data = (Pointer) data;
+
+	switch (strategy)
+	{
+		case BTLessStrategyNumber:
+		case BTLessEqualStrategyNumber:
+			entries[0] = leftmost;
+			**partialmatch = true;
+			break;
+		case BTGreaterEqualStrategyNumber:
+		case BTGreaterStrategyNumber:
+			**partialmatch = true;
+			/* FALLTHROUGH */
+		case BTEqualStrategyNumber:
+			entries[0] = datum;
+			break;
+		default:
+			elog(ERROR, "unrecognized strategy number: %d", strategy);
+	}
+
+	PG_RETURN_POINTER(entries);
+}
+
+/*
+ * Returns 0 for a match, a negative value to skip the key and continue, and
+ * a positive value to end the scan.
+ */
+PG_FUNCTION_INFO_V1(gin_uint_compare_prefix);
+Datum
+gin_uint_compare_prefix(PG_FUNCTION_ARGS)
+{
+	Datum		a = PG_GETARG_DATUM(0);
+	Datum		b = PG_GETARG_DATUM(1);
+	QueryInfo  *data = (QueryInfo *) PG_GETARG_POINTER(3);
+	int32		res,
+				cmp;
+
+	/* a is the leftmost value for < and <=, so compare with the query */
+	cmp = DatumGetInt32(DirectFunctionCall2(data->typecmp,
+											(data->strategy == BTLessStrategyNumber ||
+											 data->strategy == BTLessEqualStrategyNumber)
+											? data->datum : a,
+											b));
+
+	switch (data->strategy)
+	{
+		case BTLessStrategyNumber:
+			res = (cmp > 0) ? 0 : 1;
+			break;
+		case BTLessEqualStrategyNumber:
+			res = (cmp >= 0) ? 0 : 1;
+			break;
+		case BTEqualStrategyNumber:
+			res = (cmp != 0) ? 1 : 0;
+			break;
+		case BTGreaterEqualStrategyNumber:
+			res = (cmp <= 0) ? 0 : 1;
+			break;
+		case BTGreaterStrategyNumber:
+			/* the partial match starts at the query value itself */
+			res = (cmp < 0) ? 0 : (cmp == 0) ? -1 : 1;
+			break;
+		default:
+			elog(ERROR, "unrecognized strategy number: %d", data->strategy);
+			res = 0;
+	}
+
+	PG_RETURN_INT32(res);
+}
+
+/* every key is exact, so no recheck is needed */
+PG_FUNCTION_INFO_V1(gin_uint_consistent);
+Datum
+gin_uint_consistent(PG_FUNCTION_ARGS)
+{
+	bool	   *recheck = (bool *) PG_GETARG_POINTER(5);
+
+	*recheck = false;
+	PG_RETURN_BOOL(true);
+}
+
+static Datum
+int16_min_datum(void)
+{
+	xint128    *result = (xint128 *) palloc(sizeof(xint128));
+
+	result->i = (__int128_t) ((__uint128_t) 1 << 127);
+	return PointerGetDatum(result);
+}
+
+static Datum
+uint16_min_datum(void)
+{
+	xuint128   *result = (xuint128 *) palloc(sizeof(xuint128));
+
+	result->i = 0;
+	return PointerGetDatum(result);
+}
+
+#define make_gin_extract_query(type, leftmost) \
+extern Datum bt##type##type##cmp(PG_FUNCTION_ARGS); \
+PG_FUNCTION_INFO_V1(gin_extract_query_##type); \
+Datum \
+gin_extract_query_##type(PG_FUNCTION_ARGS) \
+{ \
+	return gin_uint_extract_query(fcinfo, leftmost, bt##type##type##cmp); \
+} \
+extern int no_such_variable
+
+make_gin_extract_query(int1, Int8GetDatum(-128));
+make_gin_extract_query(uint1, UInt8GetDatum(0));
+make_gin_extract_query(uint2, UInt16GetDatum(0));
+make_gin_extract_query(uint4, UInt32GetDatum(0));
+make_gin_extract_query(uint8, UInt64GetDatum(0));
+make_gin_extract_query(int16, int16_min_datum());
+make_gin_extract_query(uint16, uint16_min_datum());
@@ -0,0 +1,430 @@
+#include <postgres.h>
+#include <fmgr.h>
+#include <access/gist.h>
+#include <access/skey.h>
+#include <utils/rel.h>
+
+#include <float.h>
+#include <string.h>
+
+#include "uint.h"
+
+/*
+ * GiST support in the manner of btree_gist: an index key is the interval
+ * (lower, upper) spanned by the values below it, stored as the two bounds
+ * back to back.  Leaf keys have lower = upper.  The bounds are accessed
+ * with memcpy, so the key types need no particular alignment.
+ */
+
+#define GistNotEqualStrategyNumber	6
+
+typedef struct
+{
+	int			size;			/* size of one bound */
+	int			(*f_cmp) (const void *, const void *);
+	float8		(*f_float8) (const void *);
+	float8		(*f_dist) (const void *, const void *);
+	Datum		(*f_todatum) (const void *);
+	void		(*f_fromdatum) (Datum, void *);
+} uint_gist_info;
+
+#define LOWER(key)			((const char *) (key))
+#define UPPER(key, tinfo)	((const char *) (key) + (tinfo)->size)
+
+static bool
+uint_gist_consistent_(const void *key, const void *query, StrategyNumber strategy,
+					  bool is_leaf, const uint_gist_info *tinfo)
+{
+	int			lcmp = tinfo->f_cmp(LOWER(key), query);
+	int			ucmp = tinfo->f_cmp(UPPER(key, tinfo), query);
+
+	switch (strategy)
+	{
+		case BTLessStrategyNumber:
+			return lcmp < 0;
+		case BTLessEqualStrategyNumber:
+			return lcmp <= 0;
+		case BTEqualStrategyNumber:
+			return lcmp <= 0 && ucmp >= 0;
+		case BTGreaterEqualStrategyNumber:
+			return ucmp >= 0;
+		case BTGreaterStrategyNumber:
+			return ucmp > 0;
+		case GistNotEqualStrategyNumber:
+			return is_leaf ? lcmp != 0 : !(lcmp == 0 && ucmp == 0);
+		default:
+			elog(ERROR, "unrecognized strategy number: %d", strategy);
+			return false;
+	}
+}
+
+static Datum
+uint_gist_consistent(FunctionCallInfo fcinfo, const uint_gist_info *tinfo)
+{
+	GISTENTRY  *entry = (GISTENTRY *) PG_GETARG_POINTER(0);
+	StrategyNumber strategy = (StrategyNumber) PG_GETARG_UINT16(2);
+	bool	   *recheck = (bool *) PG_GETARG_POINTER(4);
+	char		query[sizeof(__int128_t)];
+
+	tinfo->f_fromdatum(PG_GETARG_DATUM(1), query);
+	*recheck = false;
+
+	PG_RETURN_BOOL(uint_gist_consistent_(DatumGetPointer(entry->key), query, strategy,
+										 GIST_LEAF(entry), tinfo));
+}
+
+/*
+ * GiST distances are float8 and are not marked lossy.  That is exact for
+ * the types up to 32 bits; for the 64- and 128-bit types the <-> operator
+ * itself returns float8, rounded the same way, so the index order always
+ * matches ORDER BY <->.  Rounding is monotonic, so the distance to an inner
+ * key's interval is still a lower bound for the leaf keys below it.
+ */
+static Datum
+uint_gist_distance(FunctionCallInfo fcinfo, const uint_gist_info *tinfo)
+{
+	GISTENTRY  *entry = (GISTENTRY *) PG_GETARG_POINTER(0);
+	const char *key = DatumGetPointer(entry->key);
+	char		query[sizeof(__int128_t)];
+	float8		result;
+
+	tinfo->f_fromdatum(PG_GETARG_DATUM(1), query);
+
+	if (tinfo->f_cmp(query, LOWER(key)) < 0)
+		result = tinfo->f_dist(LOWER(key), query);
+	else if (tinfo->f_cmp(query, UPPER(key, tinfo)) > 0)
+		result = tinfo->f_dist(UPPER(key, tinfo), query);
+	else
+		result = 0.0;
+
+	PG_RETURN_FLOAT8(result);
+}
+
+static Datum
+uint_gist_compress(FunctionCallInfo fcinfo, const uint_gist_info *tinfo)
+{
+	GISTENTRY  *entry = (GISTENTRY *) PG_GETARG_POINTER(0);
+	GISTENTRY  *retval;
+	char	   *key;
+
+	if (!entry->leafkey)
+		PG_RETURN_POINTER(entry);
+
+	key = palloc(2 * tinfo->size);
+	tinfo->f_fromdatum(entry->key, key);
+	memcpy(key + tinfo->size, key, tinfo->size);
+
+	retval = palloc(sizeof(GISTENTRY));
+	gistentryinit(*retval, PointerGetDatum(key), entry->rel, entry->page, entry->offset, false);
+	PG_RETURN_POINTER(retval);
+}
+
+static Datum
+uint_gist_fetch(FunctionCallInfo fcinfo, const uint_gist_info *tinfo)
+{
+	GISTENTRY  *entry = (GISTENTRY *) PG_GETARG_POINTER(0);
+	GISTENTRY  *retval = palloc(sizeof(GISTENTRY));
+
+	gistentryinit(*retval, tinfo->f_todatum(DatumGetPointer(entry->key)),
+				  entry->rel, entry->page, entry->offset, false);
+	PG_RETURN_POINTER(retval);
+}
+
+/* extend key to cover other */
+static void
+uint_gist_bin_union(char *key, const char *other, const uint_gist_info *tinfo)
+{
+	if (tinfo->f_cmp(LOWER(other), LOWER(key)) < 0)
+		memcpy(key, LOWER(other), tinfo->size);
+	if (tinfo->f_cmp(UPPER(other, tinfo), UPPER(key, tinfo)) > 0)
+		memcpy(key + tinfo->size, UPPER(other, tinfo), tinfo->size);
+}
+
+static Datum
+uint_gist_union(FunctionCallInfo fcinfo, const uint_gist_info *tinfo)
+{
+	GistEntryVector *entryvec = (GistEntryVector *) PG_GETARG_POINTER(0);
+	int		   *size = (int *) PG_GETARG_POINTER(1);
+	char	   *result = palloc(2 * tinfo->size);
+	int			i;
+
+	memcpy(result, DatumGetPointer(entryvec->vector[0].key), 2 * tinfo->size);
+	for (i = 1; i < entryvec->n; i++)
+		uint_gist_bin_union(result, DatumGetPointer(entryvec->vector[i].key), tinfo);
+
+	*size = 2 * tinfo->size;
+	PG_RETURN_POINTER(result);
+}
+
+/* the growth of the interval relative to its new span, as in btree_gist */
+static Datum
+uint_gist_penalty(FunctionCallInfo fcinfo, const uint_gist_info *tinfo)
+{
+	GISTENTRY  *origentry = (GISTENTRY *) PG_GETARG_POINTER(0);
+	GISTENTRY  *newentry = (GISTENTRY *) PG_GETARG_POINTER(1);
+	float	   *result = (float *) PG_GETARG_POINTER(2);
+	const char *orig = DatumGetPointer(origentry->key);
+	const char *new = DatumGetPointer(newentry->key);
+	float8		olower = tinfo->f_float8(LOWER(orig));
+	float8		oupper = tinfo->f_float8(UPPER(orig, tinfo));
+	float8		growth = 0.0;
+
+	if (tinfo->f_cmp(UPPER(new, tinfo), UPPER(orig, tinfo)) > 0)
+		growth += tinfo->f_float8(UPPER(new, tinfo)) * 0.49 - oupper * 0.49;
+	if (tinfo->f_cmp(LOWER(new), LOWER(orig)) < 0)
+		growth += olower * 0.49 - tinfo->f_float8(LOWER(new)) * 0.49;
+
+	*result = 0.0;
+	if (growth > 0.0)
+	{
+		*result += FLT_MIN;
+		*result += (float) (growth / (growth + (oupper * 0.49 - olower * 0.49)));
+		*result *= FLT_MAX / (origentry->rel->rd_att->natts + 1);
+	}
+
+	PG_RETURN_POINTER(result);
+}
+
+typedef struct
+{
+	const char *key;
+	OffsetNumber i;
+} uint_gist_sort;
+
+static int
+uint_gist_sort_cmp(const void *a, const void *b, void *arg)
+{
+	const uint_gist_info *tinfo = (const uint_gist_info *) arg;
+	const char *ka = ((const uint_gist_sort *) a)->key;
+	const char *kb = ((const uint_gist_sort *) b)->key;
+	int			cmp = tinfo->f_cmp(LOWER(ka), LOWER(kb));
+
+	return cmp ? cmp : tinfo->f_cmp(UPPER(ka, tinfo), UPPER(kb, tinfo));
+}
+
+/* sort the entries by interval and split them in half */
+static Datum
+uint_gist_picksplit(FunctionCallInfo fcinfo, const uint_gist_info *tinfo)
+{
+	GistEntryVector *entryvec = (GistEntryVector *) PG_GETARG_POINTER(0);
+	GIST_SPLITVEC *v = (GIST_SPLITVEC *) PG_GETARG_POINTER(1);
+	OffsetNumber maxoff = entryvec->n - 1;
+	OffsetNumber i;
+	uint_gist_sort *arr = palloc((maxoff + 1) * sizeof(uint_gist_sort));
+	int			nbytes = (maxoff + 2) * sizeof(OffsetNumber);
+	char	   *ldatum = NULL;
+	char	   *rdatum = NULL;
+
+	v->spl_left = (OffsetNumber *) palloc(nbytes);
+	v->spl_right = (OffsetNumber *) palloc(nbytes);
+	v->spl_nleft = 0;
+	v->spl_nright = 0;
+
+	for (i = FirstOffsetNumber; i <= maxoff; i = OffsetNumberNext(i))
+	{
+		arr[i].key = DatumGetPointer(entryvec->vector[i].key);
+		arr[i].i = i;
+	}
+	qsort_arg(&arr[FirstOffsetNumber], maxoff - FirstOffsetNumber + 1, sizeof(uint_gist_sort),
+			  uint_gist_sort_cmp, (void *) tinfo);
+
+	for (i = FirstOffsetNumber; i <= maxoff; i = OffsetNumberNext(i))
+	{
+		char	  **datum;
+
+		if (i <= (maxoff - FirstOffsetNumber + 1) / 2)
+		{
+			datum = &ldatum;
+			v->spl_left[v->spl_nleft++] = arr[i].i;
+		}
+		else
+		{
+			datum = &rdatum;
+			v->spl_right[v->spl_nright++] = arr[i].i;
+		}
+
+		if (*datum == NULL)
+		{
+			*datum = palloc(2 * tinfo->size);
+			memcpy(*datum, arr[i].key, 2 * tinfo->size);
+		}
+		else
+			uint_gist_bin_union(*datum, arr[i].key, tinfo);
+	}
+
+	v->spl_ldatum = PointerGetDatum(ldatum);
+	v->spl_rdatum = PointerGetDatum(rdatum);
+
+	PG_RETURN_POINTER(v);
+}
+
+static Datum
+uint_gist_same(FunctionCallInfo fcinfo, const uint_gist_info *tinfo)
+{
+	const char *a = (const char *) PG_GETARG_POINTER(0);
+	const char *b = (const char *) PG_GETARG_POINTER(1);
+	bool	   *result = (bool *) PG_GETARG_POINTER(2);
+
+	*result = (tinfo->f_cmp(LOWER(a), LOWER(b)) == 0 &&
+			   tinfo->f_cmp(UPPER(a, tinfo), UPPER(b, tinfo)) == 0);
+	PG_RETURN_POINTER(result);
+}
+
+PG_FUNCTION_INFO_V1(gist_uint_decompress);
+Datum
+gist_uint_decompress(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_POINTER(PG_GETARG_POINTER(0));
+}
+
+PG_FUNCTION_INFO_V1(gist_uint_key_in);
+Datum
+gist_uint_key_in(PG_FUNCTION_ARGS)
+{
+	ereport(ERROR,
+			(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+			 errmsg("cannot accept a value of a GiST key type")));
+	PG_RETURN_VOID();
+}
+
+PG_FUNCTION_INFO_V1(gist_uint_key_out);
+Datum
+gist_uint_key_out(PG_FUNCTION_ARGS)
+{
+	ereport(ERROR,
+			(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+			 errmsg("cannot display a value of a GiST key type")));
+	PG_RETURN_VOID();
+}
+
+static Datum
+int16_todatum(__int128_t val)
+{
+	xint128    *result = (xint128 *) palloc(sizeof(xint128));
+
+	result->i = val;
+	return PointerGetDatum(result);
+}
+
+static Datum
+uint16_todatum(__uint128_t val)
+{
+	xuint128   *result = (xuint128 *) palloc(sizeof(xuint128));
+
+	result->i = val;
+	return PointerGetDatum(result);
+}
+
+#define int1_fromdatum(d)	DatumGetInt8(d)
+#define uint1_fromdatum(d)	DatumGetUInt8(d)
+#define uint2_fromdatum(d)	DatumGetUInt16(d)
+#define uint4_fromdatum(d)	DatumGetUInt32(d)
+#define uint8_fromdatum(d)	DatumGetUInt64(d)
+#define int16_fromdatum(d)	(((xint128 *) DatumGetPointer(d))->i)
+#define uint16_fromdatum(d)	(((xuint128 *) DatumGetPointer(d))->i)
+
+#define int1_todatum(v)		Int8GetDatum(v)
+#define uint1_todatum(v)	UInt8GetDatum(v)
+#define uint2_todatum(v)	UInt16GetDatum(v)
+#define uint4_todatum(v)	UInt32GetDatum(v)
+#define uint8_todatum(v)	UInt64GetDatum(v)
+
+#define make_gist_support(type, ctype, utype) \
+static inline ctype \
+type##_load(const void *p) \
+{ \
+	ctype		v; \
+	memcpy(&v, p, sizeof(v)); \
+	return v; \
+} \
+static int \
+gist_##type##_cmp(const void *a, const void *b) \
+{ \
+	ctype		x = type##_load(a); \
+	ctype		y = type##_load(b); \
+	return (x > y) - (x < y); \
+} \
+static float8 \
+gist_##type##_float8(const void *a) \
+{ \
+	return (float8) type##_load(a); \
+} \
+static float8 \
+gist_##type##_dist(const void *a, const void *b) \
+{ \
+	ctype		x = type##_load(a); \
+	ctype		y = type##_load(b); \
+	return (float8) (x > y ? (utype) x - (utype) y : (utype) y - (utype) x); \
+} \
+static Datum \
+gist_##type##_todatum(const void *a) \
+{ \
+	return type##_todatum(type##_load(a)); \
+} \
+static void \
+gist_##type##_fromdatum(Datum d, void *a) \
+{ \
+	ctype		v = type##_fromdatum(d); \
+	memcpy(a, &v, sizeof(v)); \
+} \
+static const uint_gist_info type##_tinfo = { \
+	sizeof(ctype), gist_##type##_cmp, gist_##type##_float8, gist_##type##_dist, \
+	gist_##type##_todatum, gist_##type##_fromdatum \
+}; \
+PG_FUNCTION_INFO_V1(gist_##type##_consistent); \
+Datum \
+gist_##type##_consistent(PG_FUNCTION_ARGS) \
+{ \
+	return uint_gist_consistent(fcinfo, &type##_tinfo); \
+} \
+PG_FUNCTION_INFO_V1(gist_##type##_distance); \
+Datum \
+gist_##type##_distance(PG_FUNCTION_ARGS) \
+{ \
+	return uint_gist_distance(fcinfo, &type##_tinfo); \
+} \
+PG_FUNCTION_INFO_V1(gist_##type##_compress); \
+Datum \
+gist_##type##_compress(PG_FUNCTION_ARGS) \
+{ \
+	return uint_gist_compress(fcinfo, &type##_tinfo); \
+} \
+PG_FUNCTION_INFO_V1(gist_##type##_fetch); \
+Datum \
+gist_##type##_fetch(PG_FUNCTION_ARGS) \
+{ \
+	return uint_gist_fetch(fcinfo, &type##_tinfo); \
+} \
+PG_FUNCTION_INFO_V1(gist_##type##_union); \
+Datum \
+gist_##type##_union(PG_FUNCTION_ARGS) \
+{ \
+	return uint_gist_union(fcinfo, &type##_tinfo); \
+} \
+PG_FUNCTION_INFO_V1(gist_##type##_penalty); \
+Datum \
+gist_##type##_penalty(PG_FUNCTION_ARGS) \
+{ \
+	return uint_gist_penalty(fcinfo, &type##_tinfo); \
+} \
+PG_FUNCTION_INFO_V1(gist_##type##_picksplit); \
+Datum \
+gist_##type##_picksplit(PG_FUNCTION_ARGS) \
+{ \
+	return uint_gist_picksplit(fcinfo, &type##_tinfo); \
+} \
+PG_FUNCTION_INFO_V1(gist_##type##_same); \
+Datum \
+gist_##type##_same(PG_FUNCTION_ARGS) \
+{ \
+	return uint_gist_same(fcinfo, &type##_tinfo); \
+} \
+extern int no_such_variable
+
+make_gist_support(int1, int8, uint8);
+make_gist_support(uint1, uint8, uint8);
+make_gist_support(uint2, uint16, uint16);
+make_gist_support(uint4, uint32, uint32);
+make_gist_support(uint8, uint64, uint64);
+make_gist_support(int16, __int128_t, __uint128_t);
+make_gist_support(uint16, __uint128_t, __uint128_t);
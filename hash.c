@@ -4,6 +4,20 @@
 
 #include "uint.h"
 
+#if PG_VERSION_NUM >= 110000
+#define make_hashfunc_extended(type, BTYPE, casttype) \
+PG_FUNCTION_INFO_V1(hash##type##extended); \
+Datum \
+hash##type##extended(PG_FUNCTION_ARGS) \
+{ \
+	return hash_uint32_extended((casttype) PG_GETARG_##BTYPE(0), PG_GETARG_INT64(1)); \
+} \
+extern int no_such_variable
+#else
+#define make_hashfunc_extended(type, BTYPE, casttype) \
+extern int no_such_variable
+#endif
+
 #define make_hashfunc(type, BTYPE, casttype) \
 PG_FUNCTION_INFO_V1(hash##type); \
 Datum \
@@ -11,7 +25,7 @@ hash##type(PG_FUNCTION_ARGS) \
 { \
 	return hash_uint32((casttype) PG_GETARG_##BTYPE(0)); \
 } \
-extern int no_such_variable
+make_hashfunc_extended(type, BTYPE, casttype)
 
 make_hashfunc(int1, INT8, int32);
 make_hashfunc(uint1, UINT8, uint32);
@@ -33,33 +47,112 @@ hashuint8(PG_FUNCTION_ARGS)
 	return hash_uint32(lohalf);
 }
 
-static Datum
-hash_uint128(__uint128_t val)
+#if PG_VERSION_NUM >= 110000
+PG_FUNCTION_INFO_V1(hashuint8extended);
+Datum
+hashuint8extended(PG_FUNCTION_ARGS)
+{
+	uint64		val = PG_GETARG_UINT64(0);
+	uint32		lohalf = (uint32) val;
+	uint32		hihalf = (uint32) (val >> 32);
+
+	lohalf ^= hihalf;
+
+	return hash_uint32_extended(lohalf, PG_GETARG_INT64(1));
+}
+#endif
+
+/*
+ * Fold to 32 bits like hashint8: the upper words of a value within int8
+ * range are all zeroes or all ones and cancel out, and negative values are
+ * complemented as in hashint8
+ */
+static inline uint32
+fold_uint128(__uint128_t val)
+{
+	return (uint32) val ^ (uint32) (val >> 32) ^
+		(uint32) (val >> 64) ^ (uint32) (val >> 96);
+}
+
+static inline uint32
+fold_int128(__int128_t val)
 {
-	uint32		q0 = (uint32) val;
-	uint32		q1 = (uint32) (val >> 32);
-	uint32		q2 = (uint32) (val >> 64);
-	uint32		q3 = (uint32) (val >> 96);
+	uint32		q = fold_uint128((__uint128_t) val);
+
+	return val < 0 ? ~q : q;
+}
 
-	q2 ^= q3;
-	q1 ^= q2;
-	q0 ^= q1;
+/* MurmurHash3's 64-bit finalizer */
+static inline uint64
+fmix64(uint64 h)
+{
+	h ^= h >> 33;
+	h *= UINT64CONST(0xff51afd7ed558ccd);
+	h ^= h >> 33;
+	h *= UINT64CONST(0xc4ceb9fe1a85ec53);
+	h ^= h >> 33;
+	return h;
+}
 
-	return hash_uint32(q0);
+/*
+ * Values outside [-2^63, 2^64) equal no int8 or uint8, so they need not
+ * hash like hashint8; mix both halves over the full width instead, so that
+ * keys with repeated or related halves, e.g. (a << 64) | a, don't collapse
+ * onto each other the way the fold does.  With seed 0 the low 32 bits are
+ * the 32-bit hash, as the extended hash contract requires.
+ */
+static inline uint64
+mix_uint128(__uint128_t val, uint64 seed)
+{
+	return fmix64((uint64) val + fmix64((uint64) (val >> 64) ^ seed));
 }
 
+#define FITS_UINT8(val)		((val) <= (__uint128_t) PG_UINT64_MAX)
+#define FITS_INT8_OR_UINT8(val) \
+	((val) >= PG_INT64_MIN && (val) <= (__int128_t) PG_UINT64_MAX)
+
 PG_FUNCTION_INFO_V1(hashint16);
 Datum
 hashint16(PG_FUNCTION_ARGS)
 {
-    xint128 *p = (xint128 *)PG_GETARG_POINTER(0);
-	return hash_uint128(p->i);
+	__int128_t	val = ((xint128 *)PG_GETARG_POINTER(0))->i;
+
+	if (FITS_INT8_OR_UINT8(val))
+		return hash_uint32(fold_int128(val));
+	return UInt32GetDatum((uint32) mix_uint128((__uint128_t) val, 0));
 }
 
 PG_FUNCTION_INFO_V1(hashuint16);
 Datum
 hashuint16(PG_FUNCTION_ARGS)
 {
-    xuint128 *p = (xuint128 *)PG_GETARG_POINTER(0);
-	return hash_uint128(p->i);
+	__uint128_t	val = ((xuint128 *)PG_GETARG_POINTER(0))->i;
+
+	if (FITS_UINT8(val))
+		return hash_uint32(fold_uint128(val));
+	return UInt32GetDatum((uint32) mix_uint128(val, 0));
+}
+
+#if PG_VERSION_NUM >= 110000
+PG_FUNCTION_INFO_V1(hashint16extended);
+Datum
+hashint16extended(PG_FUNCTION_ARGS)
+{
+	__int128_t	val = ((xint128 *)PG_GETARG_POINTER(0))->i;
+
+	if (FITS_INT8_OR_UINT8(val))
+		return hash_uint32_extended(fold_int128(val), PG_GETARG_INT64(1));
+	return UInt64GetDatum(mix_uint128((__uint128_t) val, PG_GETARG_INT64(1)));
+}
+
+PG_FUNCTION_INFO_V1(hashuint16extended);
+Datum
+hashuint16extended(PG_FUNCTION_ARGS)
+{
+	__uint128_t	val = ((xuint128 *)PG_GETARG_POINTER(0))->i;
+
+	if (FITS_UINT8(val))
+		return hash_uint32_extended(fold_uint128(val), PG_GETARG_INT64(1));
+	return UInt64GetDatum(mix_uint128(val, PG_GETARG_INT64(1)));
 }
+#endif
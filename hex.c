@@ -3,26 +3,15 @@
 #include <utils/builtins.h>
 
 #include "uint.h"
-
-#define HEXBASE 16
+#include "kernels.h"
 
 static text*
 _to_hex(uint64 value)
 {
-	char	   *ptr;
-	const char *digits = "0123456789abcdef";
-	char		buf[32];		/* bigger than needed, but reasonable */
-
-	ptr = buf + sizeof(buf) - 1;
-	*ptr = '\0';
-
-	do
-	{
-		*--ptr = digits[value % HEXBASE];
-		value /= HEXBASE;
-	} while (ptr > buf && value);
+	char		buf[17];		/* 16 digits, '\0' */
+	unsigned int len = uint_kernel->hex64(buf, value);
 
-	return cstring_to_text(ptr);
+	return cstring_to_text_with_len(buf, len);
 }
 
 #define make_to_hex(type, BTYPE) \
@@ -40,20 +29,10 @@ make_to_hex(uint8, UINT64);
 static text*
 _to_hex16(__uint128_t value)
 {
-	char	   *ptr;
-	const char *digits = "0123456789abcdef";
-	char		buf[40];		/* bigger than needed, but reasonable */
-
-	ptr = buf + sizeof(buf) - 1;
-	*ptr = '\0';
-
-	do
-	{
-		*--ptr = digits[value % HEXBASE];
-		value /= HEXBASE;
-	} while (ptr > buf && value);
+	char		buf[33];		/* 32 digits, '\0' */
+	unsigned int len = uint_kernel->hex128(buf, value);
 
-	return cstring_to_text(ptr);
+	return cstring_to_text_with_len(buf, len);
 }
 
 PG_FUNCTION_INFO_V1(to_hex_uint16);
@@ -0,0 +1,150 @@
+/*
+ * Hexadecimal output for to_hex()
+ * - lowercase digits without leading zeroes, like the core to_hex()
+ * - on x86-64, variants that look up all 16 digits of a 64-bit half at
+ *   once: a byte shuffle with SSE4 (SSSE3), both halves of a 128-bit
+ *   value in one register with AVX2, and the nibbles picked by a
+ *   multishift with AVX-512 VBMI; see cpu.h and kernels.h
+ */
+
+#include <string.h>
+
+#include "cpu.h"
+
+static const char hex_digits[16] = "0123456789abcdef";
+
+/* writes v into buf with a terminating NUL; returns the length */
+static inline unsigned int
+hex64(char *buf, uint64_t v)
+{
+	char tmp[16];
+	char *p = tmp + sizeof(tmp);
+	unsigned int n;
+
+	do { *--p = hex_digits[v & 15]; v >>= 4; } while (v);
+	n = tmp + sizeof(tmp) - p;
+	memcpy(buf, p, n);
+	buf[n] = 0;
+	return n;
+}
+
+static inline unsigned int
+hex128(char *buf, __uint128_t v)
+{
+	char tmp[32];
+	char *p = tmp + sizeof(tmp);
+	unsigned int n;
+
+	do { *--p = hex_digits[v & 15]; v >>= 4; } while (v);
+	n = tmp + sizeof(tmp) - p;
+	memcpy(buf, p, n);
+	buf[n] = 0;
+	return n;
+}
+
+#ifdef UINT_CPU_X86
+
+/* the number of hex digits of v, at least 1 */
+static inline unsigned int
+hex_len64(uint64_t v)
+{
+	return v ? 16 - (__builtin_clzll(v) >> 2) : 1;
+}
+
+/* the last n of the 16 or 32 digits in tmp */
+static inline unsigned int
+hex_tail(char *buf, const char *tmp, unsigned int width, unsigned int n)
+{
+	memcpy(buf, tmp + width - n, n);
+	buf[n] = 0;
+	return n;
+}
+
+/* all 16 digits of v, most significant first */
+UINT_TARGET_SSE4 static inline __m128i
+hex_16digits_sse4(uint64_t v)
+{
+	const __m128i lut = _mm_loadu_si128((const __m128i *)hex_digits);
+	const __m128i low4 = _mm_set1_epi8(0x0f);
+	__m128i x = _mm_cvtsi64_si128(__builtin_bswap64(v));
+	__m128i nibbles = _mm_unpacklo_epi8(_mm_and_si128(_mm_srli_epi16(x, 4), low4),
+										_mm_and_si128(x, low4));
+
+	return _mm_shuffle_epi8(lut, nibbles);
+}
+
+UINT_TARGET_SSE4 static inline unsigned int
+hex64_sse4(char *buf, uint64_t v)
+{
+	char tmp[16];
+
+	_mm_storeu_si128((__m128i *)tmp, hex_16digits_sse4(v));
+	return hex_tail(buf, tmp, 16, hex_len64(v));
+}
+
+UINT_TARGET_SSE4 static inline unsigned int
+hex128_sse4(char *buf, __uint128_t v)
+{
+	uint64_t hi = v >> 64;
+	unsigned int n;
+
+	if (!hi)
+		return hex64_sse4(buf, v);
+	n = hex64_sse4(buf, hi);
+	_mm_storeu_si128((__m128i *)(buf + n), hex_16digits_sse4(v));
+	buf[n + 16] = 0;
+	return n + 16;
+}
+
+/* the high half in the low lane, the low half in the high lane */
+UINT_TARGET_AVX2 static inline unsigned int
+hex128_avx2(char *buf, __uint128_t v)
+{
+	const __m256i lut = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)hex_digits));
+	const __m256i low4 = _mm256_set1_epi8(0x0f);
+	uint64_t hi = v >> 64;
+	__m256i x = _mm256_setr_epi64x(__builtin_bswap64(hi), 0, __builtin_bswap64(v), 0);
+	__m256i nibbles = _mm256_unpacklo_epi8(_mm256_and_si256(_mm256_srli_epi16(x, 4), low4),
+										   _mm256_and_si256(x, low4));
+	char tmp[32];
+
+	_mm256_storeu_si256((__m256i *)tmp, _mm256_shuffle_epi8(lut, nibbles));
+	return hex_tail(buf, tmp, 32, hi ? 16 + hex_len64(hi) : hex_len64(v));
+}
+
+/*
+ * a multishift puts the nibbles of both halves in place, and a byte
+ * permute, which only looks at the low bits of each index, looks them
+ * up; no masking or reordering needed
+ */
+UINT_TARGET_AVX512 static inline unsigned int
+hex64_avx512(char *buf, uint64_t v)
+{
+	const __m128i lut = _mm_loadu_si128((const __m128i *)hex_digits);
+	const __m128i shifts = _mm_setr_epi8(60, 56, 52, 48, 44, 40, 36, 32,
+										 28, 24, 20, 16, 12, 8, 4, 0);
+	char tmp[16];
+
+	_mm_storeu_si128((__m128i *)tmp,
+					 _mm_permutexvar_epi8(_mm_multishift_epi64_epi8(shifts, _mm_set1_epi64x(v)), lut));
+	return hex_tail(buf, tmp, 16, hex_len64(v));
+}
+
+UINT_TARGET_AVX512 static inline unsigned int
+hex128_avx512(char *buf, __uint128_t v)
+{
+	const __m256i lut = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)hex_digits));
+	const __m256i shifts = _mm256_setr_epi8(60, 56, 52, 48, 44, 40, 36, 32,
+											28, 24, 20, 16, 12, 8, 4, 0,
+											60, 56, 52, 48, 44, 40, 36, 32,
+											28, 24, 20, 16, 12, 8, 4, 0);
+	uint64_t hi = v >> 64;
+	__m256i x = _mm256_setr_epi64x(hi, hi, v, v);
+	char tmp[32];
+
+	_mm256_storeu_si256((__m256i *)tmp,
+						_mm256_permutexvar_epi8(_mm256_multishift_epi64_epi8(shifts, x), lut));
+	return hex_tail(buf, tmp, 32, hi ? 16 + hex_len64(hi) : hex_len64(v));
+}
+
+#endif /* UINT_CPU_X86 */
@@ -6,61 +6,36 @@
 #include <utils/builtins.h>
 
 #include "uint.h"
-#include "ntoa.h"
+#include "kernels.h"
 
 /* #include <inttypes.h> */
 #include <limits.h>
 
-/*
- * Copy of old pg_atoi() from PostgreSQL, cut down to support int8 only.
- */
 static int8
 my_pg_atoi8(const char *s)
 {
-	long		result;
-	char	   *badp;
+	uint64		result;
+	int			neg;
+	int			status;
 
-	/*
-	 * Some versions of strtol treat the empty string as an error, but some
-	 * seem not to.  Make an explicit test to be sure we catch it.
-	 */
 	if (s == NULL)
 		elog(ERROR, "NULL pointer");
-	if (*s == 0)
-		ereport(ERROR,
-				(errcode(ERRCODE_INVALID_TEXT_REPRESENTATION),
-				 errmsg("invalid input syntax for type %s: \"%s\"",
-						"integer", s)));
 
-	errno = 0;
-	result = strtol(s, &badp, 10);
+	status = uint_kernel->aton_u64(s, &neg, &result);
 
-	/* We made no progress parsing the string, so bail out */
-	if (s == badp)
-		ereport(ERROR,
-				(errcode(ERRCODE_INVALID_TEXT_REPRESENTATION),
-				 errmsg("invalid input syntax for type %s: \"%s\"",
-						"integer", s)));
-
-	if (errno == ERANGE || result < SCHAR_MIN || result > SCHAR_MAX)
+	if (status == ATON_RANGE || (status == ATON_OK &&
+								 result > (neg ? -SCHAR_MIN : SCHAR_MAX)))
 		ereport(ERROR,
 				(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
 				 errmsg("value \"%s\" is out of range for 8-bit integer", s)));
 
-	/*
-	 * Skip any trailing whitespace; if anything but whitespace remains before
-	 * the terminating character, bail out
-	 */
-	while (*badp && isspace((unsigned char) *badp))
-		badp++;
-
-	if (*badp)
+	if (status != ATON_OK)
 		ereport(ERROR,
 				(errcode(ERRCODE_INVALID_TEXT_REPRESENTATION),
 				 errmsg("invalid input syntax for type %s: \"%s\"",
 						"integer", s)));
 
-	return (int8) result;
+	return (int8) (neg ? -result : result);
 }
 
 PG_FUNCTION_INFO_V1(int1in);
@@ -105,61 +80,27 @@ int1send(PG_FUNCTION_ARGS)
 	PG_RETURN_BYTEA_P(pq_endtypsend(&buf));
 }
 
-static uint32
-pg_atou(const char *s, int size)
+static uint64
+pg_atou(const char *s, int size, uint64 max)
 {
-	unsigned long int result;
-	bool		out_of_range = false;
-	char	   *badp;
+	uint64		result;
+	int			neg;
+	int			status;
 
 	if (s == NULL)
 		elog(ERROR, "NULL pointer");
-	if (*s == 0)
-		ereport(ERROR,
-				(errcode(ERRCODE_INVALID_TEXT_REPRESENTATION),
-				 errmsg("invalid input syntax for unsigned integer: \"%s\"",
-						s)));
 
-	if (strchr(s, '-'))
-		ereport(ERROR,
-				(errcode(ERRCODE_INVALID_TEXT_REPRESENTATION),
-				 errmsg("invalid input syntax for unsigned integer: \"%s\"",
-						s)));
+	status = uint_kernel->aton_u64(s, &neg, &result);
 
-	errno = 0;
-	result = strtoul(s, &badp, 10);
+	if (neg)
+		status = ATON_SYNTAX;
 
-	switch (size)
-	{
-		case sizeof(uint32):
-			if (errno == ERANGE
-#if SIZEOF_LONG == 8
-				|| result > UINT_MAX
-#endif
-				)
-				out_of_range = true;
-			break;
-		case sizeof(uint16):
-			if (errno == ERANGE || result > USHRT_MAX)
-				out_of_range = true;
-			break;
-		case sizeof(uint8):
-			if (errno == ERANGE || result > UCHAR_MAX)
-				out_of_range = true;
-			break;
-		default:
-			elog(ERROR, "unsupported result size: %d", size);
-	}
-
-	if (out_of_range)
+	if (status == ATON_RANGE || (status == ATON_OK && result > max))
 		ereport(ERROR,
 				(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
 				 errmsg("value \"%s\" is out of range for type uint%d", s, size)));
 
-	while (*badp && isspace((unsigned char) *badp))
-		badp++;
-
-	if (*badp)
+	if (status != ATON_OK)
 		ereport(ERROR,
 				(errcode(ERRCODE_INVALID_TEXT_REPRESENTATION),
 				 errmsg("invalid input syntax for unsigned integer: \"%s\"",
@@ -174,7 +115,7 @@ uint1in(PG_FUNCTION_ARGS)
 {
 	char	   *s = PG_GETARG_CSTRING(0);
 
-	PG_RETURN_UINT8(pg_atou(s, sizeof(uint8)));
+	PG_RETURN_UINT8(pg_atou(s, sizeof(uint8), UCHAR_MAX));
 }
 
 PG_FUNCTION_INFO_V1(uint1out);
@@ -216,7 +157,7 @@ uint2in(PG_FUNCTION_ARGS)
 {
 	char	   *s = PG_GETARG_CSTRING(0);
 
-	PG_RETURN_UINT16(pg_atou(s, sizeof(uint16)));
+	PG_RETURN_UINT16(pg_atou(s, sizeof(uint16), USHRT_MAX));
 }
 
 PG_FUNCTION_INFO_V1(uint2out);
@@ -226,7 +167,7 @@ uint2out(PG_FUNCTION_ARGS)
 	uint16		arg1 = PG_GETARG_UINT16(0);
 	char	   *result = palloc(6);		/* 5 digits, '\0' */
 
-	utoa32(result, arg1);
+	uint_kernel->utoa32(result, arg1);
 	/* sprintf(result, "%u", arg1); */
 	PG_RETURN_CSTRING(result);
 }
@@ -258,7 +199,7 @@ uint4in(PG_FUNCTION_ARGS)
 {
 	char	   *s = PG_GETARG_CSTRING(0);
 
-	PG_RETURN_UINT32(pg_atou(s, sizeof(uint32)));
+	PG_RETURN_UINT32(pg_atou(s, sizeof(uint32), UINT_MAX));
 }
 
 PG_FUNCTION_INFO_V1(uint4out);
@@ -268,7 +209,7 @@ uint4out(PG_FUNCTION_ARGS)
 	uint32		arg1 = PG_GETARG_UINT32(0);
 	char	   *result = palloc(11);	/* 10 digits, '\0' */
 
-	utoa32(result, arg1);
+	uint_kernel->utoa32(result, arg1);
 	/* sprintf(result, "%u", arg1); */
 	PG_RETURN_CSTRING(result);
 }
@@ -299,41 +240,8 @@ Datum
 uint8in(PG_FUNCTION_ARGS)
 {
 	char	   *s = PG_GETARG_CSTRING(0);
-	unsigned long long int result;
-	char	   *badp;
-
-	if (s == NULL)
-		elog(ERROR, "NULL pointer");
-	if (*s == 0)
-		ereport(ERROR,
-				(errcode(ERRCODE_INVALID_TEXT_REPRESENTATION),
-				 errmsg("invalid input syntax for unsigned integer: \"%s\"",
-						s)));
 
-	if (strchr(s, '-'))
-		ereport(ERROR,
-				(errcode(ERRCODE_INVALID_TEXT_REPRESENTATION),
-				 errmsg("invalid input syntax for unsigned integer: \"%s\"",
-						s)));
-
-	errno = 0;
-	result = strtoull(s, &badp, 10);
-
-	if (errno == ERANGE)
-		ereport(ERROR,
-				(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
-				 errmsg("value \"%s\" is out of range for type uint%d", s, 8)));
-
-	while (*badp && isspace((unsigned char) *badp))
-		badp++;
-
-	if (*badp)
-		ereport(ERROR,
-				(errcode(ERRCODE_INVALID_TEXT_REPRESENTATION),
-				 errmsg("invalid input syntax for unsigned integer: \"%s\"",
-						s)));
-
-	PG_RETURN_UINT64(result);
+	PG_RETURN_UINT64(pg_atou(s, sizeof(uint64), ULLONG_MAX));
 }
 
 PG_FUNCTION_INFO_V1(uint8out);
@@ -343,7 +251,7 @@ uint8out(PG_FUNCTION_ARGS)
 	uint64		arg1 = PG_GETARG_UINT64(0);
 	char	   *result = palloc(21);	/* 20 digits, '\0' */
 
-	utoa64(result, arg1);
+	uint_kernel->utoa64(result, arg1);
 	/* sprintf(result, "%"PRIu64, (uint64_t) arg1); */
 	PG_RETURN_CSTRING(result);
 }
@@ -369,47 +277,22 @@ uint8send(PG_FUNCTION_ARGS)
 	PG_RETURN_BYTEA_P(pq_endtypsend(&buf));
 }
 
-static unsigned int
-atou128(const char *s, __uint128_t *r)
-{
-    int c = s[0];
-	__uint128_t v;
-	unsigned int o;
-	if (unlikely(c < '0' || c > '9')) return 0;
-	v = c - '0';
-	o = 1;
-	while (likely(o < 39 && (c = s[o]) >= '0' && c <= '9')) {
-		v = v * 10 + (c - '0');
-		++o;
-	}
-	*r = v;
-	return o;
-}
-
-static unsigned int
-atoi128(const char *s, __int128_t *r)
-{
-	if (s[0] == '-') {
-		unsigned int o = atou128(&s[1], (__uint128_t *)r);
-		if (!o) return 0;
-		*r = -*r;
-		return o + 1;
-	}
-	return atou128(s, (__uint128_t *)r);
-}
-
 PG_FUNCTION_INFO_V1(int16in);
 Datum
 int16in(PG_FUNCTION_ARGS)
 {
 	const char *s = PG_GETARG_CSTRING(0);
-	__int128_t i;
-	unsigned int n = atoi128(s, &i);
+	__uint128_t u;
+	int neg;
+	int status = uint_kernel->aton_u128(s, &neg, &u);
 
-	/* SQL requires trailing spaces to be ignored while erroring out on other
-	 * "trailing junk" */
-	if (likely(n)) while (unlikely(isspace(s[n]))) ++n;
-	if (!n || s[n])
+	if (status == ATON_RANGE ||
+		(status == ATON_OK && u > (((__uint128_t)1)<<127) - !neg))
+		ereport(
+			ERROR,
+			(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+			 errmsg("value \"%s\" is out of range for type int16", s)));
+	if (status != ATON_OK)
 		ereport(
 			ERROR,
 			(errcode(ERRCODE_INVALID_TEXT_REPRESENTATION),
@@ -417,7 +300,7 @@ int16in(PG_FUNCTION_ARGS)
 
 	{
 		xint128 *v = (xint128 *)palloc(sizeof(xint128));
-		v->i = i;
+		v->i = neg ? ~u + 1 : u;
 		PG_RETURN_POINTER(v);
 	}
 }
@@ -428,7 +311,7 @@ int16out(PG_FUNCTION_ARGS)
 {
 	xint128			*arg1 = (xint128 *)PG_GETARG_POINTER(0);
 	char			*result = palloc(41);	/* sign, 39 digits, '\0' */
-	itoa128(result, arg1->i);
+	uint_kernel->itoa128(result, arg1->i);
 	PG_RETURN_CSTRING(result);
 }
 
@@ -436,14 +319,19 @@ PG_FUNCTION_INFO_V1(uint16in);
 Datum
 uint16in(PG_FUNCTION_ARGS)
 {
-	__uint128_t i;
 	const char *s = PG_GETARG_CSTRING(0);
-	unsigned int n = atou128(s, &i);
+	__uint128_t i;
+	int neg;
+	int status = uint_kernel->aton_u128(s, &neg, &i);
 
-	/* SQL requires trailing spaces to be ignored while erroring out on other
-	 * "trailing junk" */
-	if (likely(n)) while (unlikely(isspace(s[n]))) ++n;
-	if (!n || s[n])
+	if (neg)
+		status = ATON_SYNTAX;
+	if (status == ATON_RANGE)
+		ereport(
+			ERROR,
+			(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+			 errmsg("value \"%s\" is out of range for type uint16", s)));
+	if (status != ATON_OK)
 		ereport(
 			ERROR,
 			(errcode(ERRCODE_INVALID_TEXT_REPRESENTATION),
@@ -462,7 +350,7 @@ uint16out(PG_FUNCTION_ARGS)
 {
 	xuint128		*arg1 = (xuint128 *)PG_GETARG_POINTER(0);
 	char			*result = palloc(40);	/* 39 digits, '\0' */
-	utoa128(result, arg1->i);
+	uint_kernel->utoa128(result, arg1->i);
 	PG_RETURN_CSTRING(result);
 }
 
@@ -0,0 +1,65 @@
+#include <postgres.h>
+#include <fmgr.h>
+#include <utils/guc.h>
+
+#include "kernels.h"
+
+/*
+ * The conversion kernels in use, chosen when the library is loaded.
+ * uint.cpu_level can force a lower level, to compare them or to rule
+ * one out; a level above what the CPU supports gets the highest one it
+ * does support.
+ */
+
+const uint_kernels *uint_kernel;
+
+#define UINT_CPU_AUTO (-1)
+
+static const struct config_enum_entry cpu_level_options[] = {
+	{"auto", UINT_CPU_AUTO, false},
+	{"generic", UINT_CPU_GENERIC, false},
+	{"sse4", UINT_CPU_SSE4, false},
+	{"avx2", UINT_CPU_AVX2, false},
+	{"avx512", UINT_CPU_AVX512, false},
+	{NULL, 0, false}
+};
+
+static int	cpu_level = UINT_CPU_AUTO;
+static uint_cpu_level cpu_detected;
+
+static void
+assign_cpu_level(int newval, void *extra)
+{
+	uint_cpu_level level = cpu_detected;
+
+	if (newval != UINT_CPU_AUTO && newval < (int) level)
+		level = newval;
+	uint_kernel = uint_kernels_for(level);
+}
+
+void _PG_init(void);
+
+void
+_PG_init(void)
+{
+	cpu_detected = uint_cpu_detect();
+	uint_kernel = uint_kernels_for(cpu_detected);
+
+	DefineCustomEnumVariable("uint.cpu_level",
+							 "Selects the CPU level of the conversion kernels.",
+							 "auto uses the best level the CPU supports.",
+							 &cpu_level,
+							 UINT_CPU_AUTO,
+							 cpu_level_options,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 assign_cpu_level,
+							 NULL);
+
+#if PG_VERSION_NUM >= 150000
+	MarkGUCPrefixReserved("uint");
+#else
+	EmitWarningsOnPlaceholders("uint");
+#endif
+}
@@ -0,0 +1,43 @@
+/*
+ * The conversion kernels of ntoa.h, aton.h and hex.h for each CPU level
+ * of cpu.h.  The extension calls them through uint_kernel, which
+ * kernels.c points at the best level of the CPU when the library is
+ * loaded (or at a lower one chosen with uint.cpu_level).
+ */
+
+#include "cpu.h"
+#include "ntoa.h"
+#include "aton.h"
+#include "hex.h"
+
+typedef struct
+{
+	void		(*utoa32) (char *buf, uint32_t v);
+	void		(*utoa64) (char *buf, uint64_t v);
+	void		(*utoa128) (char *buf, __uint128_t v);
+	void		(*itoa128) (char *buf, __int128_t v);
+	int			(*aton_u64) (const char *s, int *neg, uint64_t *r);
+	int			(*aton_u128) (const char *s, int *neg, __uint128_t *r);
+	unsigned int (*hex64) (char *buf, uint64_t v);
+	unsigned int (*hex128) (char *buf, __uint128_t v);
+} uint_kernels;
+
+extern const uint_kernels *uint_kernel;
+
+static inline const uint_kernels *
+uint_kernels_for(uint_cpu_level level)
+{
+	static const uint_kernels kernels[UINT_CPU_LEVELS] = {
+		{utoa32, utoa64, utoa128, itoa128, aton_u64, aton_u128, hex64, hex128},
+#ifdef UINT_CPU_X86
+		{utoa32_sse4, utoa64_sse4, utoa128_sse4, itoa128_sse4,
+		 aton_u64_sse4, aton_u128_sse4, hex64_sse4, hex128_sse4},
+		{utoa32_avx2, utoa64_avx2, utoa128_avx2, itoa128_avx2,
+		 aton_u64_avx2, aton_u128_avx2, hex64_sse4, hex128_avx2},
+		{utoa32_avx512, utoa64_avx512, utoa128_avx512, itoa128_avx512,
+		 aton_u64_avx512, aton_u128_avx512, hex64_avx512, hex128_avx512},
+#endif
+	};
+
+	return &kernels[level];
+}
@@ -1,10 +1,37 @@
 #include <postgres.h>
 #include <fmgr.h>
 
+#include <limits.h>
+
 #include "uint.h"
 #include "unumeric.h"
 
 
+void
+uint_out_of_range_error(void)
+{
+	ereport(ERROR,
+			(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+			 errmsg("integer out of range")));
+}
+
+void
+uint_cast_out_of_range_error(const char *typname)
+{
+	ereport(ERROR,
+			(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+			 errmsg("%s out of range", typname)));
+}
+
+void
+uint_division_by_zero_error(void)
+{
+	ereport(ERROR,
+			(errcode(ERRCODE_DIVISION_BY_ZERO),
+			 errmsg("division by zero")));
+}
+
+
 PG_FUNCTION_INFO_V1(int1um);
 Datum
 int1um(PG_FUNCTION_ARGS)
@@ -12,12 +39,8 @@ int1um(PG_FUNCTION_ARGS)
 	int8		arg = PG_GETARG_INT8(0);
 	int8		result;
 
-	result = -arg;
-	/* overflow check */
-	if (arg != 0 && SAMESIGN(result, arg))
-		ereport(ERROR,
-				(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
-				 errmsg("integer out of range")));
+	if (__builtin_sub_overflow(0, arg, &result))
+		uint_out_of_range_error();
 	PG_RETURN_INT8(result);
 }
 
@@ -28,52 +51,51 @@ int16um(PG_FUNCTION_ARGS)
 {
 	xint128 *arg = (xint128 *)PG_GETARG_POINTER(0);
 	xint128 *result = (xint128 *)palloc(sizeof(xint128));
+	__int128_t value;
 
-	result->i = -(arg->i);
-	/* overflow check */
-	if (arg != 0 && SAMESIGN((result->i), arg))
-		ereport(ERROR,
-				(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
-				 errmsg("integer out of range")));
+	if (__builtin_sub_overflow(0, arg->i, &value))
+		uint_out_of_range_error();
+	result->i = value;
 	PG_RETURN_POINTER(result);
 }
 
-#define casts(type, ntype, size) \
+#define casts(type, ntype, TYPE, min, max) \
 PG_FUNCTION_INFO_V1(type##_to_double); \
 Datum type##_to_double(PG_FUNCTION_ARGS) { \
-	PG_RETURN_FLOAT8(PG_GETARG_INT##size(0)); \
+	PG_RETURN_FLOAT8(PG_GETARG_##TYPE(0)); \
 } \
  \
 PG_FUNCTION_INFO_V1(type##_to_numeric); \
 Datum type##_to_numeric(PG_FUNCTION_ARGS) { \
-	PG_RETURN_POINTER(ntype##_to_numeric(PG_GETARG_INT##size(0))); \
+	PG_RETURN_POINTER(ntype##_to_numeric(PG_GETARG_##TYPE(0))); \
 } \
  \
 PG_FUNCTION_INFO_V1(type##_to_real); \
 Datum type##_to_real(PG_FUNCTION_ARGS) { \
-	PG_RETURN_FLOAT4(PG_GETARG_INT##size(0)); \
+	PG_RETURN_FLOAT4(PG_GETARG_##TYPE(0)); \
 } \
  \
 PG_FUNCTION_INFO_V1(type##_from_double); \
 Datum type##_from_double(PG_FUNCTION_ARGS) { \
-	PG_RETURN_INT##size(PG_GETARG_FLOAT8(0)); \
+	PG_RETURN_##TYPE(PG_GETARG_FLOAT8(0)); \
 } \
  \
 PG_FUNCTION_INFO_V1(type##_from_numeric); \
 Datum type##_from_numeric(PG_FUNCTION_ARGS) { \
-	PG_RETURN_INT##size(numeric_to_##ntype((Numeric)PG_GETARG_POINTER(0))); \
+	PG_RETURN_##TYPE(numeric_to_##ntype##_range(PG_GETARG_NUMERIC(0), \
+												 min, max, #type)); \
 } \
  \
 PG_FUNCTION_INFO_V1(type##_from_real); \
 Datum type##_from_real(PG_FUNCTION_ARGS) { \
-	PG_RETURN_INT##size(PG_GETARG_FLOAT4(0)); \
+	PG_RETURN_##TYPE(PG_GETARG_FLOAT4(0)); \
 }
 
-casts(int1, int64, 8)
-casts(uint1, int64, 8)
-casts(uint2, int64, 16)
-casts(uint4, int64, 32)
-casts(uint8, uint64, 64)
+casts(int1, int64, INT8, SCHAR_MIN, SCHAR_MAX)
+casts(uint1, int64, UINT8, 0, UCHAR_MAX)
+casts(uint2, int64, UINT16, 0, USHRT_MAX)
+casts(uint4, int64, UINT32, 0, UINT_MAX)
+casts(uint8, uint64, UINT64, 0, PG_UINT64_MAX)
 
 #define casts128(type, ntype) \
 PG_FUNCTION_INFO_V1(type##_to_double); \
@@ -102,7 +124,7 @@ Datum type##_from_double(PG_FUNCTION_ARGS) { \
 PG_FUNCTION_INFO_V1(type##_from_numeric); \
 Datum type##_from_numeric(PG_FUNCTION_ARGS) { \
     x##ntype *v = (x##ntype *)palloc(sizeof(x##ntype)); \
-	v->i = numeric_to_##ntype((Numeric)PG_GETARG_POINTER(0)); \
+	v->i = numeric_to_##ntype(PG_GETARG_NUMERIC(0)); \
 	PG_RETURN_POINTER(v); \
 } \
  \
@@ -115,3 +137,35 @@ Datum type##_from_real(PG_FUNCTION_ARGS) { \
 
 casts128(int16, int128);
 casts128(uint16, uint128);
+
+/*
+ * int16 <-> int16a, uint16 <-> uint16a: the aligned variants differ only in
+ * their on-disk alignment, the in-memory value is shared
+ */
+PG_FUNCTION_INFO_V1(uint128_realign);
+Datum uint128_realign(PG_FUNCTION_ARGS) {
+	PG_RETURN_DATUM(PG_GETARG_DATUM(0));
+}
+
+/*
+ * the previous numeric casts, for the differential regression test; these
+ * are not part of the extension, see test/sql/numeric.sql
+ */
+PG_FUNCTION_INFO_V1(uint8_from_numeric_ref);
+Datum uint8_from_numeric_ref(PG_FUNCTION_ARGS) {
+	PG_RETURN_UINT64(numeric_to_uint64_ref(PG_GETARG_NUMERIC(0)));
+}
+
+PG_FUNCTION_INFO_V1(int16_from_numeric_ref);
+Datum int16_from_numeric_ref(PG_FUNCTION_ARGS) {
+	xint128 *v = (xint128 *)palloc(sizeof(xint128));
+	v->i = numeric_to_int128_ref(PG_GETARG_NUMERIC(0));
+	PG_RETURN_POINTER(v);
+}
+
+PG_FUNCTION_INFO_V1(uint16_from_numeric_ref);
+Datum uint16_from_numeric_ref(PG_FUNCTION_ARGS) {
+	xuint128 *v = (xuint128 *)palloc(sizeof(xuint128));
+	v->i = numeric_to_uint128_ref(PG_GETARG_NUMERIC(0));
+	PG_RETURN_POINTER(v);
+}
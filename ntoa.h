@@ -5,8 +5,19 @@
  *   implementation falls back to C code
  * - convert log2 to log10 using small lookup tables
  * - use log10 to jump forward and output decimal backwards
+ * - output 4 digits per step, 2 at a time from a lookup table, so that
+ *   each step costs one multiply-by-reciprocal rather than a division
+ *   per digit
+ * - split 128-bit values into 19-digit 64-bit chunks, dividing by 10^19
+ *   with a multiply-high rather than calling __udivti3/__umodti3
+ * - on x86-64, variants that emit 8 or 16 digits per step with SSE4,
+ *   AVX2 or AVX-512 IFMA; see cpu.h and kernels.h
  */
 
+#include <string.h>
+
+#include "cpu.h"
+
 /* define likely/unlikely if needed */
 #ifdef __GNUC__
 #ifndef likely
@@ -40,7 +51,7 @@
 
 /* CLZ third choice: fallback C code */
 #ifndef clz32
-static uint32_t
+static inline uint32_t
 clz32_(uint32_t v)
 {
     v |= (v >> 1);
@@ -58,7 +69,7 @@ clz32_(uint32_t v)
 #define clz32(v) clz32_(v)
 #endif
 #ifndef clz64
-static uint64_t
+static inline uint64_t
 clz64_(uint64_t v)
 {
     return (v>>32) ? clz32(v>>32) : 32 + clz32(v);
@@ -69,7 +80,7 @@ clz64_(uint64_t v)
 /*
  * pow10 using LUTs
  */
-static uint32_t
+static inline uint32_t
 pow10_32(unsigned int i)
 {
 	static uint32_t pow10[] = {
@@ -87,7 +98,7 @@ pow10_32(unsigned int i)
 	return pow10[i];
 }
 
-static uint64_t
+static inline uint64_t
 pow10_64(unsigned int i)
 {
 	static uint64_t pow10[] = {
@@ -115,10 +126,45 @@ pow10_64(unsigned int i)
 	return pow10[i];
 }
 
+/*
+ * output exactly n digits of v into buf[0..n), zero-padded; stores go
+ * to buf + n - k after checking n >= k, so the compiler can see that
+ * they stay inside the field
+ */
+static const char ntoa_pairs[200] =
+	"00010203040506070809"
+	"10111213141516171819"
+	"20212223242526272829"
+	"30313233343536373839"
+	"40414243444546474849"
+	"50515253545556575859"
+	"60616263646566676869"
+	"70717273747576777879"
+	"80818283848586878889"
+	"90919293949596979899";
+
+static inline void
+ntoa_digits(char *buf, uint64_t v, unsigned int n)
+{
+	while (n >= 4) {
+		uint32_t r = v % 10000;
+		v /= 10000;
+		n -= 4;
+		memcpy(buf + n, &ntoa_pairs[(r / 100) * 2], 2);
+		memcpy(buf + n + 2, &ntoa_pairs[(r % 100) * 2], 2);
+	}
+	if (n >= 2) {
+		n -= 2;
+		memcpy(buf + n, &ntoa_pairs[(v % 100) * 2], 2);
+		v /= 100;
+	}
+	if (n) buf[0] = v + '0';
+}
+
 /*
  * ntoa using clz, LUT, pow10
  */
-static void
+static inline void
 utoa8(char *buf, uint8_t v)
 {
 	unsigned int n;
@@ -132,7 +178,7 @@ utoa8(char *buf, uint8_t v)
 	do { buf[--n] = (v % 10) + '0'; v /= 10; } while (likely(n));
 }
 
-static void
+static inline void
 itoa8(char *buf, int8_t v_)
 {
 	uint8_t v = v_;
@@ -143,8 +189,21 @@ itoa8(char *buf, int8_t v_)
 	utoa8(buf, v);
 }
 
-static void
-utoa32(char *buf, uint32_t v)
+/*
+ * the conversions above ntoa_digits, taking the digit emitter as a
+ * parameter; the generic kernels and each CPU variant below inline
+ * them with their own
+ */
+typedef void (*ntoa_digits_fn)(char *buf, uint64_t v, unsigned int n);
+
+#ifdef __GNUC__
+#define ntoa_always_inline inline __attribute__((always_inline))
+#else
+#define ntoa_always_inline inline
+#endif
+
+static ntoa_always_inline void
+utoa32_with(char *buf, uint32_t v, ntoa_digits_fn digits)
 {
 	static uint8_t clz10[] = {
 		20, 20, 19, 18, 18, 17, 16, 16, 15, 14,
@@ -165,10 +224,10 @@ utoa32(char *buf, uint32_t v)
 		}
 	}
 	buf[n] = 0;
-	do { buf[--n] = (v % 10) + '0'; v /= 10; } while (likely(n));
+	digits(buf, v, n);
 }
 
-static unsigned int
+static inline unsigned int
 log10_64(uint64_t v)
 {
 	static uint8_t clz10[] = {
@@ -195,48 +254,262 @@ log10_64(uint64_t v)
 	return n;
 }
 
-static void
-utoa64(char *buf, uint64_t v)
+static ntoa_always_inline void
+utoa64_with(char *buf, uint64_t v, ntoa_digits_fn digits)
 {
 	unsigned n = log10_64(v);
 	buf[n] = 0;
-	do { buf[--n] = (v % 10) + '0'; v /= 10; } while (likely(n));
+	digits(buf, v, n);
 }
 
-static unsigned int
-log10_128(__uint128_t v)
-{
-     __uint128_t f = (__uint128_t)10000000000000000000ULL;
-     unsigned int n;
-	 if (likely(v < f))
-		 n = log10_64(v);
-     else {
-	     v /= f;
-		 if (likely(v < f))
-		   n = log10_64(v) + 19;
-		 else {
-		   v /= f;
-		   n = log10_64(v) + 38;
-		 }
-	 }
-	return n;
+/*
+ * v / 10^19 == (v >> 19) / 5^19, and (v >> 19) < 2^109, so
+ * ((v >> 19) * ceil(2^154 / 5^19)) >> 154 is exact for all v
+ */
+static inline __uint128_t
+div1e19(__uint128_t v)
+{
+	const uint64_t m1 = 0x3b07929f6da5ULL;
+	const uint64_t m0 = 0x58694acc7a78f41cULL;
+	uint64_t n1, n0;
+	__uint128_t p00, p01, p10, p11, mid;
+
+	v >>= 19;
+	n1 = v >> 64;
+	n0 = v;
+	p00 = (__uint128_t)n0 * m0;
+	p01 = (__uint128_t)n0 * m1;
+	p10 = (__uint128_t)n1 * m0;
+	p11 = (__uint128_t)n1 * m1;
+	mid = (p00 >> 64) + (uint64_t)p01 + (uint64_t)p10;
+	return (p11 + (p01 >> 64) + (p10 >> 64) + (mid >> 64)) >> 26;
 }
 
-static void
-utoa128(char *buf, __uint128_t v)
+static ntoa_always_inline void
+utoa128_with(char *buf, __uint128_t v, ntoa_digits_fn digits)
 {
-	unsigned n = log10_128(v);
-	buf[n] = 0;
-	do { buf[--n] = (v % 10) + '0'; v /= 10; } while (likely(n));
+	const uint64_t f = 10000000000000000000ULL;
+	__uint128_t q;
+	uint64_t lo;
+
+	if (likely(!(uint64_t)(v >> 64))) {
+		utoa64_with(buf, v, digits);
+		return;
+	}
+	q = div1e19(v);
+	lo = v - q * f;
+	if (likely(!(uint64_t)(q >> 64)) && likely((uint64_t)q < f)) {
+		/* 20..38 digits */
+		unsigned int n = log10_64(q);
+		digits(buf, q, n);
+		buf += n;
+	} else {
+		/* 39 digits; q < 2^128 / 10^19 < 4 * 10^19 */
+		unsigned int top = 0;
+		while (q >= f) { q -= f; ++top; }
+		*buf++ = top + '0';
+		digits(buf, q, 19);
+		buf += 19;
+	}
+	digits(buf, lo, 19);
+	buf[19] = 0;
 }
 
-static void
-itoa128(char *buf, __int128_t v_)
+static ntoa_always_inline void
+itoa128_with(char *buf, __int128_t v_, ntoa_digits_fn digits)
 {
 	__uint128_t v = v_;
 	if (v_ < 0) {
 		*buf++ = '-';
 		v = ~v + 1;
 	}
-	utoa128(buf, v);
+	utoa128_with(buf, v, digits);
+}
+
+/* the generic kernels */
+static inline void
+utoa32(char *buf, uint32_t v)
+{
+	utoa32_with(buf, v, ntoa_digits);
+}
+
+static inline void
+utoa64(char *buf, uint64_t v)
+{
+	utoa64_with(buf, v, ntoa_digits);
+}
+
+static inline void
+utoa128(char *buf, __uint128_t v)
+{
+	utoa128_with(buf, v, ntoa_digits);
+}
+
+static inline void
+itoa128(char *buf, __int128_t v)
+{
+	itoa128_with(buf, v, ntoa_digits);
+}
+
+#ifdef UINT_CPU_X86
+
+#define NTOA_VARIANTS(sfx, target, digits) \
+target static inline void \
+utoa32_##sfx(char *buf, uint32_t v) \
+{ \
+	utoa32_with(buf, v, digits); \
+} \
+target static inline void \
+utoa64_##sfx(char *buf, uint64_t v) \
+{ \
+	utoa64_with(buf, v, digits); \
+} \
+target static inline void \
+utoa128_##sfx(char *buf, __uint128_t v) \
+{ \
+	utoa128_with(buf, v, digits); \
+} \
+target static inline void \
+itoa128_##sfx(char *buf, __int128_t v) \
+{ \
+	itoa128_with(buf, v, digits); \
+}
+
+/*
+ * the 8 digits of v < 10^8 in the 16-bit lanes, most significant first:
+ * v / 10^4 and v % 10^4 by a multiply-high, then each half divided by
+ * 10^3, 10^2, 10^1 and 10^0 at once, and 10 times the digits above
+ * subtracted (Muła's SSE2 method)
+ */
+UINT_TARGET_SSE4 static inline __m128i
+ntoa_8lanes_sse4(uint32_t v)
+{
+	const __m128i div10000 = _mm_set1_epi32(0xd1b71759);
+	const __m128i divpowers = _mm_setr_epi16(8389, 5243, 13108, -32768,
+											 8389, 5243, 13108, -32768);
+	const __m128i shiftpowers = _mm_setr_epi16(1 << 7, 1 << 11, 1 << 13, -32768,
+											   1 << 7, 1 << 11, 1 << 13, -32768);
+	__m128i x = _mm_cvtsi32_si128(v);
+	__m128i hi = _mm_srli_epi64(_mm_mul_epu32(x, div10000), 45);
+	__m128i lo = _mm_sub_epi32(x, _mm_mul_epu32(hi, _mm_set1_epi32(10000)));
+	__m128i t = _mm_slli_epi64(_mm_unpacklo_epi16(hi, lo), 2);
+
+	t = _mm_unpacklo_epi16(t, t);
+	t = _mm_unpacklo_epi32(t, t);
+	t = _mm_mulhi_epu16(_mm_mulhi_epu16(t, divpowers), shiftpowers);
+	return _mm_sub_epi16(t, _mm_slli_epi64(_mm_mullo_epi16(t, _mm_set1_epi16(10)), 16));
+}
+
+UINT_TARGET_SSE4 static inline void
+ntoa_digits_sse4(char *buf, uint64_t v, unsigned int n)
+{
+	const __m128i zero = _mm_set1_epi8('0');
+
+	while (n >= 16) {
+		uint64_t r = v % 10000000000000000ULL;
+		__m128i d = _mm_packus_epi16(ntoa_8lanes_sse4(r / 100000000),
+									 ntoa_8lanes_sse4(r % 100000000));
+		v /= 10000000000000000ULL;
+		n -= 16;
+		_mm_storeu_si128((__m128i *)(buf + n), _mm_add_epi8(d, zero));
+	}
+	if (n >= 8) {
+		__m128i d = _mm_packus_epi16(ntoa_8lanes_sse4(v % 100000000),
+									 _mm_setzero_si128());
+		v /= 100000000;
+		n -= 8;
+		_mm_storel_epi64((__m128i *)(buf + n), _mm_add_epi8(d, zero));
+	}
+	ntoa_digits(buf, v, n);
+}
+
+NTOA_VARIANTS(sse4, UINT_TARGET_SSE4, ntoa_digits_sse4)
+
+/* as ntoa_8lanes_sse4, for v / 10^8 in the low and v % 10^8 in the high lane */
+UINT_TARGET_AVX2 static inline __m128i
+ntoa_16digits_avx2(uint64_t v)
+{
+	const __m256i div10000 = _mm256_set1_epi32(0xd1b71759);
+	const __m256i divpowers = _mm256_setr_epi16(8389, 5243, 13108, -32768,
+												8389, 5243, 13108, -32768,
+												8389, 5243, 13108, -32768,
+												8389, 5243, 13108, -32768);
+	const __m256i shiftpowers = _mm256_setr_epi16(1 << 7, 1 << 11, 1 << 13, -32768,
+												  1 << 7, 1 << 11, 1 << 13, -32768,
+												  1 << 7, 1 << 11, 1 << 13, -32768,
+												  1 << 7, 1 << 11, 1 << 13, -32768);
+	__m256i x = _mm256_setr_epi32(v / 100000000, 0, 0, 0, v % 100000000, 0, 0, 0);
+	__m256i hi = _mm256_srli_epi64(_mm256_mul_epu32(x, div10000), 45);
+	__m256i lo = _mm256_sub_epi32(x, _mm256_mul_epu32(hi, _mm256_set1_epi32(10000)));
+	__m256i t = _mm256_slli_epi64(_mm256_unpacklo_epi16(hi, lo), 2);
+
+	t = _mm256_unpacklo_epi16(t, t);
+	t = _mm256_unpacklo_epi32(t, t);
+	t = _mm256_mulhi_epu16(_mm256_mulhi_epu16(t, divpowers), shiftpowers);
+	t = _mm256_sub_epi16(t, _mm256_slli_epi64(_mm256_mullo_epi16(t, _mm256_set1_epi16(10)), 16));
+	/* the 8 digits of each lane, twice; keep one copy of each */
+	t = _mm256_permute4x64_epi64(_mm256_packus_epi16(t, t), 0x08);
+	return _mm_add_epi8(_mm256_castsi256_si128(t), _mm_set1_epi8('0'));
+}
+
+UINT_TARGET_AVX2 static inline void
+ntoa_digits_avx2(char *buf, uint64_t v, unsigned int n)
+{
+	while (n >= 16) {
+		n -= 16;
+		_mm_storeu_si128((__m128i *)(buf + n), ntoa_16digits_avx2(v % 10000000000000000ULL));
+		v /= 10000000000000000ULL;
+	}
+	ntoa_digits_sse4(buf, v, n);
 }
+
+NTOA_VARIANTS(avx2, UINT_TARGET_AVX2, ntoa_digits_avx2)
+
+/*
+ * the 16 digits of v < 10^16 as ASCII: for each half x < 10^8, lane k
+ * computes the fraction of x / 10^(8-k) in 52 bits by a multiply-low,
+ * and the digit as 10 times that fraction by a multiply-high; with
+ * ceil(2^52 / 10^j) the error stays below one step of the fraction,
+ * except for j = 8, which uses the floor and a bias
+ */
+UINT_TARGET_AVX512 static inline __m128i
+ntoa_16digits_avx512(uint64_t v)
+{
+	const __m512i recip = _mm512_setr_epi64(0x2af31dc, 0x1ad7f29b, 0x10c6f7a0c,
+											0xa7c5ac472, 0x68db8bac72, 0x4189374bc6b,
+											0x28f5c28f5c29, 0x199999999999a);
+	const __m512i bias = _mm512_setr_epi64(0x1a1a400, 0, 0, 0, 0, 0, 0, 0);
+	const __m512i ten = _mm512_set1_epi64(10);
+	const __m512i zero = _mm512_set1_epi64('0');
+	/* byte 0 of each lane of the high, then of the low half */
+	const __m512i first_bytes = _mm512_castsi128_si512(
+		_mm_setr_epi8(0x00, 0x08, 0x10, 0x18, 0x20, 0x28, 0x30, 0x38,
+					  0x40, 0x48, 0x50, 0x58, 0x60, 0x68, 0x70, 0x78));
+	__m512i hi = _mm512_madd52lo_epu64(bias, _mm512_set1_epi64(v / 100000000), recip);
+	__m512i lo = _mm512_madd52lo_epu64(bias, _mm512_set1_epi64(v % 100000000), recip);
+
+	hi = _mm512_madd52hi_epu64(zero, ten, hi);
+	lo = _mm512_madd52hi_epu64(zero, ten, lo);
+	return _mm512_castsi512_si128(_mm512_permutex2var_epi8(hi, first_bytes, lo));
+}
+
+UINT_TARGET_AVX512 static inline void
+ntoa_digits_avx512(char *buf, uint64_t v, unsigned int n)
+{
+	while (n >= 16) {
+		n -= 16;
+		_mm_storeu_si128((__m128i *)(buf + n), ntoa_16digits_avx512(v % 10000000000000000ULL));
+		v /= 10000000000000000ULL;
+	}
+	if (n >= 8) {
+		n -= 8;
+		_mm_storel_epi64((__m128i *)(buf + n),
+						 _mm_srli_si128(ntoa_16digits_avx512(v % 100000000), 8));
+		v /= 100000000;
+	}
+	ntoa_digits(buf, v, n);
+}
+
+NTOA_VARIANTS(avx512, UINT_TARGET_AVX512, ntoa_digits_avx512)
+
+#endif /* UINT_CPU_X86 */
@@ -10,11 +10,68 @@ typedef __int128_t int128_t;
 typedef __uint128_t uint128_t;
 
 #include "ntoa.h"
+#include "aton.h"
 
 /*
  * ntoa.h test program
  */
 
+/*
+ * reference digit-at-a-time implementations the chunked emitter replaced;
+ * every utoa32/utoa64/utoa128 result below is compared against these
+ */
+static void
+ref_utoa32(char *buf, uint32_t v)
+{
+	unsigned int n = v ? log10_64(v) : 1;
+	buf[n] = 0;
+	do { buf[--n] = (v % 10) + '0'; v /= 10; } while (n);
+}
+
+static void
+ref_utoa64(char *buf, uint64_t v)
+{
+	unsigned n = log10_64(v);
+	buf[n] = 0;
+	do { buf[--n] = (v % 10) + '0'; v /= 10; } while (n);
+}
+
+static unsigned int
+ref_log10_128(uint128_t v)
+{
+	uint128_t f = (uint128_t)10000000000000000000ULL;
+	unsigned int n;
+	if (v < f)
+		n = log10_64(v);
+	else {
+		v /= f;
+		if (v < f)
+			n = log10_64(v) + 19;
+		else {
+			v /= f;
+			n = log10_64(v) + 38;
+		}
+	}
+	return n;
+}
+
+static void
+ref_utoa128(char *buf, uint128_t v)
+{
+	unsigned n = ref_log10_128(v);
+	buf[n] = 0;
+	do { buf[--n] = (v % 10) + '0'; v /= 10; } while (n);
+}
+
+static void
+check_utoa128(uint128_t i)
+{
+	char buf[48], ref[48];
+	utoa128(buf, i);
+	ref_utoa128(ref, i);
+	assert(!strcmp(buf, ref));
+}
+
 void
 testi8()
 {
@@ -58,11 +115,13 @@ testu32()
 {
 	uint32_t i;
 	unsigned int n;
-	char buf[16];
+	char buf[16], ref[16];
 
 	i = 0;
 	do {
 		utoa32(buf, i);
+		ref_utoa32(ref, i);
+		assert(!strcmp(buf, ref));
 		n = strlen(buf);
 		assert(n > 0 && n <= 10);
 		assert(!i || buf[0] != '0');
@@ -77,11 +136,13 @@ testu64()
 {
 	uint64_t i;
 	unsigned int n;
-	char buf[24];
+	char buf[24], ref[24];
 
 	i = 0;
 	do {
 		utoa64(buf, i);
+		ref_utoa64(ref, i);
+		assert(!strcmp(buf, ref));
 		n = strlen(buf);
 		assert(n > 0 && n <= 20);
 		assert(!i || buf[0] != '0');
@@ -91,35 +152,6 @@ testu64()
 	printf("uint64_t final value %s\n", buf);
 }
 
-static unsigned int
-atou128(const char *s, uint128_t *r)
-{
-    int c = s[0];
-	uint128_t v;
-	unsigned int o;
-	if (unlikely(c < '0' || c > '9')) return 0;
-	v = c - '0';
-	o = 1;
-	while (likely(o < 39 && (c = s[o]) >= '0' && c <= '9')) {
-		v = v * 10 + (c - '0');
-		++o;
-	}
-	*r = v;
-	return o;
-}
-
-static unsigned int
-atoi128(const char *s, int128_t *r)
-{
-	if (s[0] == '-') {
-		unsigned int o = atou128(&s[1], (uint128_t *)r);
-		if (!o) return 0;
-		*r = -*r;
-		return o + 1;
-	}
-	return atou128(s, (uint128_t *)r);
-}
-
 /* integer signed wraparound is UB and breaks with optimization,
  * so avoid that below */
 
@@ -133,12 +165,15 @@ testi128()
 	i = ((uint128_t)1)<<127;
 	do {
 		itoa128(buf, i);
+		check_utoa128(i < 0 ? -(uint128_t)i : (uint128_t)i);
 		n = strlen(buf);
 		assert(n > 0 && n <= 40);
 		assert(!i || buf[0] != '0');
-		int128_t j;
-		assert(atoi128(buf, &j) == n);
-		assert(i == j);
+		uint128_t j;
+		int neg;
+		assert(aton_u128(buf, &neg, &j) == ATON_OK);
+		assert(neg == (i < 0));
+		assert(i == (int128_t)(neg ? ~j + 1 : j));
 		i += (((int128_t)0x00000100)<<96);
 	} while (i != (((int128_t)0x7fffff00)<<96));
 	printf("int128_t final value %s\n", buf);
@@ -154,17 +189,66 @@ testu128()
 	i = 0;
 	do {
 		utoa128(buf, i);
+		check_utoa128(i);
 		n = strlen(buf);
 		assert(n > 0 && n <= 40);
 		assert(!i || buf[0] != '0');
 		uint128_t j;
-		assert(atou128(buf, &j) == n);
+		int neg;
+		assert(aton_u128(buf, &neg, &j) == ATON_OK);
+		assert(!neg);
 		assert(i == j);
 		i += (((uint128_t)0x00000100)<<96);
 	} while (i);
 	printf("uint128_t final value %s\n", buf);
 }
 
+void
+testboundaries()
+{
+	uint128_t p = 1;
+	uint64_t r = 0x9e3779b97f4a7c15ULL;
+	unsigned int k;
+	char buf[48], ref[48];
+
+	/* every power of 10 and of 2, and their neighbours */
+	for (k = 0; k < 39; ++k, p *= 10) {
+		check_utoa128(p - 1);
+		check_utoa128(p);
+		check_utoa128(p + 1);
+		if (p <= UINT64_MAX) {
+			utoa64(buf, p); ref_utoa64(ref, p); assert(!strcmp(buf, ref));
+			utoa64(buf, p - 1); ref_utoa64(ref, p - 1); assert(!strcmp(buf, ref));
+		}
+	}
+	for (k = 0; k < 128; ++k) {
+		check_utoa128((((uint128_t)1)<<k) - 1);
+		check_utoa128(((uint128_t)1)<<k);
+		check_utoa128((((uint128_t)1)<<k) + 1);
+	}
+	/* multiples of 10^19 exercise the chunk boundaries */
+	p = (uint128_t)10000000000000000000ULL;
+	for (k = 0; k < 1000; ++k) {
+		check_utoa128(p * k);
+		check_utoa128(p * k - 1);
+		check_utoa128(p * p * (k % 4) + k);
+		check_utoa128(p * p * (k % 4) - k);
+	}
+	/* random full-width values */
+	for (k = 0; k < 10000000; ++k) {
+		uint128_t v;
+		r ^= r >> 12; r ^= r << 25; r ^= r >> 27;
+		v = (uint128_t)(r * 0x2545f4914f6cdd1dULL) << 64;
+		r ^= r >> 12; r ^= r << 25; r ^= r >> 27;
+		v |= r * 0x2545f4914f6cdd1dULL;
+		check_utoa128(v >> (k % 128));
+		utoa64(buf, v >> (k % 64));
+		ref_utoa64(ref, v >> (k % 64));
+		assert(!strcmp(buf, ref));
+	}
+	puts("boundary tests passed");
+}
+
 int
 main()
 {
@@ -174,6 +258,7 @@ main()
 	testu64();
 	testi128();
 	testu128();
+	testboundaries();
 	puts("all tests passed");
 	return 0;
 }
@@ -0,0 +1,300 @@
+#include <postgres.h>
+#include <fmgr.h>
+
+#include <math.h>
+
+#if PG_VERSION_NUM >= 120000
+#include <access/stratnum.h>
+#include <catalog/pg_type.h>
+#include <nodes/makefuncs.h>
+#include <nodes/nodeFuncs.h>
+#include <nodes/supportnodes.h>
+#include <utils/lsyscache.h>
+#include <utils/typcache.h>
+#endif
+
+#include "uint.h"
+#include "unumeric.h"
+
+/*
+ * Comparisons of the integer types against numeric and float8 that work
+ * on the integer and the other value's integer part directly, instead of
+ * converting the integer to numeric or rounding it to float8.
+ */
+
+/* as numeric_split(); float8 NaN sorts above everything, like numeric NaN */
+static numeric_split_result
+float8_split_(float8 d, bool *neg, __uint128_t *ipart, bool *frac)
+{
+	float8		t;
+
+	if (unlikely(isnan(d)))
+		return NUMERIC_SPLIT_NAN;
+	*neg = d < 0;
+	d = fabs(d);
+	if (unlikely(d >= 0x1p128))
+		return NUMERIC_SPLIT_HUGE;
+	t = floor(d);
+	*ipart = (__uint128_t) t;
+	*frac = d != t;
+	if (!*ipart && !*frac)
+		*neg = false;
+	return NUMERIC_SPLIT_OK;
+}
+
+/* sign of the integer (ineg, imag) minus the split value */
+static inline int
+split_cmp_(bool ineg, __uint128_t imag, numeric_split_result r,
+		   bool neg, __uint128_t ipart, bool frac)
+{
+	int			c;
+
+	if (unlikely(r == NUMERIC_SPLIT_NAN))
+		return -1;
+	if (unlikely(r == NUMERIC_SPLIT_HUGE))
+		return neg ? 1 : -1;
+	if (ineg != neg)
+		return ineg ? -1 : 1;
+	c = imag < ipart ? -1 : imag > ipart ? 1 : frac ? -1 : 0;
+	return ineg ? -c : c;
+}
+
+int
+uint128_numeric_cmp(__uint128_t u, Numeric n)
+{
+	bool		neg = false,
+				frac = false;
+	__uint128_t ipart = 0;
+	numeric_split_result r = numeric_split(n, &neg, &ipart, &frac);
+
+	return split_cmp_(false, u, r, neg, ipart, frac);
+}
+
+int
+int128_numeric_cmp(__int128_t i, Numeric n)
+{
+	bool		neg = false,
+				frac = false;
+	__uint128_t ipart = 0;
+	numeric_split_result r = numeric_split(n, &neg, &ipart, &frac);
+
+	return split_cmp_(i < 0, i < 0 ? -(__uint128_t) i : (__uint128_t) i,
+					  r, neg, ipart, frac);
+}
+
+int
+uint128_float8_cmp(__uint128_t u, float8 d)
+{
+	bool		neg = false,
+				frac = false;
+	__uint128_t ipart = 0;
+	numeric_split_result r = float8_split_(d, &neg, &ipart, &frac);
+
+	return split_cmp_(false, u, r, neg, ipart, frac);
+}
+
+int
+int128_float8_cmp(__int128_t i, float8 d)
+{
+	bool		neg = false,
+				frac = false;
+	__uint128_t ipart = 0;
+	numeric_split_result r = float8_split_(d, &neg, &ipart, &frac);
+
+	return split_cmp_(i < 0, i < 0 ? -(__uint128_t) i : (__uint128_t) i,
+					  r, neg, ipart, frac);
+}
+
+#if PG_VERSION_NUM >= 120000
+
+/*
+ * Planner support for the cross-type comparisons: "x op c" with a constant
+ * numeric or float8 c becomes "x op' k" with an integer k of x's type, so
+ * that the plain integer operator, its index support and its statistics
+ * apply.  x < 1.5 is x <= 1, x > -0.5 is x >= 0, x = 3.0 is x = 3.
+ * Equality with a fraction, NaN and bounds outside x's range are left
+ * alone; the cross-type operator handles those at run time.
+ */
+
+typedef enum
+{
+	CMP_LT,
+	CMP_LE,
+	CMP_EQ,
+	CMP_NE,
+	CMP_GE,
+	CMP_GT
+} uint_cmp_op;
+
+static const uint_cmp_op cmp_commutators[] = {CMP_GT, CMP_GE, CMP_EQ, CMP_NE, CMP_LE, CMP_LT};
+
+static const StrategyNumber cmp_strategies[] = {
+	BTLessStrategyNumber, BTLessEqualStrategyNumber, BTEqualStrategyNumber,
+	InvalidStrategy, BTGreaterEqualStrategyNumber, BTGreaterStrategyNumber
+};
+
+static Datum
+uint_make_datum_(bool neg, __uint128_t mag, bool issigned, int bits)
+{
+	__uint128_t v = neg ? -mag : mag;
+
+	switch (bits)
+	{
+		case 8:
+			return issigned ? Int8GetDatum((int8) v) : UInt8GetDatum((uint8) v);
+		case 16:
+			return issigned ? Int16GetDatum((int16) v) : UInt16GetDatum((uint16) v);
+		case 32:
+			return issigned ? Int32GetDatum((int32) v) : UInt32GetDatum((uint32) v);
+		case 64:
+			return issigned ? Int64GetDatum((int64) v) : UInt64GetDatum((uint64) v);
+	}
+	if (issigned)
+	{
+		xint128    *p = (xint128 *) palloc(sizeof(xint128));
+
+		p->i = (__int128_t) v;
+		return PointerGetDatum(p);
+	}
+	else
+	{
+		xuint128   *p = (xuint128 *) palloc(sizeof(xuint128));
+
+		p->i = v;
+		return PointerGetDatum(p);
+	}
+}
+
+static Datum
+uint_cmp_support(FunctionCallInfo fcinfo, uint_cmp_op op, bool issigned, int bits)
+{
+	Node	   *rawreq = (Node *) PG_GETARG_POINTER(0);
+	FuncExpr   *fcall;
+	Node	   *intarg,
+			   *other;
+	Const	   *c;
+	Oid			inttype,
+				opno;
+	TypeCacheEntry *typcache;
+	int16		typlen;
+	bool		typbyval;
+	bool		neg = false,
+				frac = false,
+				away;
+	__uint128_t ipart = 0;
+	numeric_split_result r;
+	Expr	   *result;
+
+	if (!IsA(rawreq, SupportRequestSimplify))
+		PG_RETURN_POINTER(NULL);
+	fcall = ((SupportRequestSimplify *) rawreq)->fcall;
+	if (list_length(fcall->args) != 2)
+		PG_RETURN_POINTER(NULL);
+
+	/* normalize to integer op constant */
+	intarg = linitial(fcall->args);
+	other = lsecond(fcall->args);
+	if (exprType(intarg) == NUMERICOID || exprType(intarg) == FLOAT8OID)
+	{
+		Node	   *tmp = intarg;
+
+		intarg = other;
+		other = tmp;
+		op = cmp_commutators[op];
+	}
+	if (!IsA(other, Const) || ((Const *) other)->constisnull)
+		PG_RETURN_POINTER(NULL);
+	c = (Const *) other;
+	inttype = exprType(intarg);
+
+	if (c->consttype == NUMERICOID)
+		r = numeric_split(DatumGetNumeric(c->constvalue), &neg, &ipart, &frac);
+	else if (c->consttype == FLOAT8OID)
+		r = float8_split_(DatumGetFloat8(c->constvalue), &neg, &ipart, &frac);
+	else
+		PG_RETURN_POINTER(NULL);
+	if (r != NUMERIC_SPLIT_OK)
+		PG_RETURN_POINTER(NULL);
+
+	/* round the constant to the integer bound, away from zero if needed */
+	switch (op)
+	{
+		case CMP_LT:
+			if (frac)
+				op = CMP_LE;
+			away = neg;			/* floor */
+			break;
+		case CMP_LE:
+			away = neg;
+			break;
+		case CMP_GT:
+			if (frac)
+				op = CMP_GE;
+			away = !neg;		/* ceiling */
+			break;
+		case CMP_GE:
+			away = !neg;
+			break;
+		default:
+			if (frac)
+				PG_RETURN_POINTER(NULL);
+			away = false;
+			break;
+	}
+	if (frac && away && __builtin_add_overflow(ipart, (__uint128_t) 1, &ipart))
+		PG_RETURN_POINTER(NULL);
+	if (!ipart)
+		neg = false;
+
+	if (issigned ? ipart > (((__uint128_t) 1) << (bits - 1)) - !neg
+		: (neg || (bits < 128 && ipart >> bits)))
+		PG_RETURN_POINTER(NULL);
+
+	typcache = lookup_type_cache(inttype, TYPECACHE_BTREE_OPFAMILY);
+	if (!OidIsValid(typcache->btree_opf))
+		PG_RETURN_POINTER(NULL);
+	if (op == CMP_NE)
+	{
+		opno = get_opfamily_member(typcache->btree_opf, inttype, inttype,
+								   BTEqualStrategyNumber);
+		opno = OidIsValid(opno) ? get_negator(opno) : InvalidOid;
+	}
+	else
+		opno = get_opfamily_member(typcache->btree_opf, inttype, inttype,
+								   cmp_strategies[op]);
+	if (!OidIsValid(opno))
+		PG_RETURN_POINTER(NULL);
+
+	get_typlenbyval(inttype, &typlen, &typbyval);
+	result = make_opclause(opno, BOOLOID, false, (Expr *) intarg,
+						   (Expr *) makeConst(inttype, -1, InvalidOid, typlen,
+											  uint_make_datum_(neg, ipart, issigned, bits),
+											  false, typbyval),
+						   InvalidOid, InvalidOid);
+	((OpExpr *) result)->opfuncid = get_opcode(opno);
+	PG_RETURN_POINTER(result);
+}
+
+#define cmp_support_op(type, opname, op, issigned, bits) \
+PG_FUNCTION_INFO_V1(type##_##opname##_support); \
+Datum type##_##opname##_support(PG_FUNCTION_ARGS) { \
+	return uint_cmp_support(fcinfo, op, issigned, bits); \
+}
+
+#define cmp_support(type, issigned, bits) \
+cmp_support_op(type, lt, CMP_LT, issigned, bits) \
+cmp_support_op(type, le, CMP_LE, issigned, bits) \
+cmp_support_op(type, eq, CMP_EQ, issigned, bits) \
+cmp_support_op(type, ne, CMP_NE, issigned, bits) \
+cmp_support_op(type, ge, CMP_GE, issigned, bits) \
+cmp_support_op(type, gt, CMP_GT, issigned, bits)
+
+cmp_support(int1, true, 8)
+cmp_support(uint1, false, 8)
+cmp_support(uint2, false, 16)
+cmp_support(uint4, false, 32)
+cmp_support(uint8, false, 64)
+cmp_support(int16, true, 128)
+cmp_support(uint16, false, 128)
+
+#endif
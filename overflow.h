@@ -0,0 +1,33 @@
+/*
+ * Overflow-checked multiplication with a signed 128-bit result
+ * - __builtin_mul_overflow() with __int128 operands and result becomes
+ *   llvm.smul.with.overflow.i128 in clang, which LLVM releases before 14
+ *   lower to a call to __muloti4; that is in compiler-rt but not in
+ *   libgcc, so the JIT could not resolve it in the bitcode of inlined
+ *   operators
+ * - clang therefore multiplies the magnitudes with the unsigned builtin,
+ *   which every LLVM expands inline, and checks the sign separately
+ * - gcc expands the signed builtin inline, and faster, so it keeps it
+ */
+
+static inline int
+int128_mul_overflow_generic(__int128_t a, __int128_t b, __int128_t *result)
+{
+	__uint128_t ua = a < 0 ? -(__uint128_t) a : (__uint128_t) a;
+	__uint128_t ub = b < 0 ? -(__uint128_t) b : (__uint128_t) b;
+	int			negative = (a < 0) != (b < 0);
+	__uint128_t product;
+
+	/* a negative result may be one further from zero than a positive one */
+	if (__builtin_mul_overflow(ua, ub, &product) ||
+		product > ((__uint128_t) 1 << 127) - !negative)
+		return 1;
+	*result = (__int128_t) (negative ? -product : product);
+	return 0;
+}
+
+#ifdef __clang__
+#define int128_mul_overflow(a, b, result) int128_mul_overflow_generic(a, b, result)
+#else
+#define int128_mul_overflow(a, b, result) __builtin_mul_overflow(a, b, result)
+#endif
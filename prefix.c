@@ -0,0 +1,607 @@
+#include <postgres.h>
+#include <fmgr.h>
+#include <access/spgist.h>
+#include <libpq/pqformat.h>
+
+#include "uint.h"
+#include "ntoa.h"
+#include "aton.h"
+
+/*
+ * Prefix types uint4prefix and uint16prefix: a value and a prefix length,
+ * written 'value/len', denoting the block of integers that share the
+ * top len bits of value.  As with cidr, bits to the right of the prefix
+ * must be zero.
+ *
+ * Internally a prefix is left-aligned in 128 bits, so that one set of
+ * helpers and one SP-GiST implementation serves both widths.
+ *
+ * The SP-GiST opclass is a radix tree in the manner of core's
+ * network_spgist.c: each inner tuple carries the common prefix (v, L) of
+ * everything below it and three nodes.  Node 0 holds the prefix itself,
+ * nodes 1 and 2 hold longer prefixes whose bit L is 0 or 1.
+ */
+
+#define PrefixOverlapStrategyNumber			3	/* && */
+#define PrefixEqualStrategyNumber			18	/* = */
+#define PrefixSubStrategyNumber				24	/* << */
+#define PrefixSubEqualStrategyNumber		25	/* <<= */
+#define PrefixSuperStrategyNumber			26	/* >> */
+#define PrefixSuperEqualStrategyNumber		27	/* >>= */
+#define PrefixSuperEqualAddrStrategyNumber	28	/* >>= address */
+
+typedef struct
+{
+	__uint128_t	v;				/* left-aligned, host bits zero */
+	int			len;
+} uint_prefix;
+
+/* on-disk forms, byte aligned */
+#pragma pack(push, 1)
+typedef struct
+{
+	uint32		value;
+	uint8		len;
+} xuint4prefix;
+typedef struct
+{
+	__uint128_t	value;
+	uint8		len;
+} xuint16prefix;
+#pragma pack(pop)
+
+typedef struct
+{
+	const char *name;
+	int			bits;
+	void		(*f_unpack) (Datum, uint_prefix *);
+	Datum		(*f_pack) (const uint_prefix *);
+	__uint128_t	(*f_addr) (Datum);		/* address, left-aligned */
+	Datum		(*f_addrdatum) (__uint128_t);
+} uint_prefix_info;
+
+static inline __uint128_t
+prefix_mask(int len)
+{
+	return len == 0 ? 0 : ~(__uint128_t) 0 << (128 - len);
+}
+
+/* a >>= b */
+static inline bool
+prefix_contains(const uint_prefix *a, const uint_prefix *b)
+{
+	return a->len <= b->len && ((a->v ^ b->v) & prefix_mask(a->len)) == 0;
+}
+
+/* number of leading bits a and b have in common, at most maxlen */
+static int
+prefix_common(__uint128_t a, __uint128_t b, int maxlen)
+{
+	__uint128_t	x = a ^ b;
+	uint64		hi = (uint64) (x >> 64);
+	int			n;
+
+	if (x == 0)
+		return maxlen;
+	n = hi ? __builtin_clzll(hi) : 64 + __builtin_clzll((uint64) x);
+	return Min(n, maxlen);
+}
+
+/* node of an inner tuple with prefix length L that p belongs to */
+static inline int
+prefix_node(const uint_prefix *p, int L)
+{
+	if (p->len == L)
+		return 0;
+	return 1 + (int) ((p->v >> (127 - L)) & 1);
+}
+
+static bool
+prefix_match(const uint_prefix *x, const uint_prefix *q, StrategyNumber strategy)
+{
+	switch (strategy)
+	{
+		case PrefixOverlapStrategyNumber:
+			return prefix_contains(x, q) || prefix_contains(q, x);
+		case PrefixEqualStrategyNumber:
+			return x->len == q->len && x->v == q->v;
+		case PrefixSubStrategyNumber:
+			return x->len > q->len && prefix_contains(q, x);
+		case PrefixSubEqualStrategyNumber:
+			return prefix_contains(q, x);
+		case PrefixSuperStrategyNumber:
+			return x->len < q->len && prefix_contains(x, q);
+		case PrefixSuperEqualStrategyNumber:
+		case PrefixSuperEqualAddrStrategyNumber:
+			return prefix_contains(x, q);
+		default:
+			elog(ERROR, "unrecognized strategy number: %d", strategy);
+			return false;
+	}
+}
+
+static Datum
+uint_prefix_in(FunctionCallInfo fcinfo, const uint_prefix_info *tinfo)
+{
+	const char *s = PG_GETARG_CSTRING(0);
+	const char *slash = strchr(s, '/');
+	char		buf[64];
+	__uint128_t	value;
+	uint64		len = tinfo->bits;
+	int			neg = 0;
+	int			status;
+	uint_prefix	p;
+
+	if (slash)
+	{
+		if (slash - s >= sizeof(buf))
+			status = ATON_RANGE;
+		else
+		{
+			memcpy(buf, s, slash - s);
+			buf[slash - s] = '\0';
+			status = aton_u128(buf, &neg, &value);
+		}
+		if (status == ATON_OK && !neg)
+		{
+			status = aton_u64(slash + 1, &neg, &len);
+			if (status == ATON_OK && (neg || len > tinfo->bits))
+				status = ATON_SYNTAX;
+		}
+	}
+	else
+		status = aton_u128(s, &neg, &value);
+
+	if (status == ATON_OK && tinfo->bits < 128 && (value >> tinfo->bits) != 0)
+		status = ATON_RANGE;
+	if (neg)
+		status = ATON_SYNTAX;
+	if (status == ATON_RANGE)
+		ereport(ERROR,
+				(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+				 errmsg("value \"%s\" is out of range for type %s", s, tinfo->name)));
+	if (status != ATON_OK)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_TEXT_REPRESENTATION),
+				 errmsg("invalid input syntax for type %s: \"%s\"", tinfo->name, s)));
+
+	p.v = value << (128 - tinfo->bits);
+	p.len = (int) len;
+	if (p.v & ~prefix_mask(p.len))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_TEXT_REPRESENTATION),
+				 errmsg("invalid %s value: \"%s\"", tinfo->name, s),
+				 errdetail("Value has bits set to right of mask.")));
+
+	return tinfo->f_pack(&p);
+}
+
+static Datum
+uint_prefix_out(FunctionCallInfo fcinfo, const uint_prefix_info *tinfo)
+{
+	uint_prefix	p;
+	char	   *result = palloc(44);	/* 39 digits, '/', 3 digits, '\0' */
+	char	   *end;
+
+	tinfo->f_unpack(PG_GETARG_DATUM(0), &p);
+	utoa128(result, p.v >> (128 - tinfo->bits));
+	end = result + strlen(result);
+	*end++ = '/';
+	utoa32(end, p.len);
+	PG_RETURN_CSTRING(result);
+}
+
+/* network byte order value, then the length byte */
+static Datum
+uint_prefix_recv(FunctionCallInfo fcinfo, const uint_prefix_info *tinfo)
+{
+	StringInfo	buf = (StringInfo) PG_GETARG_POINTER(0);
+	uint_prefix	p;
+	int			i;
+
+	p.v = 0;
+	for (i = 0; i < tinfo->bits / 8; i++)
+		p.v |= (__uint128_t) (uint8) pq_getmsgbyte(buf) << (120 - 8 * i);
+	p.len = (uint8) pq_getmsgbyte(buf);
+	if (p.len > tinfo->bits)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+				 errmsg("invalid prefix length in external \"%s\" value", tinfo->name)));
+	if (p.v & ~prefix_mask(p.len))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+				 errmsg("invalid external \"%s\" value", tinfo->name),
+				 errdetail("Value has bits set to right of mask.")));
+
+	return tinfo->f_pack(&p);
+}
+
+static Datum
+uint_prefix_send(FunctionCallInfo fcinfo, const uint_prefix_info *tinfo)
+{
+	StringInfoData buf;
+	uint_prefix	p;
+	int			i;
+
+	tinfo->f_unpack(PG_GETARG_DATUM(0), &p);
+	pq_begintypsend(&buf);
+	for (i = 0; i < tinfo->bits / 8; i++)
+		pq_sendbyte(&buf, (uint8) (p.v >> (120 - 8 * i)));
+	pq_sendbyte(&buf, (uint8) p.len);
+	PG_RETURN_BYTEA_P(pq_endtypsend(&buf));
+}
+
+/* prefix(value, len): like set_masklen(cidr, int), host bits are cleared */
+static Datum
+uint_prefix_make(FunctionCallInfo fcinfo, const uint_prefix_info *tinfo)
+{
+	int32		len = PG_GETARG_INT32(1);
+	uint_prefix	p;
+
+	if (len < 0 || len > tinfo->bits)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid prefix length: %d", len)));
+	p.len = len;
+	p.v = tinfo->f_addr(PG_GETARG_DATUM(0)) & prefix_mask(len);
+	return tinfo->f_pack(&p);
+}
+
+static Datum
+uint_prefix_bound(FunctionCallInfo fcinfo, const uint_prefix_info *tinfo, bool upper)
+{
+	uint_prefix	p;
+
+	tinfo->f_unpack(PG_GETARG_DATUM(0), &p);
+	if (upper)
+		p.v |= ~prefix_mask(p.len) & prefix_mask(tinfo->bits);
+	return tinfo->f_addrdatum(p.v);
+}
+
+static Datum
+uint_prefix_masklen(FunctionCallInfo fcinfo, const uint_prefix_info *tinfo)
+{
+	uint_prefix	p;
+
+	tinfo->f_unpack(PG_GETARG_DATUM(0), &p);
+	PG_RETURN_INT32(p.len);
+}
+
+static Datum
+uint_prefix_op(FunctionCallInfo fcinfo, const uint_prefix_info *tinfo, StrategyNumber strategy)
+{
+	uint_prefix	a,
+				b;
+
+	tinfo->f_unpack(PG_GETARG_DATUM(0), &a);
+	tinfo->f_unpack(PG_GETARG_DATUM(1), &b);
+	PG_RETURN_BOOL(prefix_match(&a, &b, strategy));
+}
+
+/* prefix >>= address, and address <<= prefix when commuted */
+static Datum
+uint_prefix_supeq_addr(FunctionCallInfo fcinfo, const uint_prefix_info *tinfo, int argp, int arga)
+{
+	uint_prefix	p,
+				a;
+
+	tinfo->f_unpack(PG_GETARG_DATUM(argp), &p);
+	a.v = tinfo->f_addr(PG_GETARG_DATUM(arga));
+	a.len = tinfo->bits;
+	PG_RETURN_BOOL(prefix_contains(&p, &a));
+}
+
+/*
+ * SP-GiST support
+ */
+
+PG_FUNCTION_INFO_V1(spg_uint_prefix_config);
+Datum
+spg_uint_prefix_config(PG_FUNCTION_ARGS)
+{
+	spgConfigIn *cfgin = (spgConfigIn *) PG_GETARG_POINTER(0);
+	spgConfigOut *cfg = (spgConfigOut *) PG_GETARG_POINTER(1);
+
+	cfg->prefixType = cfgin->attType;
+	cfg->labelType = VOIDOID;
+#if PG_VERSION_NUM >= 140000
+	cfg->leafType = cfgin->attType;
+#endif
+	cfg->canReturnData = true;
+	cfg->longValuesOK = false;
+
+	PG_RETURN_VOID();
+}
+
+static Datum
+uint_prefix_spg_choose(FunctionCallInfo fcinfo, const uint_prefix_info *tinfo)
+{
+	spgChooseIn *in = (spgChooseIn *) PG_GETARG_POINTER(0);
+	spgChooseOut *out = (spgChooseOut *) PG_GETARG_POINTER(1);
+	uint_prefix	val,
+				prefix;
+	int			common;
+
+	tinfo->f_unpack(in->datum, &val);
+	tinfo->f_unpack(in->prefixDatum, &prefix);
+
+	if (prefix_contains(&prefix, &val))
+	{
+		out->resultType = spgMatchNode;
+		/* in an allTheSame tuple the core code picks the node itself */
+		out->result.matchNode.nodeN = in->allTheSame ? 0 : prefix_node(&val, prefix.len);
+		out->result.matchNode.levelAdd = 0;
+		out->result.matchNode.restDatum = in->datum;
+	}
+	else
+	{
+		/*
+		 * The value is not under the prefix, so push the tuple down below a
+		 * new one holding the prefix both have in common.
+		 */
+		uint_prefix	upper;
+
+		common = prefix_common(val.v, prefix.v, Min(val.len, prefix.len));
+		Assert(common < prefix.len);
+		upper.v = prefix.v & prefix_mask(common);
+		upper.len = common;
+
+		out->resultType = spgSplitTuple;
+		out->result.splitTuple.prefixHasPrefix = true;
+		out->result.splitTuple.prefixPrefixDatum = tinfo->f_pack(&upper);
+		out->result.splitTuple.prefixNNodes = 3;
+		out->result.splitTuple.prefixNodeLabels = NULL;
+		out->result.splitTuple.childNodeN = prefix_node(&prefix, common);
+		out->result.splitTuple.postfixHasPrefix = true;
+		out->result.splitTuple.postfixPrefixDatum = in->prefixDatum;
+	}
+
+	PG_RETURN_VOID();
+}
+
+static Datum
+uint_prefix_spg_picksplit(FunctionCallInfo fcinfo, const uint_prefix_info *tinfo)
+{
+	spgPickSplitIn *in = (spgPickSplitIn *) PG_GETARG_POINTER(0);
+	spgPickSplitOut *out = (spgPickSplitOut *) PG_GETARG_POINTER(1);
+	uint_prefix *vals = (uint_prefix *) palloc(sizeof(uint_prefix) * in->nTuples);
+	uint_prefix	prefix;
+	int			i;
+
+	Assert(in->nTuples > 1);
+
+	/* the common prefix of all the values */
+	tinfo->f_unpack(in->datums[0], &vals[0]);
+	prefix = vals[0];
+	for (i = 1; i < in->nTuples; i++)
+	{
+		tinfo->f_unpack(in->datums[i], &vals[i]);
+		prefix.len = prefix_common(prefix.v, vals[i].v, Min(prefix.len, vals[i].len));
+	}
+	prefix.v &= prefix_mask(prefix.len);
+
+	out->hasPrefix = true;
+	out->prefixDatum = tinfo->f_pack(&prefix);
+	out->nNodes = 3;
+	out->nodeLabels = NULL;
+	out->mapTuplesToNodes = palloc(sizeof(int) * in->nTuples);
+	out->leafTupleDatums = palloc(sizeof(Datum) * in->nTuples);
+
+	for (i = 0; i < in->nTuples; i++)
+	{
+		out->mapTuplesToNodes[i] = prefix_node(&vals[i], prefix.len);
+		out->leafTupleDatums[i] = in->datums[i];
+	}
+
+	PG_RETURN_VOID();
+}
+
+static void
+uint_prefix_query(ScanKey key, const uint_prefix_info *tinfo, uint_prefix *q)
+{
+	if (key->sk_strategy == PrefixSuperEqualAddrStrategyNumber)
+	{
+		q->v = tinfo->f_addr(key->sk_argument);
+		q->len = tinfo->bits;
+	}
+	else
+		tinfo->f_unpack(key->sk_argument, q);
+}
+
+/*
+ * Bitmap of the nodes below an inner tuple with prefix p that can hold
+ * values matching the query q.
+ */
+static int
+prefix_inner_nodes(const uint_prefix *p, const uint_prefix *q, StrategyNumber strategy)
+{
+	int			L = p->len;
+	int			qnode = q->len > L ? 1 << prefix_node(q, L) : 0;
+
+	if ((p->v ^ q->v) & prefix_mask(Min(q->len, L)))
+		return 0;
+
+	switch (strategy)
+	{
+		case PrefixOverlapStrategyNumber:
+			return q->len <= L ? 7 : 1 | qnode;
+		case PrefixEqualStrategyNumber:
+			return q->len < L ? 0 : q->len == L ? 1 : qnode;
+		case PrefixSubStrategyNumber:
+			return q->len < L ? 7 : q->len == L ? 6 : qnode;
+		case PrefixSubEqualStrategyNumber:
+			return q->len <= L ? 7 : qnode;
+		case PrefixSuperStrategyNumber:
+			return q->len <= L ? 0 : 1 | qnode;
+		case PrefixSuperEqualStrategyNumber:
+		case PrefixSuperEqualAddrStrategyNumber:
+			return q->len < L ? 0 : q->len == L ? 1 : 1 | qnode;
+		default:
+			elog(ERROR, "unrecognized strategy number: %d", strategy);
+			return 0;
+	}
+}
+
+static Datum
+uint_prefix_spg_inner_consistent(FunctionCallInfo fcinfo, const uint_prefix_info *tinfo)
+{
+	spgInnerConsistentIn *in = (spgInnerConsistentIn *) PG_GETARG_POINTER(0);
+	spgInnerConsistentOut *out = (spgInnerConsistentOut *) PG_GETARG_POINTER(1);
+	uint_prefix	prefix,
+				q;
+	int			which = 7;
+	int			i;
+
+	Assert(in->hasPrefix);
+	tinfo->f_unpack(in->prefixDatum, &prefix);
+
+	for (i = 0; i < in->nkeys && which; i++)
+	{
+		uint_prefix_query(&in->scankeys[i], tinfo, &q);
+		which &= prefix_inner_nodes(&prefix, &q, in->scankeys[i].sk_strategy);
+	}
+
+	out->nNodes = 0;
+	if (which)
+	{
+		out->nodeNumbers = (int *) palloc(sizeof(int) * in->nNodes);
+		for (i = 0; i < in->nNodes; i++)
+		{
+			/* the nodes of an allTheSame tuple do not follow the bits */
+			if (in->allTheSame || (which & (1 << i)))
+				out->nodeNumbers[out->nNodes++] = i;
+		}
+	}
+
+	PG_RETURN_VOID();
+}
+
+static Datum
+uint_prefix_spg_leaf_consistent(FunctionCallInfo fcinfo, const uint_prefix_info *tinfo)
+{
+	spgLeafConsistentIn *in = (spgLeafConsistentIn *) PG_GETARG_POINTER(0);
+	spgLeafConsistentOut *out = (spgLeafConsistentOut *) PG_GETARG_POINTER(1);
+	uint_prefix	val,
+				q;
+	int			i;
+
+	tinfo->f_unpack(in->leafDatum, &val);
+	out->recheck = false;
+	out->leafValue = in->leafDatum;
+
+	for (i = 0; i < in->nkeys; i++)
+	{
+		uint_prefix_query(&in->scankeys[i], tinfo, &q);
+		if (!prefix_match(&val, &q, in->scankeys[i].sk_strategy))
+			PG_RETURN_BOOL(false);
+	}
+
+	PG_RETURN_BOOL(true);
+}
+
+/*
+ * Per-type glue
+ */
+
+static void
+uint4prefix_unpack(Datum d, uint_prefix *p)
+{
+	xuint4prefix *x = (xuint4prefix *) DatumGetPointer(d);
+
+	p->v = (__uint128_t) x->value << 96;
+	p->len = x->len;
+}
+
+static Datum
+uint4prefix_pack(const uint_prefix *p)
+{
+	xuint4prefix *x = (xuint4prefix *) palloc(sizeof(xuint4prefix));
+
+	x->value = (uint32) (p->v >> 96);
+	x->len = p->len;
+	return PointerGetDatum(x);
+}
+
+static __uint128_t
+uint4prefix_addr(Datum d)
+{
+	return (__uint128_t) DatumGetUInt32(d) << 96;
+}
+
+static Datum
+uint4prefix_addrdatum(__uint128_t v)
+{
+	return UInt32GetDatum((uint32) (v >> 96));
+}
+
+static void
+uint16prefix_unpack(Datum d, uint_prefix *p)
+{
+	xuint16prefix *x = (xuint16prefix *) DatumGetPointer(d);
+
+	p->v = x->value;
+	p->len = x->len;
+}
+
+static Datum
+uint16prefix_pack(const uint_prefix *p)
+{
+	xuint16prefix *x = (xuint16prefix *) palloc(sizeof(xuint16prefix));
+
+	x->value = p->v;
+	x->len = p->len;
+	return PointerGetDatum(x);
+}
+
+static __uint128_t
+uint16prefix_addr(Datum d)
+{
+	return ((xuint128 *) DatumGetPointer(d))->i;
+}
+
+static Datum
+uint16prefix_addrdatum(__uint128_t v)
+{
+	xuint128   *result = (xuint128 *) palloc(sizeof(xuint128));
+
+	result->i = v;
+	return PointerGetDatum(result);
+}
+
+#define make_prefix_function(type, name, call) \
+PG_FUNCTION_INFO_V1(type##name); \
+Datum \
+type##name(PG_FUNCTION_ARGS) \
+{ \
+	return call; \
+} \
+extern int no_such_variable
+
+#define make_prefix_type(type, bits) \
+static const uint_prefix_info type##_tinfo = { \
+	#type, bits, type##_unpack, type##_pack, type##_addr, type##_addrdatum \
+}; \
+make_prefix_function(type, in, uint_prefix_in(fcinfo, &type##_tinfo)); \
+make_prefix_function(type, out, uint_prefix_out(fcinfo, &type##_tinfo)); \
+make_prefix_function(type, recv, uint_prefix_recv(fcinfo, &type##_tinfo)); \
+make_prefix_function(type, send, uint_prefix_send(fcinfo, &type##_tinfo)); \
+make_prefix_function(type, _make, uint_prefix_make(fcinfo, &type##_tinfo)); \
+make_prefix_function(type, _lower, uint_prefix_bound(fcinfo, &type##_tinfo, false)); \
+make_prefix_function(type, _upper, uint_prefix_bound(fcinfo, &type##_tinfo, true)); \
+make_prefix_function(type, _masklen, uint_prefix_masklen(fcinfo, &type##_tinfo)); \
+make_prefix_function(type, _eq, uint_prefix_op(fcinfo, &type##_tinfo, PrefixEqualStrategyNumber)); \
+make_prefix_function(type, _ne, BoolGetDatum(!DatumGetBool(uint_prefix_op(fcinfo, &type##_tinfo, PrefixEqualStrategyNumber)))); \
+make_prefix_function(type, _overlap, uint_prefix_op(fcinfo, &type##_tinfo, PrefixOverlapStrategyNumber)); \
+make_prefix_function(type, _sub, uint_prefix_op(fcinfo, &type##_tinfo, PrefixSubStrategyNumber)); \
+make_prefix_function(type, _subeq, uint_prefix_op(fcinfo, &type##_tinfo, PrefixSubEqualStrategyNumber)); \
+make_prefix_function(type, _sup, uint_prefix_op(fcinfo, &type##_tinfo, PrefixSuperStrategyNumber)); \
+make_prefix_function(type, _supeq, uint_prefix_op(fcinfo, &type##_tinfo, PrefixSuperEqualStrategyNumber)); \
+make_prefix_function(type, _supeq_addr, uint_prefix_supeq_addr(fcinfo, &type##_tinfo, 0, 1)); \
+make_prefix_function(type, _addr_subeq, uint_prefix_supeq_addr(fcinfo, &type##_tinfo, 1, 0)); \
+make_prefix_function(type, _spg_choose, uint_prefix_spg_choose(fcinfo, &type##_tinfo)); \
+make_prefix_function(type, _spg_picksplit, uint_prefix_spg_picksplit(fcinfo, &type##_tinfo)); \
+make_prefix_function(type, _spg_inner_consistent, uint_prefix_spg_inner_consistent(fcinfo, &type##_tinfo)); \
+make_prefix_function(type, _spg_leaf_consistent, uint_prefix_spg_leaf_consistent(fcinfo, &type##_tinfo))
+
+make_prefix_type(uint4prefix, 32);
+make_prefix_type(uint16prefix, 128);
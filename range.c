@@ -0,0 +1,145 @@
+#include <postgres.h>
+#include <fmgr.h>
+#include <utils/rangetypes.h>
+
+#include "uint.h"
+
+/*
+ * Canonical and subtype_diff functions for the discrete range types.  As
+ * with int4range, the canonical form is [lower, upper).
+ */
+
+#if PG_VERSION_NUM < 110000
+#define PG_GETARG_RANGE_P(n)	PG_GETARG_RANGE(n)
+#define PG_RETURN_RANGE_P(x)	PG_RETURN_RANGE(x)
+#endif
+
+#if PG_VERSION_NUM >= 160000
+#define range_serialize_(typcache, lower, upper) \
+	range_serialize(typcache, lower, upper, false, fcinfo->context)
+#else
+#define range_serialize_(typcache, lower, upper) \
+	range_serialize(typcache, lower, upper, false)
+#endif
+
+#define range_overflow() \
+	ereport(ERROR, \
+			(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE), \
+			 errmsg("integer out of range")))
+
+static Datum
+int16_succ(Datum d)
+{
+	__int128_t	val = ((xint128 *) DatumGetPointer(d))->i;
+	xint128    *result;
+
+	if (val == (__int128_t) (~(__uint128_t) 0 >> 1))
+		range_overflow();
+	result = (xint128 *) palloc(sizeof(xint128));
+	result->i = val + 1;
+	return PointerGetDatum(result);
+}
+
+static Datum
+uint16_succ(Datum d)
+{
+	__uint128_t	val = ((xuint128 *) DatumGetPointer(d))->i;
+	xuint128   *result;
+
+	if (val == ~(__uint128_t) 0)
+		range_overflow();
+	result = (xuint128 *) palloc(sizeof(xuint128));
+	result->i = val + 1;
+	return PointerGetDatum(result);
+}
+
+static Datum
+uint4_succ(Datum d)
+{
+	uint32		val = DatumGetUInt32(d);
+
+	if (val == PG_UINT32_MAX)
+		range_overflow();
+	return UInt32GetDatum(val + 1);
+}
+
+static Datum
+uint8_succ(Datum d)
+{
+	uint64		val = DatumGetUInt64(d);
+
+	if (val == PG_UINT64_MAX)
+		range_overflow();
+	return UInt64GetDatum(val + 1);
+}
+
+#define make_range_canonical(type) \
+PG_FUNCTION_INFO_V1(type##range_canonical); \
+Datum \
+type##range_canonical(PG_FUNCTION_ARGS) \
+{ \
+	RangeType  *r = PG_GETARG_RANGE_P(0); \
+	TypeCacheEntry *typcache = range_get_typcache(fcinfo, RangeTypeGetOid(r)); \
+	RangeBound	lower; \
+	RangeBound	upper; \
+	bool		empty; \
+\
+	range_deserialize(typcache, r, &lower, &upper, &empty); \
+	if (empty) \
+		PG_RETURN_RANGE_P(r); \
+\
+	if (!lower.infinite && !lower.inclusive) \
+	{ \
+		lower.val = type##_succ(lower.val); \
+		lower.inclusive = true; \
+	} \
+	if (!upper.infinite && upper.inclusive) \
+	{ \
+		upper.val = type##_succ(upper.val); \
+		upper.inclusive = false; \
+	} \
+\
+	PG_RETURN_RANGE_P(range_serialize_(typcache, &lower, &upper)); \
+} \
+extern int no_such_variable
+
+make_range_canonical(uint4);
+make_range_canonical(uint8);
+make_range_canonical(int16);
+make_range_canonical(uint16);
+
+/* subtype_diff: arg1 - arg2 as float8, for GiST penalties */
+
+PG_FUNCTION_INFO_V1(uint4range_subdiff);
+Datum
+uint4range_subdiff(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_FLOAT8((float8) PG_GETARG_UINT32(0) - (float8) PG_GETARG_UINT32(1));
+}
+
+PG_FUNCTION_INFO_V1(uint8range_subdiff);
+Datum
+uint8range_subdiff(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_FLOAT8((float8) PG_GETARG_UINT64(0) - (float8) PG_GETARG_UINT64(1));
+}
+
+PG_FUNCTION_INFO_V1(int16range_subdiff);
+Datum
+int16range_subdiff(PG_FUNCTION_ARGS)
+{
+	xint128    *arg1 = (xint128 *) PG_GETARG_POINTER(0);
+	xint128    *arg2 = (xint128 *) PG_GETARG_POINTER(1);
+
+	PG_RETURN_FLOAT8((float8) arg1->i - (float8) arg2->i);
+}
+
+PG_FUNCTION_INFO_V1(uint16range_subdiff);
+Datum
+uint16range_subdiff(PG_FUNCTION_ARGS)
+{
+	xuint128   *arg1 = (xuint128 *) PG_GETARG_POINTER(0);
+	xuint128   *arg2 = (xuint128 *) PG_GETARG_POINTER(1);
+
+	PG_RETURN_FLOAT8((float8) arg1->i - (float8) arg2->i);
+}
@@ -0,0 +1,346 @@
+#include <postgres.h>
+#include <fmgr.h>
+
+#if PG_VERSION_NUM >= 110000
+
+#include <access/htup_details.h>
+#include <catalog/pg_statistic.h>
+#include <catalog/pg_type.h>
+#include <nodes/primnodes.h>
+#include <utils/builtins.h>
+#include <utils/lsyscache.h>
+#include <utils/selfuncs.h>
+#include <utils/syscache.h>
+
+#include "uint.h"
+
+/*
+ * Restriction estimators for <, <=, > and >= against a constant.
+ *
+ * Core's scalarineqsel() finds the histogram bin holding the constant,
+ * but convert_to_scalar() only knows the built-in types, so for ours it
+ * assumes the constant sits in the middle of its bin.  Here every value
+ * is converted exactly, as a sign and a 128-bit magnitude, and the
+ * position inside the bin is interpolated from the integer differences.
+ * That keeps wide 128-bit bins as precise as narrow ones.
+ *
+ * Anything else (no histogram, a non-constant operand, types we don't
+ * know) is passed on to the core estimator.
+ */
+
+typedef struct
+{
+	bool		neg;
+	__uint128_t	mag;
+} uint_selval;
+
+typedef enum
+{
+	SEL_NONE,
+	SEL_INT2,
+	SEL_INT4,
+	SEL_INT8,
+	SEL_INT1,
+	SEL_UINT1,
+	SEL_UINT2,
+	SEL_UINT4,
+	SEL_UINT8,
+	SEL_INT16,
+	SEL_UINT16
+} uint_selkind;
+
+static uint_selkind
+uint_sel_kind(Oid typid, Oid nsp)
+{
+	HeapTuple	tp;
+	uint_selkind kind = SEL_NONE;
+
+	switch (typid)
+	{
+		case INT2OID:
+			return SEL_INT2;
+		case INT4OID:
+			return SEL_INT4;
+		case INT8OID:
+			return SEL_INT8;
+	}
+
+	tp = SearchSysCache1(TYPEOID, ObjectIdGetDatum(typid));
+	if (HeapTupleIsValid(tp))
+	{
+		Form_pg_type typtup = (Form_pg_type) GETSTRUCT(tp);
+		const char *name = NameStr(typtup->typname);
+
+		/* only the types of this extension */
+		if (typtup->typnamespace == nsp)
+		{
+			if (strcmp(name, "int1") == 0)
+				kind = SEL_INT1;
+			else if (strcmp(name, "uint1") == 0)
+				kind = SEL_UINT1;
+			else if (strcmp(name, "uint2") == 0)
+				kind = SEL_UINT2;
+			else if (strcmp(name, "uint4") == 0)
+				kind = SEL_UINT4;
+			else if (strcmp(name, "uint8") == 0)
+				kind = SEL_UINT8;
+			else if (strcmp(name, "int16") == 0 || strcmp(name, "int16a") == 0)
+				kind = SEL_INT16;
+			else if (strcmp(name, "uint16") == 0 || strcmp(name, "uint16a") == 0)
+				kind = SEL_UINT16;
+		}
+		ReleaseSysCache(tp);
+	}
+	return kind;
+}
+
+static inline void
+uint_selval_signed(__int128_t i, uint_selval *v)
+{
+	v->neg = i < 0;
+	v->mag = i < 0 ? -(__uint128_t) i : (__uint128_t) i;
+}
+
+static void
+uint_selval_from_datum(Datum d, uint_selkind kind, uint_selval *v)
+{
+	switch (kind)
+	{
+		case SEL_INT2:
+			uint_selval_signed(DatumGetInt16(d), v);
+			break;
+		case SEL_INT4:
+			uint_selval_signed(DatumGetInt32(d), v);
+			break;
+		case SEL_INT8:
+			uint_selval_signed(DatumGetInt64(d), v);
+			break;
+		case SEL_INT1:
+			uint_selval_signed(DatumGetInt8(d), v);
+			break;
+		case SEL_INT16:
+			uint_selval_signed(((xint128 *) DatumGetPointer(d))->i, v);
+			break;
+		case SEL_UINT1:
+			v->neg = false;
+			v->mag = DatumGetUInt8(d);
+			break;
+		case SEL_UINT2:
+			v->neg = false;
+			v->mag = DatumGetUInt16(d);
+			break;
+		case SEL_UINT4:
+			v->neg = false;
+			v->mag = DatumGetUInt32(d);
+			break;
+		case SEL_UINT8:
+			v->neg = false;
+			v->mag = DatumGetUInt64(d);
+			break;
+		case SEL_UINT16:
+			v->neg = false;
+			v->mag = ((xuint128 *) DatumGetPointer(d))->i;
+			break;
+		case SEL_NONE:
+			elog(ERROR, "unsupported type in uint selectivity estimation");
+	}
+}
+
+static int
+uint_selval_cmp(const uint_selval *a, const uint_selval *b)
+{
+	if (a->neg != b->neg)
+		return a->neg ? -1 : 1;
+	if (a->mag == b->mag)
+		return 0;
+	return ((a->mag < b->mag) != a->neg) ? -1 : 1;
+}
+
+/* a - b as a double, for a >= b */
+static double
+uint_selval_diff(const uint_selval *a, const uint_selval *b)
+{
+	if (!a->neg && b->neg)
+		return (double) a->mag + (double) b->mag;
+	if (a->neg)
+		return (double) (b->mag - a->mag);
+	return (double) (a->mag - b->mag);
+}
+
+/*
+ * Fraction of the histogram population below c, interpolating linearly
+ * inside the bin.  The bin search compares exactly, the interpolation
+ * uses the differences to the lower bound.
+ */
+static double
+uint_histogram_fraction(const uint_selval *c, const uint_selval *hist, int nvalues)
+{
+	int			lo = 0,
+				hi = nvalues - 1;
+	double		width,
+				binfrac;
+
+	if (uint_selval_cmp(c, &hist[0]) <= 0)
+		return 0.0;
+	if (uint_selval_cmp(c, &hist[nvalues - 1]) >= 0)
+		return 1.0;
+
+	/* hist[lo] < c <= hist[hi] */
+	while (hi - lo > 1)
+	{
+		int			mid = (lo + hi) / 2;
+
+		if (uint_selval_cmp(c, &hist[mid]) <= 0)
+			hi = mid;
+		else
+			lo = mid;
+	}
+
+	width = uint_selval_diff(&hist[hi], &hist[lo]);
+	binfrac = width > 0 ? uint_selval_diff(c, &hist[lo]) / width : 0.5;
+	if (binfrac > 1.0)
+		binfrac = 1.0;
+
+	return (lo + binfrac) / (double) (nvalues - 1);
+}
+
+/* returns -1 if the core estimator should be used instead */
+static double
+uint_scalarineqsel_(FunctionCallInfo fcinfo, bool isgt, bool iseq)
+{
+	PlannerInfo *root = (PlannerInfo *) PG_GETARG_POINTER(0);
+	List	   *args = (List *) PG_GETARG_POINTER(2);
+	int			varRelid = PG_GETARG_INT32(3);
+	Oid			nsp = get_func_namespace(fcinfo->flinfo->fn_oid);
+	VariableStatData vardata;
+	Node	   *other;
+	bool		varonleft;
+	Const	   *cnst;
+	uint_selkind varkind,
+				constkind;
+	uint_selval c;
+	uint_selval *hist;
+	AttStatsSlot sslot;
+	Form_pg_statistic stats;
+	double		selec,
+				mcv_selec = 0.0,
+				sumcommon = 0.0,
+				hist_selec;
+	int			i;
+
+	if (!get_restriction_variable(root, args, varRelid, &vardata, &other, &varonleft))
+		return -1.0;
+	if (!IsA(other, Const) || !HeapTupleIsValid(vardata.statsTuple))
+	{
+		ReleaseVariableStats(vardata);
+		return -1.0;
+	}
+	cnst = (Const *) other;
+	if (cnst->constisnull)
+	{
+		ReleaseVariableStats(vardata);
+		return 0.0;
+	}
+
+	varkind = uint_sel_kind(vardata.atttype, nsp);
+	constkind = uint_sel_kind(cnst->consttype, nsp);
+	if (varkind == SEL_NONE || constkind == SEL_NONE ||
+		!get_attstatsslot(&sslot, vardata.statsTuple, STATISTIC_KIND_HISTOGRAM,
+						  InvalidOid, ATTSTATSSLOT_VALUES))
+	{
+		ReleaseVariableStats(vardata);
+		return -1.0;
+	}
+	if (sslot.nvalues < 2)
+	{
+		free_attstatsslot(&sslot);
+		ReleaseVariableStats(vardata);
+		return -1.0;
+	}
+
+	/* const OP var is var (commuted OP) const */
+	if (!varonleft)
+		isgt = !isgt;
+	uint_selval_from_datum(cnst->constvalue, constkind, &c);
+
+	hist = (uint_selval *) palloc(sizeof(uint_selval) * sslot.nvalues);
+	for (i = 0; i < sslot.nvalues; i++)
+		uint_selval_from_datum(sslot.values[i], varkind, &hist[i]);
+	hist_selec = uint_histogram_fraction(&c, hist, sslot.nvalues);
+	if (isgt)
+		hist_selec = 1.0 - hist_selec;
+	pfree(hist);
+	free_attstatsslot(&sslot);
+
+	/* don't believe extreme estimates, the stats may be stale */
+	if (hist_selec < 0.0001)
+		hist_selec = 0.0001;
+	else if (hist_selec > 0.9999)
+		hist_selec = 0.9999;
+
+	if (get_attstatsslot(&sslot, vardata.statsTuple, STATISTIC_KIND_MCV,
+						 InvalidOid, ATTSTATSSLOT_VALUES | ATTSTATSSLOT_NUMBERS))
+	{
+		for (i = 0; i < sslot.nvalues; i++)
+		{
+			uint_selval v;
+			int			cmp;
+
+			uint_selval_from_datum(sslot.values[i], varkind, &v);
+			cmp = uint_selval_cmp(&v, &c);
+			if ((isgt ? cmp > 0 : cmp < 0) || (iseq && cmp == 0))
+				mcv_selec += sslot.numbers[i];
+			sumcommon += sslot.numbers[i];
+		}
+		free_attstatsslot(&sslot);
+	}
+
+	stats = (Form_pg_statistic) GETSTRUCT(vardata.statsTuple);
+	selec = (1.0 - stats->stanullfrac - sumcommon) * hist_selec + mcv_selec;
+	ReleaseVariableStats(vardata);
+
+	CLAMP_PROBABILITY(selec);
+	return selec;
+}
+
+static Datum
+uint_scalarineqsel(FunctionCallInfo fcinfo, bool isgt, bool iseq, PGFunction fallback)
+{
+	double		selec = uint_scalarineqsel_(fcinfo, isgt, iseq);
+
+	if (selec < 0.0)
+		return DirectFunctionCall4(fallback,
+								   PG_GETARG_DATUM(0), PG_GETARG_DATUM(1),
+								   PG_GETARG_DATUM(2), PG_GETARG_DATUM(3));
+	PG_RETURN_FLOAT8((float8) selec);
+}
+
+PG_FUNCTION_INFO_V1(uint_scalarltsel);
+Datum
+uint_scalarltsel(PG_FUNCTION_ARGS)
+{
+	return uint_scalarineqsel(fcinfo, false, false, scalarltsel);
+}
+
+PG_FUNCTION_INFO_V1(uint_scalarlesel);
+Datum
+uint_scalarlesel(PG_FUNCTION_ARGS)
+{
+	return uint_scalarineqsel(fcinfo, false, true, scalarlesel);
+}
+
+PG_FUNCTION_INFO_V1(uint_scalargtsel);
+Datum
+uint_scalargtsel(PG_FUNCTION_ARGS)
+{
+	return uint_scalarineqsel(fcinfo, true, false, scalargtsel);
+}
+
+PG_FUNCTION_INFO_V1(uint_scalargesel);
+Datum
+uint_scalargesel(PG_FUNCTION_ARGS)
+{
+	return uint_scalarineqsel(fcinfo, true, true, scalargesel);
+}
+
+#endif
@@ -0,0 +1,124 @@
+-- parallel aggregation: partial states are combined across workers
+CREATE TABLE agg_test (g int, a int1, b uint1, c uint2, d uint4, e uint8, f int16, h uint16);
+INSERT INTO agg_test
+    SELECT i % 7, (i % 256 - 128)::int1, (i % 256)::uint1, (i % 65536)::uint2,
+           (i * 65599)::uint4, (i::numeric * 90000000007)::uint8,
+           (i::numeric * -1180591620717411303424 + 5)::int16,
+           (i::numeric * 18446744073709551629)::uint16
+    FROM generate_series(1, 20000) i;
+INSERT INTO agg_test VALUES (NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
+ANALYZE agg_test;
+
+CREATE VIEW agg_test_all AS
+SELECT min(a) AS min_a, max(a) AS max_a, bit_and(a) AS and_a, bit_or(a) AS or_a, sum(a) AS sum_a, avg(a) AS avg_a,
+       min(b) AS min_b, max(b) AS max_b, bit_and(b) AS and_b, bit_or(b) AS or_b, sum(b) AS sum_b, avg(b) AS avg_b,
+       min(c) AS min_c, max(c) AS max_c, bit_and(c) AS and_c, bit_or(c) AS or_c, sum(c) AS sum_c, avg(c) AS avg_c,
+       min(d) AS min_d, max(d) AS max_d, bit_and(d) AS and_d, bit_or(d) AS or_d, sum(d) AS sum_d, avg(d) AS avg_d,
+       min(e) AS min_e, max(e) AS max_e, bit_and(e) AS and_e, bit_or(e) AS or_e, sum(e) AS sum_e, avg(e) AS avg_e,
+       min(f) AS min_f, max(f) AS max_f, bit_and(f) AS and_f, bit_or(f) AS or_f, sum(f) AS sum_f, avg(f) AS avg_f,
+       min(h) AS min_h, max(h) AS max_h, bit_and(h) AS and_h, bit_or(h) AS or_h, sum(h) AS sum_h, avg(h) AS avg_h
+FROM agg_test;
+
+CREATE TEMP TABLE agg_serial AS SELECT * FROM agg_test_all;
+
+SET parallel_setup_cost = 0;
+SET parallel_tuple_cost = 0;
+SET min_parallel_table_scan_size = 0;
+SET max_parallel_workers_per_gather = 2;
+
+EXPLAIN (COSTS OFF) SELECT * FROM agg_test_all;
+
+\x on
+SELECT * FROM agg_test_all;
+\x off
+SELECT (SELECT agg_serial FROM agg_serial) = (SELECT agg_test_all FROM agg_test_all) AS same;
+
+EXPLAIN (COSTS OFF) SELECT g, sum(e), avg(f) FROM agg_test GROUP BY g ORDER BY g;
+SELECT g, sum(e), avg(f) FROM agg_test GROUP BY g ORDER BY g;
+
+-- partitionwise aggregation combines per-partition partial states
+CREATE TABLE agg_part (k int, e uint8, h uint16) PARTITION BY RANGE (k);
+CREATE TABLE agg_part_1 PARTITION OF agg_part FOR VALUES FROM (0) TO (10000);
+CREATE TABLE agg_part_2 PARTITION OF agg_part FOR VALUES FROM (10000) TO (20001);
+INSERT INTO agg_part SELECT i, (i * 7)::uint8, (i::numeric * 18446744073709551629)::uint16
+    FROM generate_series(1, 20000) i;
+ANALYZE agg_part;
+
+SET max_parallel_workers_per_gather = 0;
+SET enable_partitionwise_aggregate = on;
+EXPLAIN (COSTS OFF) SELECT min(e), max(h), sum(e), avg(h), bit_or(e) FROM agg_part;
+SELECT min(e), max(h), sum(e), avg(h), bit_or(e) FROM agg_part;
+
+RESET ALL;
+
+-- avg matches numeric division, digits and scale, and does not overflow
+SELECT g, avg(v), avg(v)::text = (sum(v::numeric) / count(v))::text AS same
+FROM (SELECT i % 5, (i * 2 - 123)::int1 FROM generate_series(1, 123) i) _ (g, v) GROUP BY g ORDER BY g;
+SELECT g, avg(v), avg(v)::text = (sum(v::numeric) / count(v))::text AS same
+FROM (SELECT i % 3, (i::bigint * 4294967)::uint4 FROM generate_series(1, 1000) i) _ (g, v) GROUP BY g ORDER BY g;
+SELECT avg(v), avg(v)::text = (sum(v::numeric) / count(v))::text AS same
+FROM (VALUES ('18446744073709551615'::uint8), ('18446744073709551615'), ('18446744073709551614')) _ (v);
+SELECT avg(v), avg(v)::text = (sum(v::numeric) / count(v))::text AS same
+FROM (VALUES ('-170141183460469231731687303715884105728'::int16),
+             ('-170141183460469231731687303715884105728'), ('-1')) _ (v);
+SELECT avg(v), avg(v)::text = (sum(v::numeric) / count(v))::text AS same
+FROM (VALUES ('170141183460469231731687303715884105727'::int16),
+             ('170141183460469231731687303715884105727'), ('-170141183460469231731687303715884105728')) _ (v);
+SELECT avg(v), avg(v)::text = (sum(v::numeric) / count(v))::text AS same
+FROM (VALUES ('340282366920938463463374607431768211455'::uint16),
+             ('340282366920938463463374607431768211455'), ('340282366920938463463374607431768211454')) _ (v);
+SELECT avg(v), avg(v)::text = (sum(v::numeric) / count(v))::text AS same
+FROM (SELECT '1'::uint16 UNION ALL SELECT 0::uint16 FROM generate_series(1, 99999)) _ (v);
+SELECT avg(v), avg(v)::text = (sum(v::numeric) / count(v))::text AS same
+FROM (SELECT 0::uint8 FROM generate_series(1, 3)) _ (v);
+SELECT avg(v) FROM (SELECT NULL::uint8 FROM generate_series(1, 3)) _ (v);
+-- groups of 1 to 141 rows with magnitudes from 1 to 10^30
+SELECT count(*) AS groups, count(*) FILTER (WHERE avg::text = ref::text) AS same
+FROM (SELECT avg(v) AS avg, sum(v::numeric) / count(v) AS ref
+      FROM (SELECT floor(sqrt(i)), ((i::numeric * 1234567890123456789) % 10::numeric ^ (i % 31) - 10::numeric ^ (i % 31) / 2)::int16
+            FROM generate_series(1, 20000) i) _ (g, v) GROUP BY g) _;
+SELECT count(*) AS groups, count(*) FILTER (WHERE avg::text = ref::text) AS same
+FROM (SELECT avg(v) AS avg, sum(v::numeric) / count(v) AS ref
+      FROM (SELECT floor(sqrt(i)), ((i::numeric * 1234567890123456789) % 10::numeric ^ (i % 20))::uint8
+            FROM generate_series(1, 20000) i) _ (g, v) GROUP BY g) _;
+
+-- sliding window frames use the inverse transition functions
+SELECT i, sum(v) OVER w, avg(v) OVER w
+FROM (VALUES (1, '18446744073709551615'::uint8), (2, NULL), (3, 1), (4, 2), (5, 2), (6, NULL), (7, NULL)) _ (i, v)
+WINDOW w AS (ORDER BY i ROWS BETWEEN 1 PRECEDING AND CURRENT ROW);
+SELECT count(*) AS rows, count(*) FILTER (WHERE moving::text = reference::text) AS same
+FROM (SELECT ROW(sum(a) OVER w, avg(a) OVER w, sum(b) OVER w, avg(b) OVER w, sum(c) OVER w, avg(c) OVER w,
+                 sum(d) OVER w, avg(d) OVER w, sum(e) OVER w, avg(e) OVER w, sum(f) OVER w, avg(f) OVER w,
+                 sum(h) OVER w, avg(h) OVER w) AS moving,
+             ROW(sum(a::numeric) OVER w, avg(a::numeric) OVER w, sum(b::numeric) OVER w, avg(b::numeric) OVER w,
+                 sum(c::numeric) OVER w, avg(c::numeric) OVER w, sum(d::numeric) OVER w, avg(d::numeric) OVER w,
+                 sum(e::numeric) OVER w, avg(e::numeric) OVER w, sum(f::numeric) OVER w, avg(f::numeric) OVER w,
+                 sum(h::numeric) OVER w, avg(h::numeric) OVER w) AS reference
+      FROM agg_test WINDOW w AS (ORDER BY g, d ROWS BETWEEN 100 PRECEDING AND 1 PRECEDING)) _;
+
+-- sum raises an error on overflow instead of wrapping, in every plan
+SELECT sum(v) FROM (VALUES ('18446744073709551615'::uint8), ('1')) _ (v);
+SELECT sum(v) FROM (VALUES ('170141183460469231731687303715884105727'::int16), ('1')) _ (v);
+SELECT sum(v) FROM (VALUES ('-170141183460469231731687303715884105728'::int16), ('-1')) _ (v);
+SELECT sum(v) FROM (VALUES ('340282366920938463463374607431768211455'::uint16), ('1')) _ (v);
+SELECT i, sum(v) OVER (ORDER BY i ROWS BETWEEN 1 PRECEDING AND CURRENT ROW)
+FROM (VALUES (1, '18446744073709551615'::uint8), (2, '1'), (3, '1')) _ (i, v);
+SELECT i, sum(v) OVER (ORDER BY i ROWS BETWEEN 1 PRECEDING AND CURRENT ROW)
+FROM (VALUES (1, '-170141183460469231731687303715884105728'::int16), (2, '-1'), (3, '1')) _ (i, v);
+SET parallel_setup_cost = 0;
+SET parallel_tuple_cost = 0;
+SET min_parallel_table_scan_size = 0;
+SET max_parallel_workers_per_gather = 2;
+\set VERBOSITY terse
+SELECT sum(e * '10000'::uint8) FROM agg_test;
+SELECT sum(h * '100000000000'::uint16) FROM agg_test;
+\set VERBOSITY default
+-- each partition's sum fits, only the combined one overflows
+SET max_parallel_workers_per_gather = 0;
+SET enable_partitionwise_aggregate = on;
+SELECT sum(h * '100000000000'::uint16) FROM agg_part;
+RESET ALL;
+
+DROP TABLE agg_part;
+DROP VIEW agg_test_all;
+DROP TABLE agg_test;
@@ -0,0 +1,36 @@
+-- double-aligned variants of the 128-bit types
+SELECT typname, typlen, typalign FROM pg_type
+WHERE typname IN ('int16', 'uint16', 'int16a', 'uint16a') ORDER BY typname;
+SELECT '-170141183460469231731687303715884105728'::int16a, '340282366920938463463374607431768211455'::uint16a;
+SELECT '-5'::int16a::int16, '5'::uint16::uint16a;
+
+CREATE TABLE aligned_test (k int1, f int16, h uint16);
+INSERT INTO aligned_test
+    SELECT i % 100, (i - 500)::int16 * '1000000000000000000000'::int16, i::uint16 << 100
+    FROM generate_series(1, 1000) i;
+CREATE INDEX aligned_test_h ON aligned_test (h);
+CREATE TEMP TABLE aligned_before AS SELECT * FROM aligned_test;
+
+-- migrating existing columns rewrites them with the new alignment
+ALTER TABLE aligned_test ALTER COLUMN f TYPE int16a, ALTER COLUMN h TYPE uint16a;
+SELECT attname, atttypid::regtype, attalign FROM pg_attribute
+WHERE attrelid = 'aligned_test'::regclass AND attnum > 0 ORDER BY attnum;
+SELECT count(*) FROM (SELECT k, f::int16, h::uint16 FROM aligned_test EXCEPT SELECT * FROM aligned_before) _;
+
+SET enable_seqscan = off;
+SET enable_bitmapscan = off;
+EXPLAIN (COSTS OFF) SELECT k FROM aligned_test WHERE h = '1267650600228229401496703205376';
+SELECT k FROM aligned_test WHERE h = '1267650600228229401496703205376';
+RESET enable_seqscan;
+RESET enable_bitmapscan;
+
+-- everything else goes through the implicit cast to the base type
+SELECT f + 1, pg_typeof(f + 1), h >> 100, f < 0 FROM aligned_test WHERE h = '1267650600228229401496703205376';
+SELECT f FROM aligned_test ORDER BY f LIMIT 3;
+SELECT min(f), max(h), sum(f), count(DISTINCT h) FROM aligned_test;
+
+ALTER TABLE aligned_test ALTER COLUMN f TYPE int16, ALTER COLUMN h TYPE uint16;
+SELECT count(*) FROM (SELECT * FROM aligned_test EXCEPT SELECT * FROM aligned_before) _;
+
+DROP TABLE aligned_test;
+DROP TABLE aligned_before;
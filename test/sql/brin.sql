@@ -0,0 +1,57 @@
+-- BRIN: one row per page range summary, so point and range queries only
+-- visit the matching pages
+CREATE FUNCTION brin_explain(query text) RETURNS SETOF text LANGUAGE plpgsql AS $$
+DECLARE
+    line text;
+BEGIN
+    FOR line IN EXECUTE 'EXPLAIN (ANALYZE, COSTS OFF, TIMING OFF, SUMMARY OFF) ' || query LOOP
+        CONTINUE WHEN line ~ 'Index Searches';
+        RETURN NEXT regexp_replace(line, ' \(actual [^)]*\)', '');
+    END LOOP;
+END
+$$;
+CREATE FUNCTION brin_blocks(query text) RETURNS int LANGUAGE sql AS $$
+    SELECT substring(l FROM 'lossy=(\d+)')::int FROM brin_explain(query) l WHERE l ~ 'Heap Blocks'
+$$;
+
+CREATE TABLE brin_test (a int1, b uint1, c uint2, d uint4, e uint8, f int16, g uint16);
+INSERT INTO brin_test
+    SELECT (i / 16 - 128)::int1, (i / 16)::uint1, i::uint2, (i * 1000)::uint4,
+           (i * 10000000000000)::uint8, (i - 1000)::int16 * '1267650600228229401496703205376'::int16,
+           i::uint16 << 100
+    FROM generate_series(0, 1999) i;
+
+CREATE INDEX brin_test_minmax ON brin_test USING brin (a, b, c, d, e, f, g) WITH (pages_per_range = 1);
+VACUUM ANALYZE brin_test;
+SET enable_seqscan = off;
+
+SELECT * FROM brin_explain('SELECT * FROM brin_test WHERE e = ''12340000000000000''::uint8');
+
+SELECT brin_blocks('SELECT * FROM brin_test WHERE a = ''-100''::int1') AS a,
+       brin_blocks('SELECT * FROM brin_test WHERE b = ''50''::uint1') AS b,
+       brin_blocks('SELECT * FROM brin_test WHERE c = ''1000''::uint2') AS c,
+       brin_blocks('SELECT * FROM brin_test WHERE d = ''500000''::uint4') AS d,
+       brin_blocks('SELECT * FROM brin_test WHERE e = ''12340000000000000''::uint8') AS e,
+       brin_blocks('SELECT * FROM brin_test WHERE f = ''-633825300114114700748351602688000''::int16') AS f,
+       brin_blocks('SELECT * FROM brin_test WHERE g = ''1901475900342344102245054808064000''::uint16') AS g;
+
+-- cross-type operators from integer_ops
+SELECT brin_blocks('SELECT * FROM brin_test WHERE a >= -5') AS a,
+       brin_blocks('SELECT * FROM brin_test WHERE c < 100') AS c,
+       brin_blocks('SELECT * FROM brin_test WHERE d BETWEEN 500000 AND 600000') AS d,
+       brin_blocks('SELECT * FROM brin_test WHERE e = 12340000000000000') AS e;
+
+SELECT (SELECT count(*) FROM brin_test WHERE a = '-100'::int1) AS a,
+       (SELECT count(*) FROM brin_test WHERE b = '50'::uint1) AS b,
+       (SELECT count(*) FROM brin_test WHERE c < 100) AS c,
+       (SELECT count(*) FROM brin_test WHERE d BETWEEN 500000 AND 600000) AS d,
+       (SELECT count(*) FROM brin_test WHERE e = 12340000000000000) AS e,
+       (SELECT count(*) FROM brin_test WHERE f = '-633825300114114700748351602688000'::int16) AS f,
+       (SELECT count(*) FROM brin_test WHERE g = '1901475900342344102245054808064000'::uint16) AS g;
+
+DROP INDEX brin_test_minmax;
+
+RESET enable_seqscan;
+DROP TABLE brin_test;
+DROP FUNCTION brin_blocks(text);
+DROP FUNCTION brin_explain(text);
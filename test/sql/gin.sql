@@ -0,0 +1,61 @@
+-- GIN: the uint columns share a multicolumn index with an array column
+CREATE TABLE gin_test (a int1, b uint1, c uint2, d uint4, e uint8, f int16, g uint16, tags int[]);
+INSERT INTO gin_test
+    SELECT (i % 256 - 128)::int1, (i % 256)::uint1, (i * 61)::uint2, (i::bigint * 4294967)::uint4,
+           (i::numeric * 18446744073709551)::uint8, (i - 500)::int16 * '1267650600228229401496703205376'::int16,
+           i::uint16 << 118, ARRAY[i % 10, i % 7]
+    FROM generate_series(1, 1000) i;
+CREATE INDEX gin_test_idx ON gin_test USING gin (a, b, c, d, e, f, g, tags);
+SET enable_seqscan = off;
+
+EXPLAIN (COSTS OFF)
+SELECT count(*) FROM gin_test WHERE e > '9223372036854775808' AND tags @> '{3}';
+
+SELECT count(*) FROM gin_test WHERE e > '9223372036854775808' AND tags @> '{3}';
+
+-- range scans start a partial match at the query value, or at the
+-- type's minimum for < and <=
+SELECT (SELECT count(*) FROM gin_test WHERE a < '-100') AS lt,
+       (SELECT count(*) FROM gin_test WHERE a <= '-100') AS le,
+       (SELECT count(*) FROM gin_test WHERE a = '-100') AS eq,
+       (SELECT count(*) FROM gin_test WHERE a >= '-100') AS ge,
+       (SELECT count(*) FROM gin_test WHERE a > '-100') AS gt;
+
+SELECT (SELECT count(*) FROM gin_test WHERE b < '200') AS lt,
+       (SELECT count(*) FROM gin_test WHERE b <= '200') AS le,
+       (SELECT count(*) FROM gin_test WHERE b = '200') AS eq,
+       (SELECT count(*) FROM gin_test WHERE b >= '200') AS ge,
+       (SELECT count(*) FROM gin_test WHERE b > '200') AS gt;
+
+SELECT (SELECT count(*) FROM gin_test WHERE c < '30500') AS lt,
+       (SELECT count(*) FROM gin_test WHERE c <= '30500') AS le,
+       (SELECT count(*) FROM gin_test WHERE c = '30500') AS eq,
+       (SELECT count(*) FROM gin_test WHERE c >= '30500') AS ge,
+       (SELECT count(*) FROM gin_test WHERE c > '30500') AS gt;
+
+SELECT (SELECT count(*) FROM gin_test WHERE d < '2147483500') AS lt,
+       (SELECT count(*) FROM gin_test WHERE d <= '2147483500') AS le,
+       (SELECT count(*) FROM gin_test WHERE d = '2147483500') AS eq,
+       (SELECT count(*) FROM gin_test WHERE d >= '2147483500') AS ge,
+       (SELECT count(*) FROM gin_test WHERE d > '2147483500') AS gt;
+
+SELECT (SELECT count(*) FROM gin_test WHERE e < '11068046444225730600') AS lt,
+       (SELECT count(*) FROM gin_test WHERE e <= '11068046444225730600') AS le,
+       (SELECT count(*) FROM gin_test WHERE e = '11068046444225730600') AS eq,
+       (SELECT count(*) FROM gin_test WHERE e >= '11068046444225730600') AS ge,
+       (SELECT count(*) FROM gin_test WHERE e > '11068046444225730600') AS gt;
+
+SELECT (SELECT count(*) FROM gin_test WHERE f < '126765060022822940149670320537600') AS lt,
+       (SELECT count(*) FROM gin_test WHERE f <= '126765060022822940149670320537600') AS le,
+       (SELECT count(*) FROM gin_test WHERE f = '126765060022822940149670320537600') AS eq,
+       (SELECT count(*) FROM gin_test WHERE f >= '126765060022822940149670320537600') AS ge,
+       (SELECT count(*) FROM gin_test WHERE f > '126765060022822940149670320537600') AS gt;
+
+SELECT (SELECT count(*) FROM gin_test WHERE g < '199384199367737380935571059042051686400') AS lt,
+       (SELECT count(*) FROM gin_test WHERE g <= '199384199367737380935571059042051686400') AS le,
+       (SELECT count(*) FROM gin_test WHERE g = '199384199367737380935571059042051686400') AS eq,
+       (SELECT count(*) FROM gin_test WHERE g >= '199384199367737380935571059042051686400') AS ge,
+       (SELECT count(*) FROM gin_test WHERE g > '199384199367737380935571059042051686400') AS gt;
+
+RESET enable_seqscan;
+DROP TABLE gin_test;
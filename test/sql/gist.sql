@@ -0,0 +1,126 @@
+-- GiST: btree_gist-style interval keys, usable next to geometric columns
+CREATE TABLE gist_test (a int1, b uint1, c uint2, d uint4, e uint8, f int16, g uint16, p point);
+INSERT INTO gist_test
+    SELECT (i % 256 - 128)::int1, (i % 256)::uint1, (i * 61)::uint2, (i::bigint * 4294967)::uint4,
+           (i::numeric * 18446744073709551)::uint8, '-1267650600228229401496703205376'::int16 + i * 7,
+           '1267650600228229401496703205376'::uint16 + i * 7, point(i % 37, i % 41)
+    FROM generate_series(1, 1000) i;
+CREATE INDEX gist_test_idx ON gist_test USING gist (a, b, c, d, e, f, g, p);
+SET enable_seqscan = off;
+
+-- inner keys are intervals; leaf keys are single values
+SELECT (SELECT count(*) FROM gist_test WHERE a < '-100') AS lt,
+       (SELECT count(*) FROM gist_test WHERE a <= '-100') AS le,
+       (SELECT count(*) FROM gist_test WHERE a = '-100') AS eq,
+       (SELECT count(*) FROM gist_test WHERE a >= '-100') AS ge,
+       (SELECT count(*) FROM gist_test WHERE a > '-100') AS gt,
+       (SELECT count(*) FROM gist_test WHERE a <> '-100') AS ne;
+
+SELECT (SELECT count(*) FROM gist_test WHERE b < '200') AS lt,
+       (SELECT count(*) FROM gist_test WHERE b <= '200') AS le,
+       (SELECT count(*) FROM gist_test WHERE b = '200') AS eq,
+       (SELECT count(*) FROM gist_test WHERE b >= '200') AS ge,
+       (SELECT count(*) FROM gist_test WHERE b > '200') AS gt,
+       (SELECT count(*) FROM gist_test WHERE b <> '200') AS ne;
+
+SELECT (SELECT count(*) FROM gist_test WHERE c < '30500') AS lt,
+       (SELECT count(*) FROM gist_test WHERE c <= '30500') AS le,
+       (SELECT count(*) FROM gist_test WHERE c = '30500') AS eq,
+       (SELECT count(*) FROM gist_test WHERE c >= '30500') AS ge,
+       (SELECT count(*) FROM gist_test WHERE c > '30500') AS gt,
+       (SELECT count(*) FROM gist_test WHERE c <> '30500') AS ne;
+
+SELECT (SELECT count(*) FROM gist_test WHERE d < '2147483500') AS lt,
+       (SELECT count(*) FROM gist_test WHERE d <= '2147483500') AS le,
+       (SELECT count(*) FROM gist_test WHERE d = '2147483500') AS eq,
+       (SELECT count(*) FROM gist_test WHERE d >= '2147483500') AS ge,
+       (SELECT count(*) FROM gist_test WHERE d > '2147483500') AS gt,
+       (SELECT count(*) FROM gist_test WHERE d <> '2147483500') AS ne;
+
+SELECT (SELECT count(*) FROM gist_test WHERE e < '11068046444225730600') AS lt,
+       (SELECT count(*) FROM gist_test WHERE e <= '11068046444225730600') AS le,
+       (SELECT count(*) FROM gist_test WHERE e = '11068046444225730600') AS eq,
+       (SELECT count(*) FROM gist_test WHERE e >= '11068046444225730600') AS ge,
+       (SELECT count(*) FROM gist_test WHERE e > '11068046444225730600') AS gt,
+       (SELECT count(*) FROM gist_test WHERE e <> '11068046444225730600') AS ne;
+
+SELECT (SELECT count(*) FROM gist_test WHERE f < '-1267650600228229401496703201876') AS lt,
+       (SELECT count(*) FROM gist_test WHERE f <= '-1267650600228229401496703201876') AS le,
+       (SELECT count(*) FROM gist_test WHERE f = '-1267650600228229401496703201876') AS eq,
+       (SELECT count(*) FROM gist_test WHERE f >= '-1267650600228229401496703201876') AS ge,
+       (SELECT count(*) FROM gist_test WHERE f > '-1267650600228229401496703201876') AS gt,
+       (SELECT count(*) FROM gist_test WHERE f <> '-1267650600228229401496703201876') AS ne;
+
+SELECT (SELECT count(*) FROM gist_test WHERE g < '1267650600228229401496703208876') AS lt,
+       (SELECT count(*) FROM gist_test WHERE g <= '1267650600228229401496703208876') AS le,
+       (SELECT count(*) FROM gist_test WHERE g = '1267650600228229401496703208876') AS eq,
+       (SELECT count(*) FROM gist_test WHERE g >= '1267650600228229401496703208876') AS ge,
+       (SELECT count(*) FROM gist_test WHERE g > '1267650600228229401496703208876') AS gt,
+       (SELECT count(*) FROM gist_test WHERE g <> '1267650600228229401496703208876') AS ne;
+
+SELECT count(*) FROM gist_test WHERE e > '9223372036854775808' AND p <@ box '((0,0),(5,5))';
+
+-- <-> is the exact distance in the unsigned type of the same width up to
+-- 32 bits, and float8 for the wider types
+SELECT '-128'::int1 <-> '127'::int1 AS int1, '7'::uint4 <-> '4294967295'::uint4 AS uint4,
+       '0'::uint8 <-> '18446744073709551615'::uint8 AS uint8,
+       '-170141183460469231731687303715884105728'::int16 <-> '170141183460469231731687303715884105727'::int16 AS int16,
+       pg_typeof('1'::uint4 <-> '2'::uint4) AS uint4_type, pg_typeof('1'::int16 <-> '2'::int16) AS int16_type;
+
+-- nearest-neighbour searches
+EXPLAIN (COSTS OFF)
+SELECT e, e <-> '11068046444225730000' AS dist FROM gist_test ORDER BY e <-> '11068046444225730000' LIMIT 4;
+
+SELECT e, e <-> '11068046444225730000' AS dist FROM gist_test ORDER BY e <-> '11068046444225730000' LIMIT 4;
+
+EXPLAIN (COSTS OFF)
+SELECT f, f <-> '-1267650600228229401496703201874' AS dist FROM gist_test ORDER BY f <-> '-1267650600228229401496703201874' LIMIT 5;
+
+SELECT f, f <-> '-1267650600228229401496703201874' AS dist FROM gist_test ORDER BY f <-> '-1267650600228229401496703201874' LIMIT 5;
+
+EXPLAIN (COSTS OFF)
+SELECT g, g <-> '1267650600228229401496703208878' AS dist FROM gist_test ORDER BY g <-> '1267650600228229401496703208878' LIMIT 5;
+
+SELECT g, g <-> '1267650600228229401496703208878' AS dist FROM gist_test ORDER BY g <-> '1267650600228229401496703208878' LIMIT 5;
+
+RESET enable_seqscan;
+DROP TABLE gist_test;
+
+-- distances beyond 2^53 are rounded the same way by the index and by <->,
+-- so an index scan returns them in the order of a sort
+CREATE TABLE gist_knn (e uint8, f int16, g uint16);
+INSERT INTO gist_knn
+    SELECT '1152921504606846976'::uint8 + k * 100, '-1267650600228229401496703205376'::int16 - k * 100000000000000,
+           '1267650600228229401496703205376'::uint16 + k * 100000000000000
+    FROM (SELECT i * 7919 % 1000 FROM generate_series(1, 1000) i) _ (k);
+CREATE INDEX gist_knn_idx ON gist_knn USING gist (e, f, g);
+SET enable_seqscan = off;
+
+EXPLAIN (COSTS OFF)
+SELECT e <-> '0' AS dist FROM gist_knn ORDER BY e <-> '0' LIMIT 5;
+
+SELECT e <-> '0' AS dist FROM gist_knn ORDER BY e <-> '0' LIMIT 5;
+
+EXPLAIN (COSTS OFF)
+SELECT f <-> '0' AS dist FROM gist_knn ORDER BY f <-> '0' LIMIT 5;
+
+SELECT f <-> '0' AS dist FROM gist_knn ORDER BY f <-> '0' LIMIT 5;
+
+EXPLAIN (COSTS OFF)
+SELECT g <-> '0' AS dist FROM gist_knn ORDER BY g <-> '0' LIMIT 5;
+
+SELECT g <-> '0' AS dist FROM gist_knn ORDER BY g <-> '0' LIMIT 5;
+
+RESET enable_seqscan;
+SET enable_indexscan = off;
+SET enable_bitmapscan = off;
+
+SELECT e <-> '0' AS dist FROM gist_knn ORDER BY e <-> '0' LIMIT 5;
+
+SELECT f <-> '0' AS dist FROM gist_knn ORDER BY f <-> '0' LIMIT 5;
+
+SELECT g <-> '0' AS dist FROM gist_knn ORDER BY g <-> '0' LIMIT 5;
+
+RESET enable_indexscan;
+RESET enable_bitmapscan;
+DROP TABLE gist_knn;
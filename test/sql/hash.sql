@@ -7,3 +7,66 @@ SELECT hashuint1(55::uint1);
 SELECT hashuint2(55::uint2);
 SELECT hashuint4(55::uint4);
 SELECT hashuint8(55::uint8);
+
+-- every type hashes a value like int8 does, with and without a seed
+SELECT hashint16(55::int16) = hashint8(55) AS int16, hashuint16(55::uint16) = hashint8(55) AS uint16,
+       hashint1(-5::int1) = hashint8(-5) AS int1_neg, hashint16(-5::int16) = hashint8(-5) AS int16_neg,
+       hashint16('-9223372036854775808'::int16) = hashint8('-9223372036854775808') AS int16_min,
+       hashuint8('9223372036854775807'::uint8) = hashint8('9223372036854775807') AS uint8_max;
+SELECT hashint1extended(55::int1, 1) = hashint8extended(55, 1) AS int1,
+       hashuint1extended(55::uint1, 1) = hashint8extended(55, 1) AS uint1,
+       hashuint2extended(55::uint2, 1) = hashint8extended(55, 1) AS uint2,
+       hashuint4extended(55::uint4, 1) = hashint8extended(55, 1) AS uint4,
+       hashuint8extended(55::uint8, 1) = hashint8extended(55, 1) AS uint8,
+       hashint16extended(55::int16, 1) = hashint8extended(55, 1) AS int16,
+       hashuint16extended(55::uint16, 1) = hashint8extended(55, 1) AS uint16;
+SELECT hashint1extended(-5::int1, 7) = hashint8extended(-5, 7) AS int1,
+       hashint16extended(-5::int16, 7) = hashint8extended(-5, 7) AS int16,
+       hashuint4extended('4294967295'::uint4, 7) = hashint8extended(4294967295, 7) AS uint4,
+       hashuint8extended(55::uint8, 0) & 4294967295 = hashuint8(55::uint8)::int8 & 4294967295 AS seed0,
+       hashuint8extended(55::uint8, 0) <> hashuint8extended(55::uint8, 1) AS seeded;
+
+-- values beyond int8/uint8 range are mixed over their full width
+SELECT hashint16('18446744073709551615'::int16) = hashuint8('18446744073709551615'::uint8) AS uint8_max,
+       hashuint16('18446744073709551615'::uint16) = hashuint8('18446744073709551615'::uint8) AS uint8_max_u,
+       hashint16('1267650600228229401496703205376'::int16) = hashuint16('1267650600228229401496703205376'::uint16) AS wide,
+       hashint16extended('1267650600228229401496703205376'::int16, 3)
+           = hashuint16extended('1267650600228229401496703205376'::uint16, 3) AS wide_ext,
+       hashuint16extended('1267650600228229401496703205376'::uint16, 0) & 4294967295
+           = hashuint16('1267650600228229401496703205376'::uint16)::int8 & 4294967295 AS seed0;
+SELECT count(DISTINCT hashuint16((a::uint16 << 64) | a::uint16)) AS repeated_halves,
+       count(DISTINCT hashint16(-((a::int16 << 64) + a))) AS negative
+FROM generate_series(1, 1000) a;
+
+-- hash partitioning; pruning hashes the constant with its own type's function
+CREATE TABLE hash_part (x uint8, y int16) PARTITION BY HASH (x);
+CREATE TABLE hash_part_0 PARTITION OF hash_part FOR VALUES WITH (MODULUS 4, REMAINDER 0);
+CREATE TABLE hash_part_1 PARTITION OF hash_part FOR VALUES WITH (MODULUS 4, REMAINDER 1);
+CREATE TABLE hash_part_2 PARTITION OF hash_part FOR VALUES WITH (MODULUS 4, REMAINDER 2);
+CREATE TABLE hash_part_3 PARTITION OF hash_part FOR VALUES WITH (MODULUS 4, REMAINDER 3);
+INSERT INTO hash_part SELECT i, i - 500 FROM generate_series(1, 1000) i;
+SELECT count(*) = 4 AS all_used FROM (SELECT DISTINCT tableoid FROM hash_part) _;
+SELECT count(*) FILTER (WHERE (SELECT count(*) FROM hash_part WHERE x = i::uint8) = 1) AS uint8,
+       count(*) FILTER (WHERE (SELECT count(*) FROM hash_part WHERE x = i) = 1) AS int4,
+       count(*) FILTER (WHERE (SELECT count(*) FROM hash_part WHERE x = i::int8) = 1) AS int8,
+       count(*) FILTER (WHERE (SELECT count(*) FROM hash_part WHERE x = i::uint2) = 1) AS uint2
+FROM generate_series(1, 1000) i;
+
+CREATE TABLE hash_part16 (y int16) PARTITION BY HASH (y);
+CREATE TABLE hash_part16_0 PARTITION OF hash_part16 FOR VALUES WITH (MODULUS 2, REMAINDER 0);
+CREATE TABLE hash_part16_1 PARTITION OF hash_part16 FOR VALUES WITH (MODULUS 2, REMAINDER 1);
+INSERT INTO hash_part16 SELECT y FROM hash_part;
+SELECT count(*) FILTER (WHERE (SELECT count(*) FROM hash_part16 WHERE y = i::int16) = 1) AS int16,
+       count(*) FILTER (WHERE (SELECT count(*) FROM hash_part16 WHERE y = i) = 1) AS int4,
+       count(*) FILTER (WHERE (SELECT count(*) FROM hash_part16 WHERE y = i::int1) = 1) AS int1
+FROM generate_series(-100, 100) i;
+
+-- cross-type hash join, negative values included
+SET enable_mergejoin = off;
+SET enable_nestloop = off;
+SELECT count(*) FROM hash_part a JOIN generate_series(-500, 500) i ON a.y = i::int8;
+RESET enable_mergejoin;
+RESET enable_nestloop;
+
+DROP TABLE hash_part16;
+DROP TABLE hash_part;
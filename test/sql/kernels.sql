@@ -0,0 +1,50 @@
+-- every CPU level of the conversion kernels gives the same results as
+-- numeric and the generic level; a level the CPU doesn't support falls
+-- back to the best one it does, so this passes on any machine
+LOAD '$libdir/uint';
+SET uint.cpu_level = avx1024;
+
+SET uint.cpu_level = generic;
+CREATE TABLE kernel_values (n numeric, h16 text, h8 text, h4 text);
+INSERT INTO kernel_values
+    SELECT n, to_hex(n::uint16),
+           CASE WHEN n < 2::numeric ^ 64 THEN to_hex(n::uint8) END,
+           CASE WHEN n < 2::numeric ^ 32 THEN to_hex(n::uint4) END
+    FROM (SELECT trunc(2::numeric ^ k) + d FROM generate_series(0, 127) k, generate_series(-1, 1) d
+          UNION ALL
+          SELECT trunc(10::numeric ^ k) + d FROM generate_series(0, 38) k, generate_series(-1, 1) d
+          UNION ALL
+          SELECT trunc((g * 0.6180339887498948482) % 1 * 2::numeric ^ (g % 129))
+          FROM generate_series(1, 500) g) _ (n);
+
+CREATE FUNCTION kernel_mismatches() RETURNS bigint LANGUAGE sql AS $$
+    SELECT count(*) FROM kernel_values
+    WHERE n::uint16::text <> n::text
+       OR (' 00' || n::text || ' ')::uint16 <> n::uint16
+       OR to_hex(n::uint16) <> h16
+       OR CASE WHEN n <= 2::numeric ^ 127
+               THEN (-n)::int16::text <> (-n)::text OR (-n)::text::int16 <> (-n)::int16 END
+       OR CASE WHEN n < 2::numeric ^ 127
+               THEN n::int16::text <> n::text OR n::text::int16 <> n::int16 END
+       OR CASE WHEN n < 2::numeric ^ 64
+               THEN n::uint8::text <> n::text OR n::text::uint8 <> n::uint8
+                    OR to_hex(n::uint8) <> h8 END
+       OR CASE WHEN n < 2::numeric ^ 32
+               THEN n::uint4::text <> n::text OR n::text::uint4 <> n::uint4
+                    OR to_hex(n::uint4) <> h4 END
+       OR CASE WHEN n < 65536
+               THEN n::uint2::text <> n::text OR n::text::uint2 <> n::uint2 END
+$$;
+
+SELECT count(*), kernel_mismatches() FROM kernel_values;
+SET uint.cpu_level = sse4;
+SELECT kernel_mismatches();
+SET uint.cpu_level = avx2;
+SELECT kernel_mismatches();
+SET uint.cpu_level = avx512;
+SELECT kernel_mismatches();
+RESET uint.cpu_level;
+SELECT kernel_mismatches();
+
+DROP FUNCTION kernel_mismatches();
+DROP TABLE kernel_values;
@@ -1,3 +1,56 @@
 SELECT - '5'::int1;
 SELECT - '127'::int1;
 SELECT - '-128'::int1;
+SELECT - '5'::int16;
+SELECT - '-5'::int16;
+SELECT - '0'::int16;
+SELECT - '-170141183460469231731687303715884105727'::int16;
+SELECT - '-170141183460469231731687303715884105728'::int16;
+-- a zero product fits an unsigned result whatever the other sign
+SELECT '0'::uint8 * '-1'::int1;
+SELECT '-5'::int8 * '0'::uint16;
+
+-- the minimum value divided by -1 does not fit
+SELECT '-128'::int1 / '-1'::int1;
+SELECT '-9223372036854775808'::int8 / '-1'::int1;
+SELECT '-170141183460469231731687303715884105728'::int16 / '-1'::int16;
+SELECT '-170141183460469231731687303715884105727'::int16 / '-1'::int1;
+
+-- a constant divisor is prepared once; the results match dividing by
+-- the same value from a column
+CREATE TABLE div_test (a uint16, b int16, c uint8);
+INSERT INTO div_test SELECT (g::uint16 * 2654435761) << (g % 64), (g::int16 * -40503) << (g % 80), g::uint8 * 2654435761 FROM generate_series(1, 1000) g;
+INSERT INTO div_test VALUES ('340282366920938463463374607431768211455', '-170141183460469231731687303715884105728', '18446744073709551615'), ('0', '0', '0');
+CREATE FUNCTION div_mismatches(n bigint) RETURNS bigint LANGUAGE plpgsql AS $$
+DECLARE
+    result bigint;
+BEGIN
+    EXECUTE format($q$SELECT count(*) FROM (SELECT *, %1$s::bigint AS e FROM div_test OFFSET 0) t
+                      WHERE a / %1$s::uint8 <> a / e::uint8 OR a %% %1$s::uint8 <> a %% e::uint8
+                         OR b / -%1$s::int8 <> b / (-e) OR b %% -%1$s::int8 <> b %% (-e)
+                         OR c / %1$s::uint8 <> c / e::uint8 OR c %% %1$s::uint8 <> c %% e::uint8$q$,
+                   n) INTO result;
+    RETURN result;
+END
+$$;
+
+SELECT n, div_mismatches(n) FROM (VALUES (1), (3), (7), (10), (1024), (1000000007), (9223372036854775807)) v (n);
+
+DROP TABLE div_test;
+DROP FUNCTION div_mismatches(bigint);
+
+SELECT ' +42 '::uint4;
+SELECT '00000000000000000000000000000000000000000042'::uint8;
+SELECT '18446744073709551615'::uint8;
+SELECT '18446744073709551616'::uint8;
+SELECT '-0'::uint8;
+SELECT '-170141183460469231731687303715884105728'::int16;
+SELECT '170141183460469231731687303715884105728'::int16;
+SELECT ' 340282366920938463463374607431768211455 '::uint16;
+SELECT '340282366920938463463374607431768211456'::uint16;
+
+SELECT '255'::uint1::numeric, '255'::uint1::float8, '255'::uint1::real;
+SELECT '65535'::uint2::numeric, '65535'::uint2::float8, '65535'::uint2::real;
+SELECT '4294967295'::uint4::numeric, '4294967295'::uint4::float8, '4294967295'::uint4::real;
+SELECT '18446744073709551615'::uint8::float8, '18446744073709551615'::uint8::real;
+SELECT 4294967295::float8::uint4, 1e19::float8::uint8;
@@ -0,0 +1,3 @@
+-- multirange types, PostgreSQL 14 and later
+SELECT '{[1,3], [5,8), (9,10]}'::uint4multirange AS multi, '{[1,3), [5,8)}'::uint4multirange @> '6'::uint4 AS contains,
+       range_agg(r) FROM (VALUES ('[1,5)'::uint16range), ('[3,9)'), ('[20,21]')) _ (r);
@@ -0,0 +1,130 @@
+-- comparisons against numeric and float8 are exact, differential against
+-- comparing the value converted to numeric
+CREATE TABLE numcmp_ints (typ regtype, v numeric);
+INSERT INTO numcmp_ints VALUES
+    ('int1', -128), ('int1', -127), ('int1', -1), ('int1', 0),
+    ('int1', 1), ('int1', 2), ('int1', 126), ('int1', 127),
+    ('uint1', 0), ('uint1', 1), ('uint1', 2), ('uint1', 127),
+    ('uint1', 254), ('uint1', 255), ('uint2', 0), ('uint2', 1),
+    ('uint2', 2), ('uint2', 127), ('uint2', 65534), ('uint2', 65535),
+    ('uint4', 0), ('uint4', 1), ('uint4', 2), ('uint4', 127),
+    ('uint4', 4294967294), ('uint4', 4294967295), ('uint8', 0), ('uint8', 1),
+    ('uint8', 2), ('uint8', 127), ('uint8', 18446744073709551614), ('uint8', 18446744073709551615),
+    ('int16', -170141183460469231731687303715884105728), ('int16', -170141183460469231731687303715884105727), ('int16', -1), ('int16', 0),
+    ('int16', 1), ('int16', 2), ('int16', 127), ('int16', 170141183460469231731687303715884105726),
+    ('int16', 170141183460469231731687303715884105727), ('uint16', 0), ('uint16', 1), ('uint16', 2),
+    ('uint16', 127), ('uint16', 340282366920938463463374607431768211454), ('uint16', 340282366920938463463374607431768211455);
+
+CREATE TABLE numcmp_consts (n numeric, f float8);
+INSERT INTO numcmp_consts (n) VALUES
+    (-1e40), (-170141183460469231731687303715884105728.5), (-170141183460469231731687303715884105728), (-129),
+    (-128.5), (-128), (-1.5), (-1),
+    (-0.5), (0), (0.000001), (0.5),
+    (1), (1.5), (126.5), (127),
+    (127.5), (255.5), (256), (65535.5),
+    (4294967295.5), (4294967296), (9223372036854775807.5), (18446744073709551615),
+    (18446744073709551615.5), (18446744073709551616), (170141183460469231731687303715884105727.5), (340282366920938463463374607431768211455),
+    (340282366920938463463374607431768211455.5), (340282366920938463463374607431768211456), (1e40), ('NaN');
+-- float8 where it converts back to the same numeric
+UPDATE numcmp_consts SET f = n::float8 WHERE n::float8::numeric = n;
+
+CREATE FUNCTION numcmp_mismatches(typ regtype) RETURNS bigint LANGUAGE plpgsql AS $$
+DECLARE
+    cond text := 'false';
+    op text;
+    result bigint;
+BEGIN
+    FOREACH op IN ARRAY ARRAY['<', '<=', '=', '<>', '>=', '>'] LOOP
+        cond := cond || format(' OR (x %1$s n) IS DISTINCT FROM (v %1$s n)'
+                               ' OR (n %1$s x) IS DISTINCT FROM (n %1$s v)'
+                               ' OR (x %1$s f) IS DISTINCT FROM (v %1$s f::numeric)'
+                               ' OR (f %1$s x) IS DISTINCT FROM (f::numeric %1$s v)'
+                               ' OR bt%2$snumericcmp(x, n) IS DISTINCT FROM (v > n)::int - (v < n)::int'
+                               ' OR bt%2$sfloat8cmp(x, f) IS DISTINCT FROM (v > f::numeric)::int - (v < f::numeric)::int',
+                               op, typ);
+    END LOOP;
+    EXECUTE format('SELECT count(*) FROM (SELECT v, v::%s AS x FROM numcmp_ints WHERE typ = %L) i, numcmp_consts c WHERE %s',
+                   typ, typ, cond) INTO result;
+    RETURN result;
+END
+$$;
+
+SELECT typ, numcmp_mismatches(typ)
+FROM (VALUES ('int1'::regtype), ('uint1'::regtype), ('uint2'::regtype), ('uint4'::regtype), ('uint8'::regtype), ('int16'::regtype), ('uint16'::regtype)) _ (typ);
+
+-- where converting to float8 would round
+SELECT '18446744073709551615'::uint8 < '18446744073709551616'::float8 AS a,
+       '9007199254740993'::uint8 > 9007199254740992::float8 AS b,
+       '340282366920938463463374607431768211455'::uint16 < 'Infinity'::float8 AS c,
+       '-128'::int1 > '-Infinity'::float8 AS d,
+       '5'::uint4 < 'NaN'::float8 AS e,
+       '-170141183460469231731687303715884105728'::int16 = -2::float8 ^ 127 AS f;
+
+SELECT btuint8numericcmp('5', 5.5), btnumericuint8cmp(5.5, '5'), btint16float8cmp('-1', -1.0);
+
+-- constant operands are folded into integer bounds
+CREATE TABLE numcmp_test (e uint8, f int16);
+INSERT INTO numcmp_test SELECT i, i - 500 FROM generate_series(1, 1000) i;
+CREATE INDEX ON numcmp_test (e);
+CREATE INDEX ON numcmp_test (f);
+ANALYZE numcmp_test;
+SET enable_seqscan = off;
+SET enable_bitmapscan = off;
+
+EXPLAIN (COSTS OFF) SELECT * FROM numcmp_test WHERE e > 1.5;
+
+SELECT count(*) FROM numcmp_test WHERE e > 1.5;
+
+EXPLAIN (COSTS OFF) SELECT * FROM numcmp_test WHERE 2.5 > e;
+
+SELECT count(*) FROM numcmp_test WHERE 2.5 > e;
+
+EXPLAIN (COSTS OFF) SELECT * FROM numcmp_test WHERE e = 3.0::float8;
+
+SELECT count(*) FROM numcmp_test WHERE e = 3.0::float8;
+
+EXPLAIN (COSTS OFF) SELECT * FROM numcmp_test WHERE e BETWEEN 10.5 AND 20.5;
+
+SELECT count(*) FROM numcmp_test WHERE e BETWEEN 10.5 AND 20.5;
+
+EXPLAIN (COSTS OFF) SELECT * FROM numcmp_test WHERE f > -1.5;
+
+SELECT count(*) FROM numcmp_test WHERE f > -1.5;
+
+EXPLAIN (COSTS OFF) SELECT * FROM numcmp_test WHERE f <= -498.5;
+
+SELECT count(*) FROM numcmp_test WHERE f <= -498.5;
+
+-- not representable as an integer bound: the cross-type operator is the index qual
+EXPLAIN (COSTS OFF) SELECT * FROM numcmp_test WHERE e = 3.5;
+
+SELECT count(*) FROM numcmp_test WHERE e = 3.5;
+
+EXPLAIN (COSTS OFF) SELECT * FROM numcmp_test WHERE e < 1000000000000000000000000000000.5;
+
+SELECT count(*) FROM numcmp_test WHERE e < 1000000000000000000000000000000.5;
+
+PREPARE numcmp_q(numeric) AS SELECT count(*) FROM numcmp_test WHERE e < $1;
+SET plan_cache_mode = force_generic_plan;
+
+EXPLAIN (COSTS OFF) EXECUTE numcmp_q(10.5);
+
+EXECUTE numcmp_q(10.5);
+
+RESET plan_cache_mode;
+DEALLOCATE numcmp_q;
+
+-- and indexes on numeric columns take integer operands
+CREATE TABLE numcmp_num (n numeric);
+INSERT INTO numcmp_num SELECT i / 4.0 FROM generate_series(1, 1000) i;
+CREATE INDEX ON numcmp_num (n);
+ANALYZE numcmp_num;
+
+EXPLAIN (COSTS OFF) SELECT * FROM numcmp_num WHERE n < '3'::uint8;
+
+SELECT count(*) FROM numcmp_num WHERE n < '3'::uint8;
+
+RESET enable_seqscan;
+RESET enable_bitmapscan;
+DROP TABLE numcmp_ints, numcmp_consts, numcmp_test, numcmp_num;
+DROP FUNCTION numcmp_mismatches(regtype);
@@ -0,0 +1,107 @@
+-- integer to numeric, byte-identical to numeric input of the same text
+SELECT v, v::uint8::numeric, numeric_send(v::uint8::numeric) = numeric_send(v::numeric) AS ok
+FROM (VALUES ('0'), ('1'), ('9999'), ('10000'), ('100000000'),
+             ('9223372036854775807'), ('9223372036854775808'),
+             ('10000000000000000000'), ('18446744073709551615')) _ (v);
+
+SELECT v, v::uint16::numeric, numeric_send(v::uint16::numeric) = numeric_send(v::numeric) AS ok
+FROM (VALUES ('0'), ('1'), ('18446744073709551615'), ('18446744073709551616'),
+             ('10000000000000000000000000000000000000'),
+             ('99999999999999999999999999999999999999'),
+             ('100000000000000000000000000000000000000'),
+             ('170141183460469231731687303715884105728'),
+             ('340282366920938463463374607431768211455')) _ (v);
+
+SELECT v, v::int16::numeric, numeric_send(v::int16::numeric) = numeric_send(v::numeric) AS ok
+FROM (VALUES ('0'), ('-1'), ('-10000'), ('-18446744073709551616'),
+             ('-170141183460469231731687303715884105728'),
+             ('170141183460469231731687303715884105727')) _ (v);
+
+-- results must be usable by numeric arithmetic and output
+SELECT '18446744073709551615'::uint8::numeric + 1,
+       '340282366920938463463374607431768211455'::uint16::numeric * 2,
+       -('-170141183460469231731687303715884105728'::int16::numeric),
+       round('100000000000000000000'::uint16::numeric / 3, 2);
+
+SELECT hash_numeric(v::uint16::numeric) = hash_numeric(v::numeric) AS ok
+FROM (VALUES ('100000000'), ('10000000000000000000000000000000000000')) _ (v);
+
+-- numeric to integer, differential against the previous implementation
+CREATE FUNCTION uint8_from_numeric_ref(numeric) RETURNS uint8
+    IMMUTABLE STRICT LANGUAGE C AS '$libdir/uint', 'uint8_from_numeric_ref';
+CREATE FUNCTION int16_from_numeric_ref(numeric) RETURNS int16
+    IMMUTABLE STRICT LANGUAGE C AS '$libdir/uint', 'int16_from_numeric_ref';
+CREATE FUNCTION uint16_from_numeric_ref(numeric) RETURNS uint16
+    IMMUTABLE STRICT LANGUAGE C AS '$libdir/uint', 'uint16_from_numeric_ref';
+
+CREATE TABLE numeric_values (n numeric);
+INSERT INTO numeric_values
+SELECT g::numeric * 1844674407370955 FROM generate_series(0, 10000) g
+UNION ALL
+SELECT trunc(2::numeric ^ k) + d FROM generate_series(0, 63) k, generate_series(-1, 1) d
+UNION ALL
+SELECT 10::numeric ^ k + d FROM generate_series(0, 19) k, generate_series(-1, 1) d
+UNION ALL
+SELECT 18446744073709551615;
+
+SELECT count(*) FROM numeric_values
+WHERE n BETWEEN 0 AND 18446744073709551615
+  AND n::uint8 IS DISTINCT FROM uint8_from_numeric_ref(n);
+
+SELECT count(*) FROM numeric_values
+WHERE n BETWEEN 0 AND 18446744073709551615
+  AND n::uint8::numeric <> n;
+
+DELETE FROM numeric_values;
+INSERT INTO numeric_values
+SELECT g::numeric * 34028236692093846346337460743176 FROM generate_series(0, 10000) g
+UNION ALL
+SELECT trunc(2::numeric ^ k) + d FROM generate_series(0, 127) k, generate_series(-1, 1) d
+UNION ALL
+SELECT trunc(10::numeric ^ k) + d FROM generate_series(0, 38) k, generate_series(-1, 1) d;
+INSERT INTO numeric_values SELECT -n FROM numeric_values;
+
+SELECT count(*) FROM numeric_values
+WHERE n BETWEEN 0 AND 340282366920938463463374607431768211455
+  AND n::uint16 IS DISTINCT FROM uint16_from_numeric_ref(n);
+
+SELECT count(*) FROM numeric_values
+WHERE n BETWEEN -170141183460469231731687303715884105728
+            AND 170141183460469231731687303715884105727
+  AND n::int16 IS DISTINCT FROM int16_from_numeric_ref(n);
+
+SELECT count(*) FROM numeric_values
+WHERE n BETWEEN -170141183460469231731687303715884105728
+            AND 170141183460469231731687303715884105727
+  AND n::int16::numeric <> n;
+
+DROP TABLE numeric_values;
+DROP FUNCTION uint8_from_numeric_ref(numeric);
+DROP FUNCTION int16_from_numeric_ref(numeric);
+DROP FUNCTION uint16_from_numeric_ref(numeric);
+
+-- rounding is half away from zero, like numeric_int8
+SELECT 1.5::uint8, 2.5::uint8, 0.4999::uint1, (-0.4)::uint4, 2.5::int1, (-2.5)::int1;
+SELECT 18446744073709551614.5::uint8, (-2.5)::int16, 0.00005::uint16;
+SELECT 340282366920938463463374607431768211454.5::uint16;
+
+-- range errors are exact
+SELECT 127::int1, (-128)::int1, 255::uint1, 65535::uint2, 4294967295::uint4;
+SELECT 128::numeric::int1;
+SELECT (-129)::numeric::int1;
+SELECT 256::numeric::uint1;
+SELECT 65536::numeric::uint2;
+SELECT 4294967296::numeric::uint4;
+SELECT (-1)::numeric::uint4;
+SELECT (-0.5)::uint8;
+SELECT 18446744073709551615.5::uint8;
+SELECT 1e30::uint8;
+SELECT 340282366920938463463374607431768211455.5::uint16;
+SELECT 1e40::uint16;
+SELECT (-1)::numeric::uint16;
+SELECT 170141183460469231731687303715884105727::int16,
+       (-170141183460469231731687303715884105728)::int16;
+SELECT 170141183460469231731687303715884105728::int16;
+SELECT (-170141183460469231731687303715884105729)::int16;
+SELECT 'NaN'::numeric::uint8;
+SELECT 'Infinity'::numeric::int16;
@@ -0,0 +1,67 @@
+SELECT '167772160/8'::uint4prefix AS a, '4294967295'::uint4prefix AS b, '0/0'::uint4prefix AS c,
+       '340282366920938463463374607431768211455'::uint16prefix AS d,
+       '170141183460469231731687303715884105728/1'::uint16prefix AS e;
+
+SELECT '167772161/8'::uint4prefix;
+
+SELECT '1/33'::uint4prefix;
+
+SELECT '4294967296/32'::uint4prefix;
+
+SELECT '-1/128'::uint16prefix;
+
+SELECT uint4prefix(167837953, 8) AS masked, masklen('167837952/24'::uint4prefix),
+       lower('167837952/24'::uint4prefix), upper('167837952/24'::uint4prefix),
+       upper(uint16prefix('340282366920938463463374607431768211455', 0)) AS upper16;
+
+SELECT uint4prefix(1, 33);
+
+SELECT a, b, a = b AS eq, a <> b AS ne, a && b AS overlap, a << b AS sub, a <<= b AS subeq, a >> b AS sup, a >>= b AS supeq
+FROM (VALUES ('167772160/8'::uint4prefix, '167772160/8'::uint4prefix),
+             ('167772160/8', '167837952/24'),
+             ('167837952/24', '167772160/8'),
+             ('167837952/24', '167838208/24')) _ (a, b);
+
+SELECT '167772160/8'::uint4prefix >>= '167837953'::uint4 AS supeq, '184549376'::uint4 <<= '167772160/8'::uint4prefix AS subeq;
+
+-- a routing table: 4096 /20 blocks, nested prefixes, and 1000 duplicates
+CREATE TABLE prefix_routes (prefix uint4prefix, hop int);
+INSERT INTO prefix_routes SELECT uint4prefix((i * 4096)::uint4, 20), 20 FROM generate_series(0, 4095) i;
+INSERT INTO prefix_routes VALUES ('0/0', 0), ('167772160/8', 8), ('167837696/16', 16), ('167837952/24', 24), ('167837953/32', 32);
+INSERT INTO prefix_routes SELECT '3221225472/2'::uint4prefix, 2 FROM generate_series(1, 1000);
+CREATE INDEX prefix_routes_spgist ON prefix_routes USING spgist (prefix);
+SET enable_seqscan = off;
+SET enable_bitmapscan = off;
+
+-- longest prefix match
+EXPLAIN (COSTS OFF) SELECT prefix, hop FROM prefix_routes WHERE '167837953'::uint4 <<= prefix ORDER BY masklen(prefix) DESC LIMIT 1;
+
+SELECT a, r.prefix, r.hop
+FROM (VALUES ('5000'::uint4), ('167837953'), ('167837954'), ('167903232'), ('3000000000'), ('3500000000')) _ (a),
+LATERAL (SELECT prefix, hop FROM prefix_routes WHERE prefix >>= a ORDER BY masklen(prefix) DESC LIMIT 1) r;
+
+EXPLAIN (COSTS OFF) SELECT count(*) FROM prefix_routes WHERE prefix <<= '167772160/8';
+
+SELECT q, (SELECT count(*) FROM prefix_routes WHERE prefix && q) AS overlap,
+       (SELECT count(*) FROM prefix_routes WHERE prefix = q) AS eq,
+       (SELECT count(*) FROM prefix_routes WHERE prefix << q) AS sub,
+       (SELECT count(*) FROM prefix_routes WHERE prefix <<= q) AS subeq,
+       (SELECT count(*) FROM prefix_routes WHERE prefix >> q) AS sup,
+       (SELECT count(*) FROM prefix_routes WHERE prefix >>= q) AS supeq
+FROM (VALUES ('0/0'::uint4prefix), ('167772160/8'), ('167837952/24'), ('167837953/32'),
+             ('4096/20'), ('0/12'), ('3221225472/2'), ('3221225472/3')) _ (q);
+
+CREATE TABLE prefix_routes16 (prefix uint16prefix, hop int);
+INSERT INTO prefix_routes16 VALUES ('0/0', 0), ('340282366920938463463374607431768211455/128', 128),
+    ('340282366920938463463374607431768211200/120', 120), ('340282366920938463463374607431768211200/120', 120),
+    ('18446744073709551616/64', 64), ('18446744073709551616/96', 96);
+CREATE INDEX prefix_routes16_spgist ON prefix_routes16 USING spgist (prefix);
+
+SELECT a, r.prefix, r.hop
+FROM (VALUES ('340282366920938463463374607431768211455'::uint16), ('340282366920938463463374607431768211454'),
+             ('18446744073709551617'), ('18446744078004518912'), ('42')) _ (a),
+LATERAL (SELECT prefix, hop FROM prefix_routes16 WHERE prefix >>= a ORDER BY masklen(prefix) DESC LIMIT 1) r;
+
+RESET enable_seqscan;
+RESET enable_bitmapscan;
+DROP TABLE prefix_routes, prefix_routes16;
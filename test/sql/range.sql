@@ -0,0 +1,39 @@
+-- discrete range types are canonicalized to [lower, upper)
+SELECT '(1,5]'::uint4range AS uint4, '[1,5]'::uint8range AS uint8, '(-5,-1]'::int16range AS int16,
+       '(,5]'::uint16range AS uint16, '(3,4)'::uint4range AS empty;
+
+SELECT uint8range(10, 20, '(]'), upper(uint16range('1', '340282366920938463463374607431768211454', '[]'));
+
+SELECT '[1,4294967295]'::uint4range;
+
+SELECT '(18446744073709551615,)'::uint8range;
+
+SELECT '[10,20)'::uint8range @> '15'::uint8 AS contains, '[10,20)'::uint8range && '[20,30)' AS overlaps,
+       '[10,20)'::uint8range -|- '[20,30)' AS adjacent, '[10,20)'::uint8range + '[20,30)' AS union;
+
+-- exclusion constraints combine the GiST opclass of the scalar type with the range type's
+CREATE TABLE range_alloc (pool uint4, block uint8range, EXCLUDE USING gist (pool WITH =, block WITH &&));
+INSERT INTO range_alloc VALUES (1, '[0,100)'), (1, '[100,200)'), (2, '[50,150)');
+
+INSERT INTO range_alloc VALUES (1, '[150,250)');
+
+INSERT INTO range_alloc
+    SELECT 3, uint8range(i::uint8 * 1000000000000000, i::uint8 * 1000000000000000 + 1000)
+    FROM generate_series(1, 10000) i;
+SET enable_seqscan = off;
+SET enable_bitmapscan = off;
+
+EXPLAIN (COSTS OFF) SELECT * FROM range_alloc WHERE block @> '9000000000000000500'::uint8;
+
+SELECT * FROM range_alloc WHERE block @> '9000000000000000500'::uint8;
+
+ALTER TABLE range_alloc DROP CONSTRAINT range_alloc_pool_block_excl;
+CREATE INDEX range_alloc_spgist ON range_alloc USING spgist (block);
+
+EXPLAIN (COSTS OFF) SELECT * FROM range_alloc WHERE block && '[9999999999999999000,)';
+
+SELECT * FROM range_alloc WHERE block && '[9999999999999999000,)';
+
+RESET enable_seqscan;
+RESET enable_bitmapscan;
+DROP TABLE range_alloc;
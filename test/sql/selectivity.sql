@@ -0,0 +1,39 @@
+-- range predicates are estimated by interpolating within the histogram bins
+CREATE FUNCTION sel_check(cond text, OUT actual int, OUT close bool) LANGUAGE plpgsql AS $$
+DECLARE
+    line text;
+    est int;
+BEGIN
+    EXECUTE 'SELECT count(*) FROM sel_test WHERE ' || cond INTO actual;
+    FOR line IN EXECUTE 'EXPLAIN SELECT * FROM sel_test WHERE ' || cond LOOP
+        est := substring(line FROM 'rows=(\d+)')::int;
+        EXIT;
+    END LOOP;
+    close := abs(est - actual) <= 2 + actual / 20;
+END
+$$;
+
+CREATE TABLE sel_test (a int1, b uint1, c uint2, d uint4, e uint8, f int16, g uint16);
+INSERT INTO sel_test
+    SELECT (i % 256 - 128)::int1, (i % 256)::uint1, (i * 6)::uint2, (i * 400000)::uint4,
+           i::uint8 * 1000000000000000, (i - 5000)::int16 * '1267650600228229401496703205376'::int16,
+           i::uint16 << 110
+    FROM generate_series(1, 10000) i;
+ANALYZE sel_test;
+
+SELECT cond, (sel_check(cond)).*
+FROM (VALUES ('a < ''-100''::int1'),
+             ('b >= ''250''::uint1'),
+             ('c < ''180''::uint2'),
+             ('d < ''12000000''::uint4'),
+             ('e < ''30000000000000000''::uint8'),
+             ('e > ''9950000000000000000''::uint8'),
+             ('f < ''-6300223483134300125438614930718720''::int16'),
+             ('f >= ''6287546977132017831423647898664960''::int16'),
+             ('g <= ''38942226439011207213978722469150720''::uint16'),
+             ('d < 12000000'),
+             ('''30000000000000000''::uint8 > e'),
+             ('9900 < c')) _ (cond);
+
+DROP TABLE sel_test;
+DROP FUNCTION sel_check(text);
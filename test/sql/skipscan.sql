@@ -0,0 +1,65 @@
+-- btree skip scan (PostgreSQL 18): a condition on the second column only
+-- is answered by one index search per distinct leading value
+CREATE FUNCTION skip_searches(query text) RETURNS int LANGUAGE plpgsql AS $$
+DECLARE
+    line text;
+BEGIN
+    FOR line IN EXECUTE 'EXPLAIN (ANALYZE, COSTS OFF, TIMING OFF, SUMMARY OFF) ' || query LOOP
+        IF line ~ 'Index Searches' THEN
+            RETURN substring(line FROM 'Index Searches: (\d+)')::int;
+        END IF;
+    END LOOP;
+END
+$$;
+
+CREATE TABLE skip_events (tenant uint2, ts uint8);
+INSERT INTO skip_events SELECT (i % 10)::uint2, (i / 10)::uint8 FROM generate_series(0, 19999) i;
+CREATE INDEX skip_events_tenant_ts ON skip_events (tenant, ts);
+VACUUM ANALYZE skip_events;
+SET enable_seqscan = off;
+SET enable_bitmapscan = off;
+
+EXPLAIN (COSTS OFF) SELECT * FROM skip_events WHERE ts = 1000;
+
+SELECT count(*) FROM skip_events WHERE ts = 1000;
+
+-- a full index scan would take one search, the skip array takes one per tenant
+SELECT skip_searches('SELECT * FROM skip_events WHERE ts = 1000') BETWEEN 2 AND 11 AS skip_array;
+
+-- the increment and decrement functions at the edges of each type
+CREATE TABLE skip_test (a int1, b uint1, c uint2, d uint4, e uint8, f int16, g uint16, ts int4);
+INSERT INTO skip_test
+    SELECT v.*, ts FROM (VALUES
+        ('-128'::int1, '0'::uint1, '0'::uint2, '0'::uint4, '0'::uint8, '-170141183460469231731687303715884105728'::int16, '0'::uint16),
+        ('-127', '1', '1', '1', '1', '-170141183460469231731687303715884105727', '1'),
+        ('126', '254', '65534', '4294967294', '18446744073709551614', '170141183460469231731687303715884105726', '340282366920938463463374607431768211454'),
+        ('127', '255', '65535', '4294967295', '18446744073709551615', '170141183460469231731687303715884105727', '340282366920938463463374607431768211455')) v, generate_series(1, 500) ts;
+CREATE INDEX skip_test_a ON skip_test (a, ts);
+CREATE INDEX skip_test_b ON skip_test (b, ts);
+CREATE INDEX skip_test_c ON skip_test (c, ts);
+CREATE INDEX skip_test_d ON skip_test (d, ts);
+CREATE INDEX skip_test_e ON skip_test (e, ts);
+CREATE INDEX skip_test_f ON skip_test (f, ts);
+CREATE INDEX skip_test_g ON skip_test (g, ts);
+VACUUM ANALYZE skip_test;
+
+SELECT (SELECT array_agg(a) FROM (SELECT a FROM skip_test WHERE ts = 250 ORDER BY a) _) AS a,
+       (SELECT array_agg(b) FROM (SELECT b FROM skip_test WHERE ts = 250 ORDER BY b) _) AS b,
+       (SELECT array_agg(c) FROM (SELECT c FROM skip_test WHERE ts = 250 ORDER BY c) _) AS c,
+       (SELECT array_agg(d) FROM (SELECT d FROM skip_test WHERE ts = 250 ORDER BY d) _) AS d,
+       (SELECT array_agg(e) FROM (SELECT e FROM skip_test WHERE ts = 250 ORDER BY e) _) AS e,
+       (SELECT array_agg(f) FROM (SELECT f FROM skip_test WHERE ts = 250 ORDER BY f) _) AS f,
+       (SELECT array_agg(g) FROM (SELECT g FROM skip_test WHERE ts = 250 ORDER BY g) _) AS g;
+
+SELECT (SELECT array_agg(a) FROM (SELECT a FROM skip_test WHERE ts = 250 ORDER BY a DESC) _) AS a,
+       (SELECT array_agg(b) FROM (SELECT b FROM skip_test WHERE ts = 250 ORDER BY b DESC) _) AS b,
+       (SELECT array_agg(c) FROM (SELECT c FROM skip_test WHERE ts = 250 ORDER BY c DESC) _) AS c,
+       (SELECT array_agg(d) FROM (SELECT d FROM skip_test WHERE ts = 250 ORDER BY d DESC) _) AS d,
+       (SELECT array_agg(e) FROM (SELECT e FROM skip_test WHERE ts = 250 ORDER BY e DESC) _) AS e,
+       (SELECT array_agg(f) FROM (SELECT f FROM skip_test WHERE ts = 250 ORDER BY f DESC) _) AS f,
+       (SELECT array_agg(g) FROM (SELECT g FROM skip_test WHERE ts = 250 ORDER BY g DESC) _) AS g;
+
+RESET enable_seqscan;
+RESET enable_bitmapscan;
+DROP TABLE skip_events, skip_test;
+DROP FUNCTION skip_searches(text);
@@ -0,0 +1,82 @@
+-- abbreviated keys: the high 64 bits decide, ties fall back to the full comparison
+CREATE TABLE sort_test (f int16, h uint16);
+INSERT INTO sort_test
+    SELECT ((i % 5000 - 2500)::numeric * 18446744073709551616 + (i::bigint * 7919) % 100000)::int16,
+           ((i::bigint * 2654435761) % 4294967296)::uint16
+    FROM generate_series(1, 20000) i;
+ANALYZE sort_test;
+
+SELECT count(*) FILTER (WHERE n < prev) AS out_of_order
+FROM (SELECT f::numeric AS n, lag(f::numeric) OVER (ORDER BY f) AS prev FROM sort_test) _;
+SELECT count(*) FILTER (WHERE n > prev) AS out_of_order
+FROM (SELECT f::numeric AS n, lag(f::numeric) OVER (ORDER BY f DESC) AS prev FROM sort_test) _;
+-- every high half is zero, so abbreviation is aborted
+SELECT count(*) FILTER (WHERE n < prev) AS out_of_order
+FROM (SELECT h::numeric AS n, lag(h::numeric) OVER (ORDER BY h) AS prev FROM sort_test) _;
+
+CREATE INDEX sort_test_f ON sort_test (f);
+CREATE INDEX sort_test_h ON sort_test (h);
+SET enable_seqscan = off;
+SET enable_bitmapscan = off;
+SELECT count(*) AS found FROM sort_test t WHERE f = (SELECT f FROM sort_test u WHERE u.f = t.f LIMIT 1);
+SELECT count(*) AS found FROM sort_test t WHERE h = (SELECT h FROM sort_test u WHERE u.h = t.h LIMIT 1);
+RESET enable_seqscan;
+RESET enable_bitmapscan;
+
+DROP TABLE sort_test;
+
+-- pass-by-value types: values with the high bit set, read back from the heap
+CREATE TABLE sort_small (a int1, b uint1, c uint2, d uint4, e uint8);
+INSERT INTO sort_small
+    SELECT (i % 256 - 128)::int1, (i * 7 % 256)::uint1, (i * 7919 % 65536)::uint2,
+           (i::bigint * 2654435761 % 4294967296)::uint4,
+           (i::numeric * 11400714819323198485 % 18446744073709551616)::uint8
+    FROM generate_series(1, 20000) i;
+INSERT INTO sort_small VALUES (NULL, NULL, NULL, NULL, NULL);
+ANALYZE sort_small;
+
+SELECT sum((a::numeric < pa)::int) AS a, sum((b::numeric < pb)::int) AS b, sum((c::numeric < pc)::int) AS c,
+       sum((d::numeric < pd)::int) AS d, sum((e::numeric < pe)::int) AS e
+FROM (SELECT a, lag(a::numeric) OVER (ORDER BY a) AS pa, b, lag(b::numeric) OVER (ORDER BY b) AS pb,
+             c, lag(c::numeric) OVER (ORDER BY c) AS pc, d, lag(d::numeric) OVER (ORDER BY d) AS pd,
+             e, lag(e::numeric) OVER (ORDER BY e) AS pe
+      FROM sort_small) _;
+SELECT sum((a::numeric > pa)::int) AS a, sum((b::numeric > pb)::int) AS b, sum((c::numeric > pc)::int) AS c,
+       sum((d::numeric > pd)::int) AS d, sum((e::numeric > pe)::int) AS e
+FROM (SELECT a, lag(a::numeric) OVER (ORDER BY a DESC) AS pa, b, lag(b::numeric) OVER (ORDER BY b DESC) AS pb,
+             c, lag(c::numeric) OVER (ORDER BY c DESC) AS pc, d, lag(d::numeric) OVER (ORDER BY d DESC) AS pd,
+             e, lag(e::numeric) OVER (ORDER BY e DESC) AS pe
+      FROM sort_small) _;
+-- non-leading keys use the full comparator
+SELECT count(*) FILTER (WHERE (a, d::numeric) < (pa, pd)) AS out_of_order
+FROM (SELECT a, d, lag(a) OVER w AS pa, lag(d::numeric) OVER w AS pd FROM sort_small WINDOW w AS (ORDER BY a, d)) _;
+
+CREATE INDEX sort_small_d ON sort_small (d);
+SET enable_seqscan = off;
+SET enable_bitmapscan = off;
+SELECT count(*) AS found FROM sort_small t WHERE d = (SELECT d FROM sort_small u WHERE u.d = t.d LIMIT 1);
+RESET enable_seqscan;
+RESET enable_bitmapscan;
+
+DROP TABLE sort_small;
+
+-- every btree opclass declares equalimage, so indexes are deduplicated
+SELECT opcname FROM pg_opclass
+WHERE opcmethod = (SELECT oid FROM pg_am WHERE amname = 'btree')
+  AND opcintype::regtype::text IN ('int1', 'uint1', 'uint2', 'uint4', 'uint8', 'int16', 'uint16', 'int16a', 'uint16a')
+  AND NOT EXISTS (SELECT FROM pg_amproc WHERE amprocfamily = opcfamily AND amproclefttype = opcintype
+                  AND amprocrighttype = opcintype AND amprocnum = 4);
+
+CREATE TABLE sort_dedup (a uint1, b uint4, c uint16);
+INSERT INTO sort_dedup SELECT i % 4, i % 10, i % 3 FROM generate_series(1, 50000) i;
+CREATE INDEX sort_dedup_a ON sort_dedup (a);
+CREATE INDEX sort_dedup_b ON sort_dedup (b);
+CREATE INDEX sort_dedup_c ON sort_dedup (c);
+CREATE INDEX sort_dedup_a_off ON sort_dedup (a) WITH (deduplicate_items = off);
+CREATE INDEX sort_dedup_b_off ON sort_dedup (b) WITH (deduplicate_items = off);
+CREATE INDEX sort_dedup_c_off ON sort_dedup (c) WITH (deduplicate_items = off);
+SELECT pg_relation_size('sort_dedup_a') * 2 < pg_relation_size('sort_dedup_a_off') AS uint1,
+       pg_relation_size('sort_dedup_b') * 2 < pg_relation_size('sort_dedup_b_off') AS uint4,
+       pg_relation_size('sort_dedup_c') * 2 < pg_relation_size('sort_dedup_c_off') AS uint16;
+
+DROP TABLE sort_dedup;
@@ -57,3 +57,18 @@ typedef struct {
 	__int128_t	i;
 } xint128;
 #pragma pack(pop)
+
+/*
+ * Called by the generated operators.  Keeping the errors and the
+ * division out of line keeps the operators small enough for the JIT to
+ * inline, and the symbols are exported because inlined code refers to
+ * them from outside the library.
+ */
+extern PGDLLEXPORT void uint_out_of_range_error(void) __attribute__((noreturn, cold));
+extern PGDLLEXPORT void uint_cast_out_of_range_error(const char *typname) __attribute__((noreturn, cold));
+extern PGDLLEXPORT void uint_division_by_zero_error(void) __attribute__((noreturn, cold));
+
+extern PGDLLEXPORT __uint128_t uint128_div(FunctionCallInfo fcinfo, __uint128_t n, __uint128_t d);
+extern PGDLLEXPORT __uint128_t uint128_mod(FunctionCallInfo fcinfo, __uint128_t n, __uint128_t d);
+extern PGDLLEXPORT __int128_t int128_div(FunctionCallInfo fcinfo, __int128_t n, __int128_t d);
+extern PGDLLEXPORT __int128_t int128_mod(FunctionCallInfo fcinfo, __int128_t n, __int128_t d);
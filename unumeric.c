@@ -2,6 +2,9 @@
 #include <fmgr.h>
 #include <utils/fmgrprotos.h>
 #include <utils/memutils.h>
+#if PG_VERSION_NUM >= 160000
+#include <varatt.h>
+#endif
 
 #include "unumeric.h"
 
@@ -150,12 +153,18 @@ numeric_to_int64(Numeric n)
 		numeric_int8, NumericGetDatum(n)));
 }
 
+/*
+ * Reference conversions by way of numeric arithmetic, superseded by the
+ * direct digit readers below; kept for the differential regression test.
+ * Only exact for integral values within range.
+ */
+
 uint64_t
-numeric_to_uint64(Numeric n)
+numeric_to_uint64_ref(Numeric n)
 {
 	uint_init_();
 #ifdef UNDEBUG
-	numeric_log_("numeric_to_uint64(%s)", n);
+	numeric_log_("numeric_to_uint64_ref(%s)", n);
 #endif
 	if (unlikely(!numeric_lt_(n, bit63))) {
 		Numeric high_down = numeric_mul_opt_error(n, bit1_, NULL);
@@ -166,10 +175,10 @@ numeric_to_uint64(Numeric n)
 			(((uint64_t)numeric_to_int64(high_floor))<<1) |
 			numeric_to_int64(low);
 #ifdef UNDEBUG
-		numeric_log_("numeric_to_uint64() high_down=%s", high_down);
-		numeric_log_("numeric_to_uint64() high_floor=%s", high_floor);
-		numeric_log_("numeric_to_uint64() high_up=%s", high_up);
-		numeric_log_("numeric_to_uint64() low=%s", low);
+		numeric_log_("numeric_to_uint64_ref() high_down=%s", high_down);
+		numeric_log_("numeric_to_uint64_ref() high_floor=%s", high_floor);
+		numeric_log_("numeric_to_uint64_ref() high_up=%s", high_up);
+		numeric_log_("numeric_to_uint64_ref() low=%s", low);
 #endif
 		pfree(high_down);
 		pfree(high_floor);
@@ -181,12 +190,12 @@ numeric_to_uint64(Numeric n)
 }
 
 __uint128_t
-numeric_to_uint128(Numeric n)
+numeric_to_uint128_ref(Numeric n)
 {
 	uint_init_();
 #ifdef UNDEBUG
-	numeric_log_("numeric_to_uint128(%s)", n);
-	numeric_log_("numeric_to_uint128() bit63=%s", bit63);
+	numeric_log_("numeric_to_uint128_ref(%s)", n);
+	numeric_log_("numeric_to_uint128_ref() bit63=%s", bit63);
 #endif
 	if (unlikely(!numeric_lt_(n, bit63))) {
 		Numeric high_down = numeric_mul_opt_error(n, bit63_, NULL);
@@ -195,10 +204,10 @@ numeric_to_uint128(Numeric n)
 		Numeric low = numeric_sub_opt_error(n, high_up, NULL);
 		__uint128_t v;
 #ifdef UNDEBUG
-		numeric_log_("numeric_to_uint128() high_down=%s", high_down);
-		numeric_log_("numeric_to_uint128() high_floor=%s", high_floor);
-		numeric_log_("numeric_to_uint128() high_up=%s", high_up);
-		numeric_log_("numeric_to_uint128() low=%s", low);
+		numeric_log_("numeric_to_uint128_ref() high_down=%s", high_down);
+		numeric_log_("numeric_to_uint128_ref() high_floor=%s", high_floor);
+		numeric_log_("numeric_to_uint128_ref() high_up=%s", high_up);
+		numeric_log_("numeric_to_uint128_ref() low=%s", low);
 #endif
 		if (unlikely(!numeric_lt_(high_floor, bit63))) {
 			Numeric hhigh_down = numeric_mul_opt_error(high_floor, bit2_, NULL);
@@ -206,10 +215,10 @@ numeric_to_uint128(Numeric n)
 			Numeric hhigh_up = numeric_mul_opt_error(hhigh_floor, bit2, NULL);
 			Numeric hlow = numeric_sub_opt_error(high_floor, hhigh_up, NULL);
 #ifdef UNDEBUG
-			numeric_log_("numeric_to_uint128() hhigh_down=%s", hhigh_down);
-			numeric_log_("numeric_to_uint128() hhigh_floor=%s", hhigh_floor);
-			numeric_log_("numeric_to_uint128() hhigh_up=%s", hhigh_up);
-			numeric_log_("numeric_to_uint128() hlow=%s", hlow);
+			numeric_log_("numeric_to_uint128_ref() hhigh_down=%s", hhigh_down);
+			numeric_log_("numeric_to_uint128_ref() hhigh_floor=%s", hhigh_floor);
+			numeric_log_("numeric_to_uint128_ref() hhigh_up=%s", hhigh_up);
+			numeric_log_("numeric_to_uint128_ref() hlow=%s", hlow);
 #endif
 			v = (((__uint128_t)numeric_to_int64(hhigh_floor))<<65) |
 				(((__uint128_t)numeric_to_int64(hlow))<<63) |
@@ -227,7 +236,7 @@ numeric_to_uint128(Numeric n)
 		pfree(high_up);
 		pfree(low);
 #ifdef UNDEBUG
-		uint128_log_("numeric_to_uint128() v=%s", v);
+		uint128_log_("numeric_to_uint128_ref() v=%s", v);
 #endif
 		return v;
 	}
@@ -235,79 +244,400 @@ numeric_to_uint128(Numeric n)
 }
 
 __int128_t
-numeric_to_int128(Numeric n)
+numeric_to_int128_ref(Numeric n)
 {
 	uint_init_();
 #ifdef UNDEBUG
-	numeric_log_("numeric_to_int128(%s)", n);
-	numeric_log_("numeric_to_int128() zero=%s", zero);
+	numeric_log_("numeric_to_int128_ref(%s)", n);
+	numeric_log_("numeric_to_int128_ref() zero=%s", zero);
 #endif
 	if (numeric_lt_(n, zero)) {
 		Numeric m = numeric_uminus_(n);
-		__uint128_t v = numeric_to_uint128(m);
+		__uint128_t v = numeric_to_uint128_ref(m);
 #ifdef UNDEBUG
-		numeric_log_("numeric_to_int128() m=%s", m);
+		numeric_log_("numeric_to_int128_ref() m=%s", m);
 #endif
 		pfree(m);
 #ifdef UNDEBUG
-		uint128_log_("numeric_to_int128() v=%s", v);
+		uint128_log_("numeric_to_int128_ref() v=%s", v);
 #endif
 		v = ~v + 1;
 #ifdef UNDEBUG
-		uint128_log_("numeric_to_int128() v=%s", v);
-		int128_log_("numeric_to_int128() (__int128_t)v=%s", v);
+		uint128_log_("numeric_to_int128_ref() v=%s", v);
+		int128_log_("numeric_to_int128_ref() (__int128_t)v=%s", v);
 #endif
 		return v;
 	}
-	return numeric_to_uint128(n);
+	return numeric_to_uint128_ref(n);
+}
+
+/*
+ * Numeric on-disk layout, private to PG numeric.c; mirrored here so that
+ * integers can be written straight into base-NBASE digits without going
+ * through numeric arithmetic.  Only the short header (PG 9.1+) is built,
+ * which is what make_result() would choose for any integer value.
+ */
+typedef int16 NumericDigit;
+
+#define NBASE		10000
+#define DEC_DIGITS	4
+
+#define NUMERIC_SIGN_MASK				0xC000
+#define NUMERIC_NEG						0x4000
+#define NUMERIC_SHORT					0x8000
+#define NUMERIC_SPECIAL					0xC000
+#define NUMERIC_EXT_SIGN_MASK			0xF000
+#define NUMERIC_NAN						0xC000
+#define NUMERIC_PINF					0xD000
+#define NUMERIC_NINF					0xF000
+
+#define NUMERIC_SHORT_SIGN_MASK			0x2000
+#define NUMERIC_SHORT_DSCALE_SHIFT		7
+#define NUMERIC_SHORT_WEIGHT_SIGN_MASK	0x0040
+#define NUMERIC_SHORT_WEIGHT_MASK		0x003F
+
+#define NUMERIC_HDRSZ		(VARHDRSZ + sizeof(uint16) + sizeof(int16))
+#define NUMERIC_HDRSZ_SHORT	(VARHDRSZ + sizeof(uint16))
+
+#define NUMERIC_MIN_SIG_DIGITS		16
+
+/* 128 bits is at most 39 decimal digits, so 10 NBASE digits */
+#define NUMERIC_UINT128_DIGITS 10
+
+static Numeric
+make_numeric_(__uint128_t u, bool neg)
+{
+	NumericDigit digits[NUMERIC_UINT128_DIGITS + 2];
+	NumericDigit *d = digits + sizeof(digits)/sizeof(digits[0]);
+	int ndigits, weight;
+	Numeric result;
+	uint16 *header;
+
+	/* 10^16 per chunk, so only values >= 2^64 need 128-bit division */
+	while (unlikely(u >> 64)) {
+		uint64 chunk = u % 10000000000000000ULL;
+		int i;
+		u /= 10000000000000000ULL;
+		for (i = 0; i < 4; ++i) { *--d = chunk % NBASE; chunk /= NBASE; }
+	}
+	{
+		uint64 v = u;
+		while (v) { *--d = v % NBASE; v /= NBASE; }
+	}
+	while (d < digits + sizeof(digits)/sizeof(digits[0]) && !*d) ++d;
+
+	ndigits = digits + sizeof(digits)/sizeof(digits[0]) - d;
+	weight = ndigits - 1;
+	while (ndigits > 0 && !d[ndigits - 1]) --ndigits;	/* trailing zeroes */
+	if (!ndigits) { weight = 0; neg = false; }
+
+	result = (Numeric)palloc(NUMERIC_HDRSZ_SHORT + ndigits * sizeof(NumericDigit));
+	SET_VARSIZE(result, NUMERIC_HDRSZ_SHORT + ndigits * sizeof(NumericDigit));
+	header = (uint16 *)VARDATA(result);
+	*header = NUMERIC_SHORT | (neg ? NUMERIC_SHORT_SIGN_MASK : 0) |
+		(weight < 0 ? NUMERIC_SHORT_WEIGHT_SIGN_MASK : 0) |
+		(weight & NUMERIC_SHORT_WEIGHT_MASK);
+	memcpy(header + 1, d, ndigits * sizeof(NumericDigit));
+	return result;
+}
+
+/*
+ * The sign, weight and NBASE digits of n; returns the special header bits
+ * for NaN and the infinities, 0 for a plain value.  n must be detoasted.
+ */
+static uint16
+numeric_digits_(Numeric n, bool *neg, int *weight, const NumericDigit **d, int *ndigits)
+{
+	uint16 header = *(uint16 *)VARDATA(n);
+
+	if (likely((header & NUMERIC_SIGN_MASK) == NUMERIC_SHORT)) {
+		*neg = (header & NUMERIC_SHORT_SIGN_MASK) != 0;
+		*weight = ((header & NUMERIC_SHORT_WEIGHT_SIGN_MASK) ? ~NUMERIC_SHORT_WEIGHT_MASK : 0) |
+			(header & NUMERIC_SHORT_WEIGHT_MASK);
+		*d = (const NumericDigit *)((const char *)n + NUMERIC_HDRSZ_SHORT);
+		*ndigits = (VARSIZE(n) - NUMERIC_HDRSZ_SHORT) / sizeof(NumericDigit);
+	} else if (unlikely((header & NUMERIC_SIGN_MASK) == NUMERIC_SPECIAL)) {
+		return header & NUMERIC_EXT_SIGN_MASK;
+	} else {
+		*neg = (header & NUMERIC_SIGN_MASK) == NUMERIC_NEG;
+		*weight = ((const int16 *)VARDATA(n))[1];
+		*d = (const NumericDigit *)((const char *)n + NUMERIC_HDRSZ);
+		*ndigits = (VARSIZE(n) - NUMERIC_HDRSZ) / sizeof(NumericDigit);
+	}
+	return 0;
+}
+
+/*
+ * Read the integer magnitude and sign of n, rounding half away from zero
+ * as numeric_int8() does; returns false if the magnitude does not fit in
+ * 128 bits.  n must be detoasted.
+ */
+static bool
+numeric_magnitude_(Numeric n, const char *typname, __uint128_t *r, bool *neg)
+{
+	const NumericDigit *d;
+	int ndigits, weight, i;
+	uint16 special;
+	__uint128_t v = 0;
+
+	special = numeric_digits_(n, neg, &weight, &d, &ndigits);
+	if (unlikely(special)) {
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg(special == NUMERIC_NAN ?
+						"cannot convert NaN to %s" :
+						"cannot convert infinity to %s", typname)));
+		return false;
+	}
+
+	/* 9 NBASE digits always fit, so only check beyond that */
+	for (i = 0; i <= weight; ++i) {
+		NumericDigit digit = i < ndigits ? d[i] : 0;
+		if (likely(i < 9))
+			v = v * NBASE + digit;
+		else if (__builtin_mul_overflow(v, (__uint128_t)NBASE, &v) ||
+				 __builtin_add_overflow(v, (__uint128_t)digit, &v))
+			return false;
+	}
+	/* round on the first fractional digit */
+	if (weight >= -1 && weight + 1 < ndigits && d[weight + 1] >= NBASE / 2 &&
+		__builtin_add_overflow(v, (__uint128_t)1, &v))
+		return false;
+	if (!v) *neg = false;
+	*r = v;
+	return true;
+}
+
+/*
+ * Split n into its sign, the magnitude of its integer part (truncated)
+ * and whether a fraction is left over, for comparisons against integers.
+ * Infinities and magnitudes of 2^128 and up are NUMERIC_SPLIT_HUGE with
+ * the sign in *neg.  n must be detoasted.
+ */
+numeric_split_result
+numeric_split(Numeric n, bool *neg, __uint128_t *ipart, bool *frac)
+{
+	const NumericDigit *d;
+	int ndigits, weight, i;
+	uint16 special;
+	__uint128_t v = 0;
+
+	special = numeric_digits_(n, neg, &weight, &d, &ndigits);
+	if (unlikely(special)) {
+		*neg = special == NUMERIC_NINF;
+		return special == NUMERIC_NAN ? NUMERIC_SPLIT_NAN : NUMERIC_SPLIT_HUGE;
+	}
+
+	for (i = 0; i <= weight; ++i) {
+		NumericDigit digit = i < ndigits ? d[i] : 0;
+		if (likely(i < 9))
+			v = v * NBASE + digit;
+		else if (__builtin_mul_overflow(v, (__uint128_t)NBASE, &v) ||
+				 __builtin_add_overflow(v, (__uint128_t)digit, &v))
+			return NUMERIC_SPLIT_HUGE;
+	}
+	*frac = false;
+	for (i = Max(weight + 1, 0); i < ndigits; ++i)
+		if (d[i]) { *frac = true; break; }
+	if (!v && !*frac) *neg = false;
+	*ipart = v;
+	return NUMERIC_SPLIT_OK;
+}
+
+static void
+numeric_out_of_range_(const char *typname)
+{
+	ereport(ERROR,
+			(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+			 errmsg("%s out of range", typname)));
+}
+
+int64_t
+numeric_to_int64_range(Numeric n, int64_t min, int64_t max, const char *typname)
+{
+	__uint128_t v;
+	bool neg;
+
+	if (unlikely(!numeric_magnitude_(n, typname, &v, &neg)) ||
+		unlikely(neg ? v > (__uint128_t)-(__int128_t)min : v > (__uint128_t)max))
+		numeric_out_of_range_(typname);
+	return neg ? (int64_t)-(uint64_t)v : (int64_t)v;
+}
+
+uint64_t
+numeric_to_uint64_range(Numeric n, uint64_t min, uint64_t max, const char *typname)
+{
+	__uint128_t v;
+	bool neg;
+
+	if (unlikely(!numeric_magnitude_(n, typname, &v, &neg)) ||
+		unlikely(neg || v < min || v > max))
+		numeric_out_of_range_(typname);
+	return v;
+}
+
+uint64_t
+numeric_to_uint64(Numeric n)
+{
+	return numeric_to_uint64_range(n, 0, PG_UINT64_MAX, "uint8");
+}
+
+__uint128_t
+numeric_to_uint128(Numeric n)
+{
+	__uint128_t v;
+	bool neg;
+
+	if (unlikely(!numeric_magnitude_(n, "uint16", &v, &neg)) || unlikely(neg))
+		numeric_out_of_range_("uint16");
+	return v;
+}
+
+__int128_t
+numeric_to_int128(Numeric n)
+{
+	__uint128_t v;
+	bool neg;
+
+	if (unlikely(!numeric_magnitude_(n, "int16", &v, &neg)) ||
+		unlikely(v > (((__uint128_t)1)<<127) - !neg))
+		numeric_out_of_range_("int16");
+	return neg ? ~v + 1 : v;
 }
 
 Numeric
 uint64_to_numeric(uint64_t u)
 {
-	if (unlikely(u & (1ULL<<63))) {
-		uint_init_();
-		{
-			Numeric intermediate = int64_to_numeric(u & ~(1ULL<<63));
-			Numeric v = numeric_add_opt_error(intermediate, bit63, NULL);
-			pfree(intermediate);
-			return v;
-		}
-	}
-	return int64_to_numeric(u);
+	return make_numeric_(u, false);
 }
 
 Numeric
 uint128_to_numeric(__uint128_t u)
 {
-	if (unlikely(u >= (((__uint128_t)1)<<64))) {
-		uint_init_();
-		{
-			Numeric high = uint64_to_numeric(u>>64);
-			Numeric low = uint64_to_numeric(u);
-			Numeric high_up = numeric_mul_opt_error(high, bit64, NULL);
-			Numeric intermediate = numeric_add_opt_error(high_up, low, NULL);
-			/* flooring is necessary following the multiply, regrettably */
-			Numeric v = numeric_floor_(intermediate);
-			pfree(high);
-			pfree(low);
-			pfree(high_up);
-			pfree(intermediate);
-			return v;
-		}
-	}
-	return uint64_to_numeric(u);
+	return make_numeric_(u, false);
 }
 
 Numeric
 int128_to_numeric(__int128_t u_)
 {
 	__uint128_t u = u_;
-	if (u_ < 0) {
-		Numeric intermediate = uint128_to_numeric(~u + 1);
-		Numeric v = numeric_uminus_(intermediate);
-		pfree(intermediate);
-		return v;
+	if (u_ < 0)
+		return make_numeric_(~u + 1, true);
+	return make_numeric_(u, false);
+}
+
+/*
+ * Multi-precision helpers over little-endian 64-bit limbs, for quotients
+ * wider than 128 bits; 5 limbs (320 bits) is at most 97 decimal digits,
+ * so 25 NBASE digits, rounded up to whole 10^16 chunks
+ */
+#define MP_LIMBS 5
+#define MP_NBASE_DIGITS 28
+
+static void
+mp_mul_small_(uint64 *a, uint64 m)
+{
+	__uint128_t carry = 0;
+	int i;
+	for (i = 0; i < MP_LIMBS; ++i) {
+		carry += (__uint128_t)a[i] * m;
+		a[i] = (uint64)carry;
+		carry >>= 64;
+	}
+}
+
+/* a /= d, returns the remainder */
+static uint64
+mp_div_small_(uint64 *a, int n, uint64 d)
+{
+	__uint128_t rem = 0;
+	int i;
+	for (i = n - 1; i >= 0; --i) {
+		rem = rem << 64 | a[i];
+		a[i] = (uint64)(rem / d);
+		rem %= d;
+	}
+	return (uint64)rem;
+}
+
+/* destructively write a as NBASE digits ending at end; returns the
+ * number of significant digits */
+static int
+mp_to_nbase_(uint64 *a, NumericDigit *end)
+{
+	NumericDigit *d = end;
+	int n = MP_LIMBS;
+
+	while (n > 0 && !a[n - 1]) --n;
+	while (n > 0) {
+		uint64 chunk = mp_div_small_(a, n, 10000000000000000ULL);
+		int i;
+		for (i = 0; i < 4; ++i) { *--d = chunk % NBASE; chunk /= NBASE; }
+		while (n > 0 && !a[n - 1]) --n;
 	}
-	return uint128_to_numeric(u);
+	while (d < end && !*d) ++d;
+	return end - d;
+}
+
+static uint64
+pow10_(int n)
+{
+	uint64 p = 1;
+	while (n-- > 0) p *= 10;
+	return p;
+}
+
+/*
+ * (hi:lo)/count as numeric, with the same result scale and rounding as
+ * numeric_div() of the two values (see select_div_scale() in numeric.c),
+ * but computed exactly in integer arithmetic; the result scale is at most
+ * 36 and the weight within [-6, 14], so the short header always applies
+ */
+Numeric
+avg_to_numeric(__uint128_t lo, uint64_t hi, bool neg, uint64_t count)
+{
+	uint64 a[MP_LIMBS];
+	NumericDigit digits[MP_NBASE_DIGITS];
+	NumericDigit *end = digits + MP_NBASE_DIGITS;
+	NumericDigit *d;
+	int ndigits, weight, weight1, weight2, firstdigit1, qweight, rscale, pad, i;
+	uint64 c, rem;
+	Numeric result;
+	uint16 *header;
+
+	/* select_div_scale() */
+	a[0] = (uint64)lo; a[1] = (uint64)(lo >> 64); a[2] = hi; a[3] = a[4] = 0;
+	ndigits = mp_to_nbase_(a, end);
+	weight1 = ndigits ? ndigits - 1 : 0;
+	firstdigit1 = ndigits ? end[-ndigits] : 0;
+	for (weight2 = 0, c = count; c >= NBASE; c /= NBASE) ++weight2;
+	qweight = weight1 - weight2 - (firstdigit1 <= (int)c);
+	rscale = Max(NUMERIC_MIN_SIG_DIGITS - qweight * DEC_DIGITS, 0);
+
+	/* a = round(|sum| * 10^rscale / count), half away from zero */
+	a[0] = (uint64)lo; a[1] = (uint64)(lo >> 64); a[2] = hi; a[3] = a[4] = 0;
+	for (i = rscale; i > 0; i -= 19)
+		mp_mul_small_(a, pow10_(Min(i, 19)));
+	rem = mp_div_small_(a, MP_LIMBS, count);
+	if (rem >= count - rem)
+		for (i = 0; i < MP_LIMBS && !++a[i]; ++i);
+
+	/* align the fraction to whole NBASE digits */
+	pad = (DEC_DIGITS - rscale % DEC_DIGITS) % DEC_DIGITS;
+	mp_mul_small_(a, pow10_(pad));
+	ndigits = mp_to_nbase_(a, end);
+	d = end - ndigits;
+	weight = ndigits - 1 - (rscale + pad) / DEC_DIGITS;
+	while (ndigits > 0 && !d[ndigits - 1]) --ndigits;	/* trailing zeroes */
+	if (!ndigits) { weight = 0; neg = false; }
+
+	result = (Numeric)palloc(NUMERIC_HDRSZ_SHORT + ndigits * sizeof(NumericDigit));
+	SET_VARSIZE(result, NUMERIC_HDRSZ_SHORT + ndigits * sizeof(NumericDigit));
+	header = (uint16 *)VARDATA(result);
+	*header = NUMERIC_SHORT | (neg ? NUMERIC_SHORT_SIGN_MASK : 0) |
+		(rscale << NUMERIC_SHORT_DSCALE_SHIFT) |
+		(weight < 0 ? NUMERIC_SHORT_WEIGHT_SIGN_MASK : 0) |
+		(weight & NUMERIC_SHORT_WEIGHT_MASK);
+	memcpy(header + 1, d, ndigits * sizeof(NumericDigit));
+	return result;
 }
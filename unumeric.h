@@ -2,22 +2,46 @@
 
 int64_t numeric_to_int64(Numeric n);
 
-uint64_t numeric_to_uint64(Numeric n);
+int64_t numeric_to_int64_range(Numeric n, int64_t min, int64_t max,
+							   const char *typname);
+
+uint64_t numeric_to_uint64_range(Numeric n, uint64_t min, uint64_t max,
+								 const char *typname);
 
-__uint128_t numeric_to_uint128_(Numeric n, Numeric bit63);
+uint64_t numeric_to_uint64(Numeric n);
 
 __uint128_t numeric_to_uint128(Numeric n);
 
-Numeric numeric_neg(Numeric v);
+__int128_t numeric_to_int128(Numeric n);
 
-__int128_t numeric_to_int128_(Numeric n, Numeric zero, Numeric bit63);
+uint64_t numeric_to_uint64_ref(Numeric n);
 
-__int128_t numeric_to_int128(Numeric n);
+__uint128_t numeric_to_uint128_ref(Numeric n);
 
-Numeric uint64_to_numeric_(uint64_t u, Numeric bit63);
+__int128_t numeric_to_int128_ref(Numeric n);
 
 Numeric uint64_to_numeric(uint64_t u);
 
 Numeric uint128_to_numeric(__uint128_t u);
 
 Numeric int128_to_numeric(__int128_t u_);
+
+typedef enum
+{
+	NUMERIC_SPLIT_OK,
+	NUMERIC_SPLIT_HUGE,			/* infinite, or 2^128 and up */
+	NUMERIC_SPLIT_NAN
+} numeric_split_result;
+
+numeric_split_result numeric_split(Numeric n, bool *neg, __uint128_t *ipart,
+								   bool *frac);
+
+extern PGDLLEXPORT int uint128_numeric_cmp(__uint128_t u, Numeric n);
+
+extern PGDLLEXPORT int int128_numeric_cmp(__int128_t i, Numeric n);
+
+extern PGDLLEXPORT int uint128_float8_cmp(__uint128_t u, float8 d);
+
+extern PGDLLEXPORT int int128_float8_cmp(__int128_t i, float8 d);
+
+Numeric avg_to_numeric(__uint128_t lo, uint64_t hi, bool neg, uint64_t count);